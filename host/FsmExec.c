@@ -0,0 +1,396 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  FsmExec.c
+
+@brief  @b Description: @n
+   Work-stealing executor for independent QFsm streams (see FsmExec.h).
+
+   Each worker owns a Chase-Lev deque of stream pointers. The owner pushes
+   and pops at the bottom without locks; thieves take from the top with a
+   single CAS. Each stream is in at most one deque, so a deque never holds
+   more than numStreams entries and is allocated at that size up front.
+
+   Built with GCC atomics and pthreads, host only.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FsmExec.h"
+
+//====================================================================
+// Chase-Lev deque, top and bottom on separate cache lines
+//
+typedef struct FsmDequeTag
+{
+   int64_t volatile top;
+   uint8_t          pad0[FSMEXEC_CACHE_LINE - sizeof(int64_t)];
+   int64_t volatile bottom;
+   uint8_t          pad1[FSMEXEC_CACHE_LINE - sizeof(int64_t)];
+   FsmStream      **buf;
+   int64_t          mask;
+
+} FsmDeque;
+
+typedef struct FsmWorkerTag
+{
+   pthread_t     thread;
+   uint32_t      id;
+   uint32_t      rnd;      // xorshift state for victim selection
+   FsmExecStats *stats;
+
+} FsmWorker;
+
+static FsmDeque        *deques;
+static FsmWorker       *workers;
+static uint32_t         numDeques;
+static uint32_t         execQuantum;
+static int64_t volatile remaining;  // streams not yet finished
+
+#define FSM_STEAL_ABORT ((FsmStream *)1)
+
+static void dequePush(FsmDeque *d, FsmStream *s)
+{
+   int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+
+   __atomic_store_n(&d->buf[b & d->mask], s, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+   __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+static FsmStream *dequePop(FsmDeque *d)
+{
+   int64_t    b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+   int64_t    t;
+   FsmStream *s = NULL;
+
+   __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+   if(t <= b)
+   {
+      s = __atomic_load_n(&d->buf[b & d->mask], __ATOMIC_RELAXED);
+      if(t == b)
+      {
+         // Last entry, race against thieves for it
+         if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+         {
+            s = NULL;
+         }
+         __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+      }
+   }
+   else
+   {
+      __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+   }
+   return s;
+}
+
+static FsmStream *dequeSteal(FsmDeque *d)
+{
+   int64_t    t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+   int64_t    b;
+   FsmStream *s;
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+
+   if(t >= b)
+   {
+      return NULL;
+   }
+   s = __atomic_load_n(&d->buf[t & d->mask], __ATOMIC_RELAXED);
+   if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+   {
+      return FSM_STEAL_ABORT;
+   }
+   return s;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: stealAny
+@endinternal
+
+@b Description: @n
+    Makes one pass over the other workers starting at a random victim and
+    returns the first stream taken, or NULL.
+
+*******************************************************************************/
+static FsmStream *stealAny(FsmWorker *w)
+{
+   uint32_t i;
+   uint32_t victim;
+
+   w->rnd ^= w->rnd << 13;
+   w->rnd ^= w->rnd >> 17;
+   w->rnd ^= w->rnd << 5;
+   victim = w->rnd % numDeques;
+
+   for(i = 0; i < numDeques; i++, victim = (victim + 1) % numDeques)
+   {
+      FsmStream *s;
+
+      if(victim == w->id)
+      {
+         continue;
+      }
+      s = dequeSteal(&deques[victim]);
+      if((s != NULL) && (s != FSM_STEAL_ABORT))
+      {
+         w->stats->steals++;
+         return s;
+      }
+      w->stats->stealFails++;
+   }
+   return NULL;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: runQuantum
+@endinternal
+
+@b Description: @n
+    Dispatches up to one quantum of the stream's events. Returns non-zero
+    when the stream has been fully consumed.
+
+*******************************************************************************/
+static int runQuantum(FsmWorker *w, FsmStream *s)
+{
+   uint32_t n = s->numEvents - s->next;
+
+   if(n > execQuantum)
+   {
+      n = execQuantum;
+   }
+   if((s->lastWorker >= 0) && ((uint32_t)s->lastWorker != w->id))
+   {
+      w->stats->migrations++;
+   }
+   s->lastWorker = (int32_t)w->id;
+
+   QFsm_dispatchN(s->fsm,
+                  (QEvt const *)((uint8_t const *)s->events
+                                 + (size_t)s->next * s->stride),
+                  n, s->stride);
+   s->next += n;
+
+   w->stats->events += n;
+   w->stats->quanta++;
+
+   return (s->next == s->numEvents);
+}
+
+static void *workerMain(void *arg)
+{
+   FsmWorker *w   = (FsmWorker *)arg;
+   FsmDeque  *own = &deques[w->id];
+
+   for(;;)
+   {
+      FsmStream *s = dequePop(own);
+
+      if(s == NULL)
+      {
+         if(__atomic_load_n(&remaining, __ATOMIC_ACQUIRE) == 0)
+         {
+            break;
+         }
+         s = stealAny(w);
+         if(s == NULL)
+         {
+            sched_yield();
+            continue;
+         }
+      }
+
+      if(runQuantum(w, s))
+      {
+         w->stats->finished++;
+         __atomic_sub_fetch(&remaining, 1, __ATOMIC_RELEASE);
+      }
+      else
+      {
+         dequePush(own, s);
+      }
+   }
+   return NULL;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: FsmExec_run
+@endinternal
+
+@b Parameter: @n
+@b   Input:   streams    - streams to run, state machines already initialized @n
+@b   Input:   numStreams - number of streams  @n
+@b   Input:   numWorkers - worker threads, 1..FSMEXEC_MAX_WORKERS  @n
+@b   Input:   quantum    - events dispatched per turn of a stream  @n
+@b   Output:  report     - timing and per worker counters  @n
+@b   Returns: (int)      - 0 on success, -1 on bad arguments or thread errors  @n
+
+@b Description: @n
+    Spreads the streams round-robin over the workers and runs until every
+    stream has been consumed. Blocks the caller.
+
+*******************************************************************************/
+int FsmExec_run(FsmStream *streams, uint32_t numStreams,
+                uint32_t numWorkers, uint32_t quantum,
+                FsmExecReport *report)
+{
+   struct timespec t0;
+   struct timespec t1;
+   uint64_t        cap = 1;
+   uint32_t        i;
+   int             rc = 0;
+
+   if((numWorkers == 0) || (numWorkers > FSMEXEC_MAX_WORKERS) || (quantum == 0))
+   {
+      return -1;
+   }
+   while(cap < numStreams)
+   {
+      cap <<= 1;
+   }
+
+   memset(report, 0, sizeof(*report));
+   report->numWorkers = numWorkers;
+   report->quantum    = quantum;
+
+   deques  = calloc(numWorkers, sizeof(FsmDeque));
+   workers = calloc(numWorkers, sizeof(FsmWorker));
+   if((deques == NULL) || (workers == NULL))
+   {
+      free(deques);
+      free(workers);
+      return -1;
+   }
+   numDeques   = numWorkers;
+   execQuantum = quantum;
+   remaining   = 0;
+
+   for(i = 0; i < numWorkers; i++)
+   {
+      deques[i].buf  = malloc(cap * sizeof(FsmStream *));
+      deques[i].mask = (int64_t)cap - 1;
+      if(deques[i].buf == NULL)
+      {
+         rc = -1;
+      }
+      workers[i].id    = i;
+      workers[i].rnd   = 2463534242u + i*7919u;
+      workers[i].stats = &report->worker[i];
+   }
+
+   if(rc == 0)
+   {
+      for(i = 0; i < numStreams; i++)
+      {
+         streams[i].next       = 0;
+         streams[i].lastWorker = -1;
+         if(streams[i].numEvents != 0)
+         {
+            dequePush(&deques[i % numWorkers], &streams[i]);
+            remaining++;
+         }
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      for(i = 0; i < numWorkers; i++)
+      {
+         if(pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0)
+         {
+            // Workers already started finish the remaining streams
+            rc = -1;
+            break;
+         }
+      }
+      while(i-- > 0)
+      {
+         pthread_join(workers[i].thread, NULL);
+      }
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+
+      report->seconds = (double)(t1.tv_sec - t0.tv_sec)
+                      + (double)(t1.tv_nsec - t0.tv_nsec)*1e-9;
+   }
+
+   for(i = 0; i < numWorkers; i++)
+   {
+      free(deques[i].buf);
+   }
+   free(deques);
+   free(workers);
+   deques  = NULL;
+   workers = NULL;
+
+   return rc;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: FsmExec_print
+@endinternal
+
+@b Description: @n
+    Prints throughput and the per worker load, steal and migration counts.
+
+*******************************************************************************/
+void FsmExec_print(FILE *out, const FsmExecReport *report)
+{
+   FsmExecStats total;
+   uint32_t     i;
+
+   memset(&total, 0, sizeof(total));
+
+   fprintf(out, "worker      events     quanta   steals  fails  migrations  streams\n");
+   for(i = 0; i < report->numWorkers; i++)
+   {
+      const FsmExecStats *s = &report->worker[i];
+
+      fprintf(out, "%6u %11llu %10llu %8llu %6llu %11llu %8llu\n", i,
+              (unsigned long long)s->events, (unsigned long long)s->quanta,
+              (unsigned long long)s->steals, (unsigned long long)s->stealFails,
+              (unsigned long long)s->migrations, (unsigned long long)s->finished);
+      total.events     += s->events;
+      total.quanta     += s->quanta;
+      total.steals     += s->steals;
+      total.stealFails += s->stealFails;
+      total.migrations += s->migrations;
+      total.finished   += s->finished;
+   }
+   fprintf(out, " total %11llu %10llu %8llu %6llu %11llu %8llu\n",
+           (unsigned long long)total.events, (unsigned long long)total.quanta,
+           (unsigned long long)total.steals, (unsigned long long)total.stealFails,
+           (unsigned long long)total.migrations, (unsigned long long)total.finished);
+
+   fprintf(out, "%u workers, quantum %u, %.3f s, %.0f events/s (%.0f per worker)\n",
+           report->numWorkers, report->quantum, report->seconds,
+           (report->seconds > 0.0) ? (double)total.events/report->seconds : 0.0,
+           (report->seconds > 0.0) ? (double)total.events/report->seconds/report->numWorkers : 0.0);
+}
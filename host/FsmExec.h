@@ -0,0 +1,90 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  FsmExec.h
+
+@brief  @b Description: @n
+   Host-only work-stealing executor that drives many independent QFsm
+   instances, each fed from its own recorded event stream, across a pool of
+   worker threads.
+
+   Every stream lives in exactly one worker deque, or is being run by exactly
+   one worker, so a state machine is never dispatched on two threads at once.
+   A worker takes a stream, dispatches up to a quantum of its events with
+   QFsm_dispatchN and pushes it back on its own deque. Idle workers steal
+   from the top of a random victim's deque, which is how streams migrate
+   between cores.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#ifndef FSMEXEC_H
+#define FSMEXEC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "qep_port.h"
+
+#define FSMEXEC_MAX_WORKERS   128
+#define FSMEXEC_CACHE_LINE     64
+
+//====================================================================
+// One state machine and the recorded events to be dispatched to it
+//
+typedef struct FsmStreamTag
+{
+   QFsm       *fsm;        // initialized state machine fed by this stream
+   const QEvt *events;     // first event of the recording
+   uint32_t    stride;     // bytes between consecutive events
+   uint32_t    numEvents;  // events in the recording
+
+   // Owned by the worker currently running the stream
+   uint32_t    next;       // index of the next event to dispatch
+   int32_t     lastWorker; // worker that ran the previous quantum, -1 if none
+
+} FsmStream;
+
+//====================================================================
+// Per worker counters, padded so workers never share a cache line
+//
+typedef struct FsmExecStatsTag
+{
+   uint64_t events;      // events dispatched
+   uint64_t quanta;      // quanta run
+   uint64_t steals;      // streams taken from another worker
+   uint64_t stealFails;  // steal attempts that found nothing or lost a race
+   uint64_t migrations;  // quanta run on a different worker than the last
+   uint64_t finished;    // streams completed
+
+   uint8_t  pad[FSMEXEC_CACHE_LINE - 6*sizeof(uint64_t)];
+
+} FsmExecStats;
+
+typedef struct FsmExecReportTag
+{
+   uint32_t     numWorkers;
+   uint32_t     quantum;
+   double       seconds;  // wall time of FsmExec_run
+   FsmExecStats worker[FSMEXEC_MAX_WORKERS];
+
+} FsmExecReport;
+
+//
+// PUBLIC FUNCTION PROTOTYPE
+//
+int  FsmExec_run(FsmStream *streams, uint32_t numStreams,
+                 uint32_t numWorkers, uint32_t quantum,
+                 FsmExecReport *report);
+void FsmExec_print(FILE *out, const FsmExecReport *report);
+
+#endif // FSMEXEC_H
@@ -0,0 +1,466 @@
+// Host checks and benchmarks of the disc physics in src/disc_physics.c.
+//
+// Build:
+//   cc -O2 -std=gnu99 -DDISC_PHYSICS_REFERENCE -Isrc -o disc_bench
+//     host/disc_bench.c src/disc_physics.c -lm
+//
+// Run:
+//   ./disc_bench [suite...]
+//
+// With no arguments every suite runs. The exit status is non zero when a
+// check fails.
+//
+// ref: steps the fixed point discs and the double model ref_disc_* through
+// the same accelerometer traces and reports the largest position error,
+// for traces that keep the discs off the walls and for traces that press
+// them into a corner and pull them off it.
+//
+// scale: times a step of accel and integration over all discs as arrays
+// and as the former array of Disc structs doing the same arithmetic, per
+// disc, checks that both end in the same state and checks the step against
+// the ACCEL_STEP_MS budget of 50 ms. NUM_DISCS is fixed at build time, so
+// the scaling takes one build per count:
+//   for n in 20 200 2000 20000 100000; do
+//     cc -O2 -std=gnu99 -DDISC_PHYSICS_REFERENCE -DNUM_DISCS=$n -Isrc
+//       -o disc_bench host/disc_bench.c src/disc_physics.c -lm &&
+//     ./disc_bench scale; done
+// The budget is checked against host time, build with -DSTEP_BUDGET_NS=n
+// to check a tighter one.
+//
+// broad: steps the discs with collisions in the watch window and reports
+// the pair tests of the grid per step against the n(n-1)/2 of brute force,
+// and the time of discs_collide against the distance test alone over all
+// pairs. The collide time includes the response to every overlap, so the
+// all pairs time is a lower bound of brute force, not its cost. The
+// full step is checked against the same budget, and the suite fails if a
+// disc a collision pushed past a wall is left there by the next update. Run it over the same
+// build loop, with counts the window can hold, e.g. 20 50 100 200.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "disc_physics.h"
+
+#ifndef DISC_PHYSICS_REFERENCE
+#error "Build with -DDISC_PHYSICS_REFERENCE"
+#endif
+
+#define WINDOW_W 144
+#define WINDOW_H 168
+
+#define REF_STEPS 10000
+// Largest position error allowed against the double model, in pixels. A
+// bounce depends on which side of the wall a disc is at the end of a step,
+// so a rounding difference can put the bounces of the two models one step
+// apart, and they part by about the speed of the disc until the next
+// contact. The wall traces keep the contacts slow enough for that to stay
+// within REF_WALL_MAX_ERR; a disc thrown across the window at several
+// pixels a step would not.
+#define REF_MAX_ERR (1.0 / 64)
+#define REF_WALL_MAX_ERR 1.0
+
+// Disc steps per timed run, spread over fewer steps as the count grows
+#define SCALE_DISC_STEPS 4000000
+#define SCALE_MIN_STEPS 20
+// Tilts computed ahead of the timed loops, which cycle through them
+#define SCALE_TILTS 1024
+#define BENCH_RUNS 5
+
+// Steps to let the discs settle into a pile, then steps timed
+#define BROAD_SETTLE_STEPS 200
+#define BROAD_STEPS 200
+
+// ACCEL_STEP_MS in src/feature_accel_discs.c
+#ifndef STEP_BUDGET_NS
+#define STEP_BUDGET_NS 50000000ULL
+#endif
+
+typedef struct BenchSuite {
+  const char *name;
+  int (*run)(void);
+} BenchSuite;
+
+// Tilt on one axis per step: +a for a quarter period, -a for half of it and
+// +a again. The velocity comes back to zero every period and averages zero
+// over it, so discs started in the middle swing around where they started
+// and stay off the walls for as long as the trace runs. Discs started in
+// the bottom right corner get a constant tilt into it on top, they are
+// pressed into the corner and, with a swing larger than the constant tilt,
+// pulled off the walls and back every period. The walls take momentum out
+// at every bounce, without the constant tilt the discs would drift off
+// and be thrown across the window.
+static int16_t ref_tilt(int step, int period, int16_t a) {
+  const int phase = step % period;
+  return (phase < period / 4 || phase >= 3 * period / 4) ? a : -a;
+}
+
+typedef struct RefTrace {
+  int16_t accel;
+  int period;
+  int16_t press; // constant tilt into the corner, the discs start there
+} RefTrace;
+
+static DiscSet s_set;
+static RefDisc s_ref[NUM_DISCS];
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Tilt that keeps the discs moving and bouncing, the same for every suite
+static void bench_tilt(int step, int16_t *ax, int16_t *ay) {
+  *ax = (int16_t)(600 * sin(step * 0.07));
+  *ay = (int16_t)(600 * cos(step * 0.05));
+}
+
+// Discs spread over the window at pseudo random places
+static void bench_discs_init(void) {
+  uint32_t seed = 12345;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const fixed_t radius = FX_FROM_INT(3) + (i % 20) * FX_HALF;
+    const int r = FX_TO_INT(radius) + 1;
+    seed = seed * 1103515245 + 12345;
+    const int16_t x = r + (seed >> 16) % (WINDOW_W - 2 * r);
+    seed = seed * 1103515245 + 12345;
+    const int16_t y = r + (seed >> 16) % (WINDOW_H - 2 * r);
+    disc_init(&s_set, i, radius, x, y);
+  }
+}
+
+static int bench_ref(void) {
+  // Discs are stepped without collisions, which the double model does not
+  // have. The traces from the middle are checked against the tight bound
+  // and fail if they reach a wall, the ones from the corner against the
+  // wall bound.
+  static const RefTrace s_traces[] = {
+    { 20, 40, 0 },
+    { 40, 24, 0 },
+    { 50, 40, 0 },
+    { 20, 16, 10 },
+    { 40, 12, 10 },
+    { 40, 16, 20 },
+    { 100, 16, 80 },
+  };
+  int failed = 0;
+
+  printf("ref: %d steps, %d discs, bound %.4f px, %.4f px through walls\n",
+      REF_STEPS, NUM_DISCS, REF_MAX_ERR, REF_WALL_MAX_ERR);
+  for (unsigned t = 0; t < sizeof(s_traces) / sizeof(s_traces[0]); t++) {
+    const RefTrace *trace = &s_traces[t];
+    for (int i = 0; i < NUM_DISCS; i++) {
+      const fixed_t radius = FX_FROM_INT(3) + (i % 20) * FX_HALF;
+      disc_init(&s_set, i, radius, WINDOW_W / 2, WINDOW_H / 2);
+      ref_disc_init(&s_ref[i], radius / (double)FX_ONE, WINDOW_W, WINDOW_H);
+      if (trace->press) {
+        s_set.pos_x[i] = FX_FROM_INT(WINDOW_W) - radius;
+        s_set.pos_y[i] = FX_FROM_INT(WINDOW_H) - radius;
+        s_ref[i].pos.x = s_set.pos_x[i] / (double)FX_ONE;
+        s_ref[i].pos.y = s_set.pos_y[i] / (double)FX_ONE;
+      }
+    }
+
+    double max_err = 0.0;
+    int max_err_step = 0;
+    bool wall = false;
+    double max_out = 0.0;
+    for (int k = 0; k < REF_STEPS; k++) {
+      const int16_t ax = trace->press + ref_tilt(k, trace->period, trace->accel);
+      const int16_t ay = -trace->press + ref_tilt(k, trace->period * 3 / 2, -trace->accel);
+      discs_apply_accel(&s_set, ax, ay, FX_ONE);
+      discs_update(&s_set, WINDOW_W, WINDOW_H, FX_ONE);
+      for (int i = 0; i < NUM_DISCS; i++) {
+        RefDisc *ref = &s_ref[i];
+        ref_disc_apply_accel(ref, ax, ay);
+        ref_disc_update(ref, WINDOW_W, WINDOW_H);
+        if (ref->pos.x < ref->radius || ref->pos.x > WINDOW_W - ref->radius
+            || ref->pos.y < ref->radius || ref->pos.y > WINDOW_H - ref->radius) {
+          wall = true;
+        }
+        // Distance from the nearer of the corner walls
+        const double out = fmin(WINDOW_W - ref->radius - ref->pos.x,
+            WINDOW_H - ref->radius - ref->pos.y);
+        max_out = out > max_out ? out : max_out;
+        const double ex = fabs(s_set.pos_x[i] / (double)FX_ONE - ref->pos.x);
+        const double ey = fabs(s_set.pos_y[i] / (double)FX_ONE - ref->pos.y);
+        const double err = ex > ey ? ex : ey;
+        if (err > max_err) {
+          max_err = err;
+          max_err_step = k;
+        }
+      }
+    }
+
+    const double bound = trace->press ? REF_WALL_MAX_ERR : REF_MAX_ERR;
+    const bool ok = wall == (trace->press != 0) && max_err <= bound;
+    printf("  tilt %3d mg period %2d", trace->accel, trace->period);
+    if (trace->press) {
+      printf(" press %2d mg: max error %.4f px at step %d, up to %.1f px off the walls",
+          trace->press, max_err, max_err_step, max_out);
+    } else {
+      printf(": max error %.4f px at step %d, %s", max_err, max_err_step,
+          wall ? "reaches a wall" : "off the walls");
+    }
+    printf(" %s\n", ok ? "ok" : "FAIL");
+    failed |= !ok;
+  }
+  return failed;
+}
+
+// The discs as the array of structs they were before they moved to
+// separate arrays, kept as the baseline of the scale suite. The step does
+// the same arithmetic as discs_apply_accel and discs_update, so only the
+// layout differs.
+typedef struct FxVec2 {
+  fixed_t x;
+  fixed_t y;
+} FxVec2;
+
+typedef struct Disc {
+  FxVec2 pos;
+  FxVec2 vel;
+  int32_t inv_mass;
+  fixed_t radius;
+} Disc;
+
+static Disc s_aos[NUM_DISCS];
+
+// Force of a step reduced as discs_apply_accel does, with the shift of its
+// product with 1/mass
+typedef struct AosForce {
+  int32_t force;
+  int shift;
+  int32_t round;
+} AosForce;
+
+static AosForce aos_force(int32_t force) {
+  const int32_t mag = force < 0 ? -force : force;
+  AosForce f = { force, FX_INV_SHIFT, 0 };
+  int reduce = 0;
+  while ((mag >> reduce) >= (1 << 14)) {
+    reduce++;
+  }
+  if (reduce) {
+    const int32_t reduced = (mag + (1 << (reduce - 1))) >> reduce;
+    f.force = force < 0 ? -reduced : reduced;
+  }
+  f.shift -= reduce;
+  f.round = (int32_t)1 << (f.shift - 1);
+  return f;
+}
+
+static void aos_disc_apply_accel(Disc *disc, const AosForce *fx, const AosForce *fy) {
+  disc->vel.x += (fx->force * disc->inv_mass + fx->round) >> fx->shift;
+  disc->vel.y += (fy->force * disc->inv_mass + fy->round) >> fy->shift;
+}
+
+static void aos_axis_update(fixed_t *pos, fixed_t *vel, fixed_t radius, fixed_t limit) {
+  const fixed_t lo = radius;
+  const fixed_t hi = limit - radius;
+  const fixed_t p = *pos;
+  const fixed_t v = *vel;
+  const int hit = ((p < lo) & (v < 0)) | ((p > hi) & (v > 0));
+  const fixed_t nv = hit ? -v / 2 : v;
+  const fixed_t np = p < lo ? lo : (p > hi ? hi : p);
+  *vel = nv;
+  *pos = np + FX_MUL(nv, FX_ONE);
+}
+
+static void aos_disc_update(Disc *disc, int16_t w, int16_t h) {
+  aos_axis_update(&disc->pos.x, &disc->vel.x, disc->radius, FX_FROM_INT(w));
+  aos_axis_update(&disc->pos.y, &disc->vel.y, disc->radius, FX_FROM_INT(h));
+}
+
+static int bench_scale(void) {
+  // Both forms start from the same discs and see the same tilt. Collisions
+  // are left out, the broad suite times them.
+  static int16_t s_tilt[SCALE_TILTS][2];
+  int steps = SCALE_DISC_STEPS / NUM_DISCS;
+  if (steps < SCALE_MIN_STEPS) {
+    steps = SCALE_MIN_STEPS;
+  }
+  uint64_t best_soa = UINT64_MAX, best_aos = UINT64_MAX;
+
+  for (int k = 0; k < SCALE_TILTS; k++) {
+    bench_tilt(k, &s_tilt[k][0], &s_tilt[k][1]);
+  }
+
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    bench_discs_init();
+    for (int i = 0; i < NUM_DISCS; i++) {
+      s_aos[i].pos.x = s_set.pos_x[i];
+      s_aos[i].pos.y = s_set.pos_y[i];
+      s_aos[i].vel.x = 0;
+      s_aos[i].vel.y = 0;
+      s_aos[i].inv_mass = s_set.inv_mass[i];
+      s_aos[i].radius = s_set.radius[i];
+    }
+
+    uint64_t t0 = now_ns();
+    for (int k = 0; k < steps; k++) {
+      const int16_t *tilt = s_tilt[k % SCALE_TILTS];
+      discs_apply_accel(&s_set, tilt[0], tilt[1], FX_ONE);
+      discs_update(&s_set, WINDOW_W, WINDOW_H, FX_ONE);
+    }
+    const uint64_t soa = now_ns() - t0;
+
+    t0 = now_ns();
+    for (int k = 0; k < steps; k++) {
+      const int16_t *tilt = s_tilt[k % SCALE_TILTS];
+      const AosForce fx = aos_force(FX_MUL(tilt[0] * FX_ACCEL_RATIO, FX_ONE));
+      const AosForce fy = aos_force(FX_MUL(-tilt[1] * FX_ACCEL_RATIO, FX_ONE));
+      for (int i = 0; i < NUM_DISCS; i++) {
+        aos_disc_apply_accel(&s_aos[i], &fx, &fy);
+        aos_disc_update(&s_aos[i], WINDOW_W, WINDOW_H);
+      }
+    }
+    const uint64_t aos = now_ns() - t0;
+
+    best_soa = soa < best_soa ? soa : best_soa;
+    best_aos = aos < best_aos ? aos : best_aos;
+  }
+
+  // Both forms must have ended in the same state, or they did not do the
+  // same work
+  bool same = true;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    same &= s_aos[i].pos.x == s_set.pos_x[i] && s_aos[i].pos.y == s_set.pos_y[i]
+        && s_aos[i].vel.x == s_set.vel_x[i] && s_aos[i].vel.y == s_set.vel_y[i];
+  }
+
+  const double soa_disc = (double)best_soa / steps / NUM_DISCS;
+  const double aos_disc = (double)best_aos / steps / NUM_DISCS;
+  const uint64_t step_ns = best_soa / steps;
+  const bool ok = same && step_ns <= STEP_BUDGET_NS;
+  printf("scale: %d discs, arrays %.2f ns per disc, structs %.2f ns per disc,"
+      " x%.2f, %s, step %.1f us of %.0f ms %s\n", NUM_DISCS, soa_disc, aos_disc,
+      aos_disc / soa_disc, same ? "same state" : "states differ", step_ns / 1e3,
+      STEP_BUDGET_NS / 1e6, ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+// Brute force broad phase: every pair gets the distance test of
+// disc_pair_collide, without the response. Returns the overlapping pairs.
+__attribute__((noinline))
+static uint32_t brute_overlaps(const DiscSet *set) {
+  uint32_t overlaps = 0;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    for (int j = i + 1; j < NUM_DISCS; j++) {
+      const int32_t dx8 = (set->pos_x[j] - set->pos_x[i]) >> 8;
+      const int32_t dy8 = (set->pos_y[j] - set->pos_y[i]) >> 8;
+      const int32_t rsum8 = (set->radius[i] + set->radius[j]) >> 8;
+      const uint32_t dist2 = (uint32_t)(dx8 * dx8) + (uint32_t)(dy8 * dy8);
+      overlaps += dist2 < (uint32_t)(rsum8 * rsum8);
+    }
+  }
+  return overlaps;
+}
+
+// Discs further past a wall than their own move of the step. A collision
+// can push a disc past a wall, discs_update must put it back before moving
+// it, so after the update a disc can only be out by its velocity.
+static uint32_t discs_escaped(const DiscSet *set) {
+  uint32_t escaped = 0;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const fixed_t r = set->radius[i];
+    const fixed_t out_x = set->pos_x[i] < r ? r - set->pos_x[i]
+        : set->pos_x[i] - (FX_FROM_INT(WINDOW_W) - r);
+    const fixed_t out_y = set->pos_y[i] < r ? r - set->pos_y[i]
+        : set->pos_y[i] - (FX_FROM_INT(WINDOW_H) - r);
+    escaped += out_x > abs(set->vel_x[i]) || out_y > abs(set->vel_y[i]);
+  }
+  return escaped;
+}
+
+static int bench_broad(void) {
+  // The brute force loop runs on the state each step starts from, before
+  // discs_collide moves anything
+  uint64_t best_step = UINT64_MAX, best_grid = UINT64_MAX, best_brute = UINT64_MAX;
+  uint64_t pair_tests = 0, overlaps = 0;
+  uint32_t escaped = 0;
+
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    bench_discs_init();
+    for (int k = 0; k < BROAD_SETTLE_STEPS; k++) {
+      int16_t ax, ay;
+      bench_tilt(k, &ax, &ay);
+      discs_apply_accel(&s_set, ax, ay, FX_ONE);
+      discs_update(&s_set, WINDOW_W, WINDOW_H, FX_ONE);
+      discs_collide(&s_set, WINDOW_W, WINDOW_H);
+    }
+
+    uint64_t step = 0, grid = 0, brute = 0;
+    pair_tests = 0;
+    overlaps = 0;
+    escaped = 0;
+    for (int k = BROAD_SETTLE_STEPS; k < BROAD_SETTLE_STEPS + BROAD_STEPS; k++) {
+      int16_t ax, ay;
+      bench_tilt(k, &ax, &ay);
+      const uint64_t t0 = now_ns();
+      discs_apply_accel(&s_set, ax, ay, FX_ONE);
+      discs_update(&s_set, WINDOW_W, WINDOW_H, FX_ONE);
+      const uint64_t t1 = now_ns();
+      escaped += discs_escaped(&s_set);
+      overlaps += brute_overlaps(&s_set);
+      const uint64_t t2 = now_ns();
+      pair_tests += discs_collide(&s_set, WINDOW_W, WINDOW_H);
+      const uint64_t t3 = now_ns();
+      step += (t1 - t0) + (t3 - t2);
+      grid += t3 - t2;
+      brute += t2 - t1;
+    }
+    best_step = step < best_step ? step : best_step;
+    best_grid = grid < best_grid ? grid : best_grid;
+    best_brute = brute < best_brute ? brute : best_brute;
+  }
+
+  const uint64_t all_pairs = (uint64_t)NUM_DISCS * (NUM_DISCS - 1) / 2;
+  const uint64_t step_ns = best_step / BROAD_STEPS;
+  const bool ok = escaped == 0 && step_ns <= STEP_BUDGET_NS;
+  printf("broad: %d discs, %.1f pair tests per step of %llu, %.1f overlaps,"
+      " %u past a wall, collide %.1f us, all pairs test alone %.1f us,"
+      " step %.1f us of %.0f ms %s\n",
+      NUM_DISCS, (double)pair_tests / BROAD_STEPS, (unsigned long long)all_pairs,
+      (double)overlaps / BROAD_STEPS, (unsigned)escaped, best_grid / 1e3 / BROAD_STEPS,
+      best_brute / 1e3 / BROAD_STEPS, step_ns / 1e3, STEP_BUDGET_NS / 1e6,
+      ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+static const BenchSuite s_suites[] = {
+  { "ref", bench_ref },
+  { "scale", bench_scale },
+  { "broad", bench_broad },
+};
+
+#define NUM_SUITES (sizeof(s_suites) / sizeof(s_suites[0]))
+
+int main(int argc, char *argv[]) {
+  int failed = 0;
+
+  if (argc == 1) {
+    for (unsigned s = 0; s < NUM_SUITES; s++) {
+      failed |= s_suites[s].run();
+    }
+    return failed;
+  }
+
+  for (int arg = 1; arg < argc; arg++) {
+    unsigned s;
+    for (s = 0; s < NUM_SUITES; s++) {
+      if (strcmp(argv[arg], s_suites[s].name) == 0) {
+        failed |= s_suites[s].run();
+        break;
+      }
+    }
+    if (s == NUM_SUITES) {
+      fprintf(stderr, "unknown suite %s\n", argv[arg]);
+      return 1;
+    }
+  }
+  return failed;
+}
@@ -0,0 +1,1388 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  mbsda_bench.c
+
+@brief  @b Description: @n
+   Host benchmarks of the MBSDA building blocks. Each suite prints its
+   figures of merit and the time per sample, in TSC cycles on x86 and in
+   nanoseconds elsewhere.
+
+   Build:  cc -O2 -DQF_HOST -Isrc -o mbsda_bench host/mbsda_bench.c
+              src/AlgMbsda.c src/DecimFix.c src/FftFix.c src/GoertzelFix.c
+              src/MathFix.c src/RingBuf.c src/qep.c src/qfsm_ini.c
+              src/qfsm_dis.c src/qfsm_dsn.c -lm
+   Usage:  mbsda_bench [suite ...]
+
+      decim     anti-alias decimators by 2 and 4: pass band gain, worst
+                alias rejection into 0-10 Hz and time per input sample
+      profiles  filters of every rate profile in AlgMbsdaRate.h against
+                the 50 Hz design, fails past BENCH_PROFILE_TOL_DB
+      ckpt      Mbsda_save / Mbsda_restore on a synthetic recording: size,
+                time, bit exact round trip, same features afterwards and
+                rejection of damaged or stale checkpoints
+      dispatch  switch and signal-indexed table forms of a state-handler
+                (Q_SIG_SWITCH_HANDLER / Q_SIG_TABLE_HANDLER): same result
+                for every signal, time and branch mispredictions per
+                dispatched event. The mispredictions come from
+                perf_event_open on Linux and read n/a where the hardware
+                counter is not available
+      layout    offset, size and padding of every Mbsda member listed in
+                MBSDA_LAYOUT, fails if they are out of order or padding
+                or the hot members grow past their limits
+      fft       FftFix_transform against a double precision DFT scaled by
+                1/N, fails past BENCH_FFT_TOL_LSB, dominant bin of every
+                bin-centred tone and time per window of window, transform
+                and features
+      goertzel  GoertzelFix bank of the MBSDA: each tone on a detector
+                must be detected on it, band ratio in and out of the band,
+                detected bin of every block of the recordings against the
+                same detectors in double precision and time per sample.
+                The recordings are "timestamp,x,y,z" files at
+                MBSDA_SAMPLE_HZ, listed colon separated in BENCH_RECORDINGS
+
+   Without arguments every suite runs. The exit status is non-zero if any
+   suite failed.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+   #include <linux/perf_event.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+#endif
+#include "qep_port.h"
+#include "DecimFix.h"
+#include "FftFix.h"
+#include "GoertzelFix.h"
+#include "MathFix.h"
+#include "AlgMbsda.h"
+#include "AlgMbsdaPrivate.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+   #include <x86intrin.h>
+   #define BENCH_UNIT "cycles"
+#else
+   #define BENCH_UNIT "ns"
+#endif
+
+#define BENCH_PI      3.14159265358979323846
+#define BENCH_OUT_HZ  50     // Rate the MBSDA filters are designed for
+#define BENCH_AMPL    10000  // Test tone amplitude, 16-bit input
+#define BENCH_RUNS    5
+
+#define BENCH_PROFILE_TOL_DB 1.5 // Largest response error of a rate profile
+#define BENCH_PROFILE_MAX_HZ 8.0 // Compared up to this or a quarter the rate
+
+#define BENCH_CKPT_SECONDS   90   // Still, 3 Hz rhythm, still, 30 s each
+#define BENCH_CKPT_EVERY     (5*MBSDA_INPUT_HZ/2) // Checkpoint every 2.5 s
+#define BENCH_CKPT_CHUNK     256  // Saved in windows of a Pebble persist value
+#define BENCH_CKPT_MAX_AGE   1000 // ms
+#define BENCH_CKPT_MAX_SIZE  4096
+
+#define BENCH_DISPATCH_EVENTS (1 << 16)
+
+#define BENCH_FFT_TOL_LSB     4.0  // Largest bin error against the 1/N DFT
+#define BENCH_FFT_WINDOWS     256  // Windows timed per run
+
+#define BENCH_GTZ_SAMPLES     (1 << 16) // Samples timed per run
+#define BENCH_GTZ_TIE         0.05 // Bins closer than this in power are a tie
+#define BENCH_GTZ_IN_BAND     0.5  // Least band ratio of a tone on a bin
+#define BENCH_GTZ_OUT_BAND    0.1  // Largest band ratio of a 20 Hz tone
+
+static volatile int32_t l_benchSink; // Keeps timed results alive
+
+typedef struct BenchSuiteTag
+{
+   const char *name;
+   int       (*run)(void);
+
+} BenchSuite;
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchNow
+@endinternal
+
+@b Description: @n
+    Time stamp in BENCH_UNIT.
+
+*******************************************************************************/
+static uint64_t benchNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: decimGain
+@endinternal
+
+@b Description: @n
+    Gain in dB of the decimator for a tone of hz at factor*BENCH_OUT_HZ,
+    from the RMS of the output past the filter's start-up.
+
+*******************************************************************************/
+static double decimGain(uint16_t factor, double hz)
+{
+   DecimFix filt;
+   uint32_t inHz  = factor*BENCH_OUT_HZ;
+   uint32_t skip  = DECIM_TAPS_PER_PHASE*2;
+   uint32_t outs  = 0;
+   double   power = 0.0;
+   uint32_t n;
+   int16_t  out;
+
+   DecimFix_init(&filt);
+   for(n = 0; outs < skip + 4*BENCH_OUT_HZ; n++)
+   {
+      int16_t in = (int16_t)lrint(BENCH_AMPL*sin(2.0*BENCH_PI*hz*n/inHz));
+
+      if(DecimFix_push(&filt, factor, in, &out))
+      {
+         if(++outs > skip)
+         {
+            power += (double)out*out;
+         }
+      }
+   }
+   power /= (outs - skip);
+
+   return 10.0*log10(power/(BENCH_AMPL*BENCH_AMPL/2.0) + 1e-12);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchDecim
+@endinternal
+
+@b Description: @n
+    Decimation by 2 (100 Hz in) and by 4 (200 Hz in). The alias rejection
+    is the worst gain over every input frequency that folds into 0-10 Hz
+    at 50 Hz, the band the MBSDA analyses.
+
+*******************************************************************************/
+static int benchDecim(void)
+{
+   static const uint16_t factors[] = { 2, 4 };
+   static int16_t        in[1 << 16];
+   uint32_t i, n, run;
+
+   printf("decim  factor  in Hz  gain 1/5/10 Hz (dB)      alias (dB)  %s/sample\n",
+          BENCH_UNIT);
+
+   for(n = 0; n < sizeof(in)/sizeof(in[0]); n++)
+   {
+      in[n] = (int16_t)((n*2654435761u) >> 16);
+   }
+
+   for(i = 0; i < sizeof(factors)/sizeof(factors[0]); i++)
+   {
+      uint16_t factor = factors[i];
+      uint32_t inHz   = factor*BENCH_OUT_HZ;
+      double   alias  = -1000.0;
+      double   hz;
+      uint64_t best   = UINT64_MAX;
+
+      for(hz = BENCH_OUT_HZ - 10; hz <= inHz/2; hz += 0.25)
+      {
+         double fold = fmod(hz, BENCH_OUT_HZ);
+
+         if((fold <= 10.0) || (fold >= BENCH_OUT_HZ - 10.0))
+         {
+            double g = decimGain(factor, hz);
+            alias = (g > alias) ? g : alias;
+         }
+      }
+
+      for(run = 0; run < BENCH_RUNS; run++)
+      {
+         DecimFix filt;
+         int16_t  out;
+         uint64_t t0, t1;
+
+         DecimFix_init(&filt);
+         t0 = benchNow();
+         for(n = 0; n < sizeof(in)/sizeof(in[0]); n++)
+         {
+            if(DecimFix_push(&filt, factor, in[n], &out))
+            {
+               l_benchSink += out;
+            }
+         }
+         t1 = benchNow();
+         best = ((t1 - t0) < best) ? (t1 - t0) : best;
+      }
+
+      printf("       %6u  %5u  %6.2f %6.2f %6.2f     %8.1f  %10.1f\n",
+             factor, inHz, decimGain(factor, 1.0), decimGain(factor, 5.0),
+             decimGain(factor, 10.0), alias,
+             (double)best/(sizeof(in)/sizeof(in[0])));
+   }
+
+   return 0;
+}
+
+//====================================================================
+// Rate profile parameters, see AlgMbsdaRate.h
+//
+typedef struct ProfileTag
+{
+   int hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk;
+
+} Profile;
+
+#define BENCH_PROFILE_ROW(hz_, ord_, lfw_, lfo_, derw_, alpha_, fftLog2_, \
+                          bandHi_, gtzBlk_)                               \
+   { hz_, ord_, lfw_, lfo_, derw_, alpha_, fftLog2_, bandHi_, gtzBlk_ },
+
+static const Profile l_profiles[] =
+{
+   MBSDA_RATE_PROFILES(BENCH_PROFILE_ROW)
+};
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: profileGains
+@endinternal
+
+@b Description: @n
+    Gains in dB at hz of the four rate dependent stages of a profile: the
+    activity residual (1 - moving average), the low frequency magnitude
+    cascade, the scaled derivative relative to an ideal one and the
+    stdaXyz smoothing.
+
+*******************************************************************************/
+static void profileGains(const Profile *p, double hz, double gain[4])
+{
+   double w = 2.0*BENCH_PI*hz/p->hz;
+   double re, im, a;
+   int    k;
+
+   // Moving average of n samples, (1/n) sum exp(-j w k)
+   re = 0.0;
+   im = 0.0;
+   for(k = 0; k < p->ord; k++)
+   {
+      re += cos(w*k)/p->ord;
+      im -= sin(w*k)/p->ord;
+   }
+   gain[0] = 20.0*log10(hypot(1.0 - re, im));
+
+   re = 0.0;
+   im = 0.0;
+   for(k = 0; k < p->lfw; k++)
+   {
+      re += cos(w*k)/p->lfw;
+      im -= sin(w*k)/p->lfw;
+   }
+   gain[1] = 20.0*log10(pow(hypot(re, im), p->lfo));
+
+   gain[2] = 20.0*log10(hypot(1.0 - cos(w*p->derw), sin(w*p->derw))*
+                        p->hz/p->derw/(2.0*BENCH_PI*hz));
+
+   a = 1.0/(1 << p->alpha);
+   gain[3] = 20.0*log10(a/hypot(1.0 - (1.0 - a)*cos(w), (1.0 - a)*sin(w)));
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchProfiles
+@endinternal
+
+@b Description: @n
+    Worst response error of each stage of every profile against the 50 Hz
+    design, from 0.25 Hz up to BENCH_PROFILE_MAX_HZ or a quarter of the
+    profile's rate, whichever is lower.
+
+*******************************************************************************/
+static int benchProfiles(void)
+{
+   const Profile *ref = NULL;
+   uint32_t i;
+   int      failed = 0;
+
+   for(i = 0; i < sizeof(l_profiles)/sizeof(l_profiles[0]); i++)
+   {
+      if(l_profiles[i].hz == 50)
+      {
+         ref = &l_profiles[i];
+      }
+   }
+   if(ref == NULL)
+   {
+      printf("profiles  no 50 Hz reference profile\n");
+      return 1;
+   }
+
+   printf("profiles  Hz  up to   error (dB): activity  lf mag  derivative  stda\n");
+   for(i = 0; i < sizeof(l_profiles)/sizeof(l_profiles[0]); i++)
+   {
+      const Profile *p = &l_profiles[i];
+      double maxHz = (p->hz/4.0 < BENCH_PROFILE_MAX_HZ) ? p->hz/4.0
+                                                        : BENCH_PROFILE_MAX_HZ;
+      double err[4] = { 0.0, 0.0, 0.0, 0.0 };
+      double hz;
+      int    s, ok = 1;
+
+      for(hz = 0.25; hz <= maxHz; hz += 0.25)
+      {
+         double g[4], g0[4];
+
+         profileGains(p, hz, g);
+         profileGains(ref, hz, g0);
+         for(s = 0; s < 4; s++)
+         {
+            double e = fabs(g[s] - g0[s]);
+            err[s] = (e > err[s]) ? e : err[s];
+         }
+      }
+      for(s = 0; s < 4; s++)
+      {
+         ok &= (err[s] <= BENCH_PROFILE_TOL_DB);
+      }
+      failed |= !ok;
+
+      printf("         %3d  %4.1f Hz          %8.2f  %6.2f  %10.2f  %4.2f  %s\n",
+             p->hz, maxHz, err[0], err[1], err[2], err[3], ok ? "ok" : "FAIL");
+   }
+
+   return failed;
+}
+
+static Mbsda l_ckptRef;  // Runs the whole recording, never restored
+static Mbsda l_ckptCopy; // Resumes from each checkpoint of l_ckptRef
+
+void Q_onAssert(char_t const Q_ROM * const file, int_t line)
+{
+   fprintf(stderr, "assertion failed: %s:%d\n", file, (int)line);
+   exit(2);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: ckptSample
+@endinternal
+
+@b Description: @n
+    Sample n of the synthetic recording at MBSDA_INPUT_HZ: a still wrist,
+    then a 3 Hz rhythm of 400 mg on x and y, then still again, with a few
+    mg of noise throughout.
+
+*******************************************************************************/
+static void ckptSample(uint32_t n, XlDataEvt *e)
+{
+   static uint32_t seed = 1;
+   double t     = (double)n/MBSDA_INPUT_HZ;
+   double swing = 0.0;
+
+   if((t >= BENCH_CKPT_SECONDS/3) && (t < 2*BENCH_CKPT_SECONDS/3))
+   {
+      swing = 400.0*sin(2.0*BENCH_PI*3.0*t);
+   }
+   seed = seed*1664525u + 1013904223u;
+   e->timeStamp = (uint32_t)(n*1000u/MBSDA_INPUT_HZ);
+   e->x = (int16_t)(swing + (int16_t)(seed >> 16)%8);
+   e->y = (int16_t)(-0.5*swing + (int16_t)(seed >> 20)%8);
+   e->z = (int16_t)(-1000 + (int16_t)(seed >> 24)%8);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: ckptBody
+@endinternal
+
+@b Description: @n
+    Compares two instances past the state machine, the part Mbsda_restore
+    fills in.
+
+*******************************************************************************/
+static int ckptBody(Mbsda const *a, Mbsda const *b)
+{
+   size_t start = offsetof(Mbsda, xQ);
+
+   return memcmp((uint8_t const *)a + start, (uint8_t const *)b + start,
+                 sizeof(Mbsda) - start);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchCkpt
+@endinternal
+
+@b Description: @n
+    Checkpoints l_ckptRef every BENCH_CKPT_EVERY samples, saved in
+    BENCH_CKPT_CHUNK windows. Each checkpoint is restored in place, which
+    has to give the instance back bit for bit, and into l_ckptCopy, whose
+    features have to match l_ckptRef's up to the next checkpoint for as
+    long as both are in the same state (the resumed timer to
+    Mbsda_lowActivity restarts). Checkpoints taken in Mbsda_startUp, stale,
+    truncated or damaged ones have to be refused.
+
+*******************************************************************************/
+static int benchCkpt(void)
+{
+   static uint8_t blob[BENCH_CKPT_MAX_SIZE];
+   static uint8_t whole[BENCH_CKPT_MAX_SIZE];
+   static Mbsda   backup;
+   uint32_t total  = BENCH_CKPT_SECONDS*MBSDA_INPUT_HZ;
+   uint32_t saves  = 0, restores = 0, refused = 0;
+   uint32_t compared = 0, mismatches = 0, inexact = 0;
+   uint64_t saveBest = UINT64_MAX, restoreBest = UINT64_MAX;
+   uint16_t len, off, got;
+   uint32_t n, k;
+   int      copyLive = 0;
+   int      failed   = 0;
+   XlDataEvt e;
+   MbsdaSummary ref, copy;
+
+   // Primed with zeros, so the first checkpoint falls in start-up
+   Mbsda_ctorObj(&l_ckptRef);
+   Mbsda_setPrime(&l_ckptRef, 0);
+   QMSM_INIT(&l_ckptRef.super, (QEvt *)0);
+   len = Mbsda_save(&l_ckptRef, NULL, 0, 0);
+   printf("ckpt   size %u bytes, Mbsda %u bytes, %u persist values of %u\n",
+          len, (unsigned)sizeof(Mbsda),
+          (len + BENCH_CKPT_CHUNK - 1)/BENCH_CKPT_CHUNK, BENCH_CKPT_CHUNK);
+   if(len > sizeof(blob))
+   {
+      printf("ckpt   FAIL checkpoint larger than %u\n", BENCH_CKPT_MAX_SIZE);
+      return 1;
+   }
+
+   e.super.sig = XL_DATA_SIG;
+   for(n = 0; n < total; n++)
+   {
+      ckptSample(n, &e);
+
+      if((n != 0) && (n % BENCH_CKPT_EVERY == 0))
+      {
+         uint64_t t0, t1;
+
+         Mbsda_getSummary(&l_ckptRef, &ref);
+
+         t0 = benchNow();
+         got = Mbsda_save(&l_ckptRef, whole, 0, sizeof(whole));
+         t1 = benchNow();
+         saveBest = ((t1 - t0) < saveBest) ? (t1 - t0) : saveBest;
+         for(off = 0;
+             (k = Mbsda_save(&l_ckptRef, blob + off, off, BENCH_CKPT_CHUNK)) != 0;
+             off += k)
+         {
+         }
+         failed |= (got != len) || (off != len) || memcmp(blob, whole, len);
+         saves++;
+
+         // In place: constructed afresh, then restored
+         backup = l_ckptRef;
+         Mbsda_ctorObj(&l_ckptRef);
+         Mbsda_setPrime(&l_ckptRef, 0);
+         t0 = benchNow();
+         k  = Mbsda_restore(&l_ckptRef, blob, len, backup.lastTimestamp,
+                            BENCH_CKPT_MAX_AGE);
+         t1 = benchNow();
+         if(ref.state == MBSDA_STATE_STARTUP)
+         {
+            refused += !k;
+            failed  |= k;
+         }
+         else
+         {
+            restoreBest = ((t1 - t0) < restoreBest) ? (t1 - t0) : restoreBest;
+            restores += k;
+            failed   |= !k;
+            inexact  += (k && ckptBody(&l_ckptRef, &backup) != 0);
+         }
+         l_ckptRef = backup;
+
+         // Into the second instance, resumed on the next sample
+         Mbsda_ctorObj(&l_ckptCopy);
+         copyLive = Mbsda_restore(&l_ckptCopy, blob, len, e.timeStamp,
+                                  BENCH_CKPT_MAX_AGE);
+         QMSM_INIT(&l_ckptCopy.super, (QEvt *)0);
+      }
+
+      QMSM_DISPATCH(&l_ckptRef.super, &e.super);
+      if(copyLive)
+      {
+         QMSM_DISPATCH(&l_ckptCopy.super, &e.super);
+         Mbsda_getSummary(&l_ckptRef, &ref);
+         Mbsda_getSummary(&l_ckptCopy, &copy);
+         if(ref.state != copy.state)
+         {
+            copyLive = 0;
+            continue;
+         }
+         compared++;
+         mismatches += (ref.stdaXyz != copy.stdaXyz) ||
+                       (ref.mTpkR != copy.mTpkR) ||
+                       (ref.domFreq != copy.domFreq) ||
+                       (ref.bandRatio != copy.bandRatio) ||
+                       (ref.szFlags != copy.szFlags) ||
+                       (ref.xlSampleCnt != copy.xlSampleCnt);
+      }
+   }
+   failed |= (inexact != 0) || (mismatches != 0) || (restores == 0);
+
+   printf("       %u saves, %u restored (%u not bit exact), %u refused in "
+          "start-up\n", saves, restores, inexact, refused);
+   printf("       %u samples compared after resuming, %u differ\n",
+          compared, mismatches);
+   printf("       save %.0f, restore %.0f %s\n", (double)saveBest,
+          (double)restoreBest, BENCH_UNIT);
+
+   // Damaged and stale checkpoints leave a constructed instance behind
+   len = Mbsda_save(&l_ckptRef, blob, 0, sizeof(blob));
+   for(k = 0; k < 4; k++)
+   {
+      uint16_t useLen = len;
+      uint32_t now    = l_ckptRef.lastTimestamp;
+
+      memcpy(whole, blob, len);
+      switch(k)
+      {
+         case 0: whole[len/2] ^= 0x10;                    break; // damaged
+         case 1: now += BENCH_CKPT_MAX_AGE + 1;           break; // stale
+         case 2: useLen = len - 1;                        break; // truncated
+         case 3: whole[2]++;                              break; // version
+      }
+      Mbsda_ctorObj(&l_ckptCopy);
+      if(Mbsda_restore(&l_ckptCopy, whole, useLen, now, BENCH_CKPT_MAX_AGE))
+      {
+         printf("       FAIL bad checkpoint %u accepted\n", k);
+         failed = 1;
+      }
+      QMSM_INIT(&l_ckptCopy.super, (QEvt *)0);
+      Mbsda_getSummary(&l_ckptCopy, &copy);
+      failed |= (copy.state != MBSDA_STATE_STARTUP);
+   }
+   printf("       %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+//====================================================================
+// State machine shaped like Mbsda for the dispatch suite: entry, exit and
+// one data action, the other signals ignored. The same action list is
+// expanded once as a switch and once as a table.
+//
+enum BenchSignals
+{
+   BENCH_DATA_SIG = Q_USER_SIG,
+   BENCH_OTHER_SIG,             // Ignored
+
+   BENCH_MAX_SIG
+};
+
+typedef struct BenchFsmTag
+{
+   QFsm     super;
+   uint32_t count; // Actions run
+
+} BenchFsm;
+
+static QState benchFsmSwitchInitial(BenchFsm * const me, QEvt const * const e);
+static QState benchFsmTableInitial (BenchFsm * const me, QEvt const * const e);
+static QState benchFsmSwitch       (BenchFsm * const me, QEvt const * const e);
+static QState benchFsmTable        (BenchFsm * const me, QEvt const * const e);
+static QState benchFsmAction       (BenchFsm * const me, QEvt const * const e);
+static QState benchFsmData         (BenchFsm * const me, QEvt const * const e);
+
+#define BENCH_FSM_ACTIONS(ACTION_) \
+   ACTION_(Q_ENTRY_SIG,    benchFsmAction) \
+   ACTION_(Q_EXIT_SIG,     benchFsmAction) \
+   ACTION_(BENCH_DATA_SIG, benchFsmData)
+
+Q_SIG_SWITCH_HANDLER(benchFsmSwitch, BenchFsm, BENCH_FSM_ACTIONS)
+Q_SIG_TABLE_HANDLER(benchFsmTable, BenchFsm, BENCH_MAX_SIG, BENCH_FSM_ACTIONS)
+
+static QState benchFsmSwitchInitial(BenchFsm * const me, QEvt const * const e)
+{
+   (void)e;
+   return Q_TRAN(&benchFsmSwitch);
+}
+
+static QState benchFsmTableInitial(BenchFsm * const me, QEvt const * const e)
+{
+   (void)e;
+   return Q_TRAN(&benchFsmTable);
+}
+
+static QState benchFsmAction(BenchFsm * const me, QEvt const * const e)
+{
+   (void)e;
+   me->count++;
+   return Q_HANDLED();
+}
+
+static QState benchFsmData(BenchFsm * const me, QEvt const * const e)
+{
+   me->count += e->sig;
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchMisses
+@endinternal
+
+@b Description: @n
+    Branch mispredictions of this thread in user space so far, or
+    UINT64_MAX when the hardware counter cannot be read. The counter is
+    opened on the first call.
+
+*******************************************************************************/
+static uint64_t benchMisses(void)
+{
+#ifdef __linux__
+   static int l_missFd = -2;
+   uint64_t   count;
+
+   if(l_missFd == -2)
+   {
+      struct perf_event_attr attr;
+
+      memset(&attr, 0, sizeof(attr));
+      attr.size           = sizeof(attr);
+      attr.type           = PERF_TYPE_HARDWARE;
+      attr.config         = PERF_COUNT_HW_BRANCH_MISSES;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      l_missFd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+   }
+   if((l_missFd >= 0) &&
+      (read(l_missFd, &count, sizeof(count)) == (ssize_t)sizeof(count)))
+   {
+      return count;
+   }
+#endif
+   return UINT64_MAX;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: dispatchTime
+@endinternal
+
+@b Description: @n
+    Best time over BENCH_RUNS to dispatch the n events to me, per event.
+    The fewest branch mispredictions per event over the same runs go to
+    *misses, or -1 without a counter.
+
+*******************************************************************************/
+static double dispatchTime(BenchFsm *me, QEvt const *evts, uint32_t n,
+                           double *misses)
+{
+   uint64_t best     = UINT64_MAX;
+   uint64_t bestMiss = UINT64_MAX;
+   uint64_t t0, t1, m0, m1;
+   uint32_t run, i;
+
+   for(run = 0; run < BENCH_RUNS; run++)
+   {
+      m0 = benchMisses();
+      t0 = benchNow();
+      for(i = 0; i < n; i++)
+      {
+         QMSM_DISPATCH(&me->super, &evts[i]);
+      }
+      t1 = benchNow();
+      m1 = benchMisses();
+      best = ((t1 - t0) < best) ? (t1 - t0) : best;
+      if((m0 != UINT64_MAX) && (m1 != UINT64_MAX) && ((m1 - m0) < bestMiss))
+      {
+         bestMiss = m1 - m0;
+      }
+   }
+   l_benchSink += (int32_t)me->count;
+
+   *misses = (bestMiss != UINT64_MAX) ? (double)bestMiss/n : -1.0;
+   return (double)best/n;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: dispatchRow
+@endinternal
+
+@b Description: @n
+    Prints the time and mispredictions per event of one form over the
+    data, mixed and random runs.
+
+*******************************************************************************/
+static void dispatchRow(const char *form, BenchFsm *me, QEvt const *runs[3])
+{
+   double   t[3], m[3];
+   uint32_t r;
+
+   for(r = 0; r < 3; r++)
+   {
+      t[r] = dispatchTime(me, runs[r], BENCH_DISPATCH_EVENTS, &m[r]);
+   }
+   printf("          %-6s  %5.1f  %5.1f  %6.1f ", form, t[0], t[1], t[2]);
+   for(r = 0; r < 3; r++)
+   {
+      if(m[r] < 0.0)
+      {
+         printf("     n/a");
+      }
+      else
+      {
+         printf("  %6.3f", m[r]);
+      }
+   }
+   printf("\n");
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchDispatch
+@endinternal
+
+@b Description: @n
+    Checks that the switch and table forms of the same action list return
+    the same and run the same actions for every signal up to past the end
+    of the table, then times QMSM_DISPATCH of a run of data events, of a
+    run with one ignored event in four, half of them past the table, and
+    of a run of the three kinds in random order, which no predictor can
+    learn. Branch mispredictions per event are counted over the same runs.
+
+*******************************************************************************/
+static int benchDispatch(void)
+{
+   static QEvt data[BENCH_DISPATCH_EVENTS];
+   static QEvt mixed[BENCH_DISPATCH_EVENTS];
+   static QEvt random[BENCH_DISPATCH_EVENTS];
+   QEvt const *runs[3] = { data, mixed, random };
+   uint32_t seed = 12345u;
+   BenchFsm sw;
+   BenchFsm tbl;
+   QEvt     e;
+   QState   rSw, rTbl;
+   uint32_t i;
+   int      failed = 0;
+
+   memset(&e, 0, sizeof(e));
+   sw.count  = 0;
+   tbl.count = 0;
+   for(i = 0; i < BENCH_MAX_SIG + 4; i++)
+   {
+      e.sig = (QSignal)i;
+      rSw   = benchFsmSwitch(&sw, &e);
+      rTbl  = benchFsmTable(&tbl, &e);
+      if((rSw != rTbl) || (sw.count != tbl.count))
+      {
+         printf("dispatch  FAIL signal %u: switch %d, table %d\n", i,
+                (int)rSw, (int)rTbl);
+         failed = 1;
+      }
+   }
+
+   memset(data, 0, sizeof(data));
+   memset(mixed, 0, sizeof(mixed));
+   memset(random, 0, sizeof(random));
+   for(i = 0; i < BENCH_DISPATCH_EVENTS; i++)
+   {
+      data[i].sig  = BENCH_DATA_SIG;
+      mixed[i].sig = ((i & 3) != 3) ? BENCH_DATA_SIG
+                   : ((i & 4) != 0) ? BENCH_OTHER_SIG
+                   :                  (QSignal)(BENCH_MAX_SIG + 1);
+      seed = seed*1103515245u + 12345u;
+      switch((seed >> 16) % 3)
+      {
+         case 0:  random[i].sig = BENCH_DATA_SIG;               break;
+         case 1:  random[i].sig = BENCH_OTHER_SIG;              break;
+         default: random[i].sig = (QSignal)(BENCH_MAX_SIG + 1); break;
+      }
+   }
+
+   QFsm_ctor(&sw.super,  (QStateHandler)&benchFsmSwitchInitial);
+   QFsm_ctor(&tbl.super, (QStateHandler)&benchFsmTableInitial);
+   QMSM_INIT(&sw.super,  (QEvt *)0);
+   QMSM_INIT(&tbl.super, (QEvt *)0);
+
+   printf("dispatch  form    %-21s mispredicts/event\n", BENCH_UNIT "/event");
+   printf("                   data  mixed  random    data   mixed  random\n");
+   dispatchRow("switch", &sw, runs);
+   dispatchRow("table", &tbl, runs);
+#ifdef MBSDA_SIG_TABLE
+   printf("          Mbsda is built with the table\n");
+#else
+   printf("          Mbsda is built with the switch\n");
+#endif
+   printf("          %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+typedef struct LayoutRowTag
+{
+   const char *group;
+   const char *member;
+   size_t      offset;
+   size_t      size;
+
+} LayoutRow;
+
+#define BENCH_LAYOUT_ROW(grp_, mbr_) \
+   { #grp_, #mbr_, offsetof(Mbsda, mbr_), sizeof(((Mbsda *)0)->mbr_) },
+
+static const LayoutRow l_layout[] = { MBSDA_LAYOUT(BENCH_LAYOUT_ROW) };
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchLayout
+@endinternal
+
+@b Description: @n
+    Prints the layout of Mbsda from MBSDA_LAYOUT, with the padding after
+    each member, and checks it against MBSDA_HOT_MAX and
+    MBSDA_LAYOUT_PAD_MAX. The checks AlgMbsda.c makes at build time do not
+    see the order of the list.
+
+*******************************************************************************/
+static int benchLayout(void)
+{
+   uint32_t numRows = sizeof(l_layout)/sizeof(l_layout[0]);
+   uint32_t i;
+   size_t   end;
+   size_t   next;
+   size_t   pad    = 0;
+   size_t   hotEnd = 0;
+   int      failed = 0;
+
+   printf("layout    group  member           offset  size  pad\n");
+   for(i = 0; i < numRows; i++)
+   {
+      const LayoutRow *r = &l_layout[i];
+
+      end  = r->offset + r->size;
+      next = (i + 1 < numRows) ? l_layout[i + 1].offset : sizeof(Mbsda);
+      if(next < end)
+      {
+         printf("          FAIL %s overlaps the next member\n", r->member);
+         failed = 1;
+         next = end;
+      }
+      pad += next - end;
+      if(strcmp(r->group, "HOT") == 0)
+      {
+         hotEnd = end;
+      }
+
+      printf("          %-6s %-16s %6u %5u %4u\n", r->group, r->member,
+             (unsigned)r->offset, (unsigned)r->size, (unsigned)(next - end));
+   }
+   failed |= (pad > MBSDA_LAYOUT_PAD_MAX) || (hotEnd > MBSDA_HOT_MAX);
+
+   printf("          %u bytes, %u padding (at most %u), hot members in %u "
+          "bytes (at most %u), %u cache lines of 64\n",
+          (unsigned)sizeof(Mbsda), (unsigned)pad, MBSDA_LAYOUT_PAD_MAX,
+          (unsigned)hotEnd, MBSDA_HOT_MAX, (unsigned)((hotEnd + 63)/64));
+   printf("          %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: fftSignal
+@endinternal
+
+@b Description: @n
+    Test signal number sig of size points: full scale noise, a tone on a
+    bin, a tone between bins over noise and an impulse.
+
+*******************************************************************************/
+static void fftSignal(int sig, uint16_t size, int16_t *x)
+{
+   uint32_t seed = 12345u + sig;
+   uint16_t n;
+   double   v;
+
+   for(n = 0; n < size; n++)
+   {
+      seed = seed*1103515245u + 12345u;
+      switch(sig)
+      {
+         case 0:
+            v = (double)(int16_t)(seed >> 16);
+            v = (v < -32767.0) ? -32767.0 : v;
+            break;
+         case 1:
+            v = 32000.0*cos(2.0*BENCH_PI*5*n/size);
+            break;
+         case 2:
+            v = 20000.0*sin(2.0*BENCH_PI*7.3*n/size) + (int16_t)(seed >> 16)/16;
+            break;
+         default:
+            v = (n == 0) ? 32767.0 : 0.0;
+            break;
+      }
+      x[n] = (int16_t)lrint(v);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchFft
+@endinternal
+
+@b Description: @n
+    FftFix at 64 and 128 points. The transform error is the largest
+    difference, in output LSB, of any real or imaginary bin from a double
+    precision DFT of the same input scaled by 1/N. Every stage rounds its
+    twiddle products and truncates its halved sums, which leaves about 3
+    LSB at worst over random full scale inputs, hence the bound of 4. Tones centred on bins 1 to N/2 - 1 must come
+    out of FftFix_features with the frequency of their bin. The time per
+    window covers FftFix_window, FftFix_transform and FftFix_features, as
+    the MBSDA runs them once per half window.
+
+*******************************************************************************/
+static int benchFft(void)
+{
+   static const uint16_t sizes[] = { 6, 7 };
+   static int16_t        in[BENCH_FFT_WINDOWS][FFT_MAX_SIZE];
+   int16_t     re[FFT_MAX_SIZE], im[FFT_MAX_SIZE];
+   FftFeatures feat;
+   uint32_t    i, w, run;
+   int         failed = 0;
+
+   printf("fft    points  max error (LSB)  tones off bin  %s/window\n", BENCH_UNIT);
+
+   for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+   {
+      uint16_t log2Size = sizes[i];
+      uint16_t size     = 1 << log2Size;
+      double   maxErr   = 0.0;
+      uint32_t offBin   = 0;
+      uint64_t best     = UINT64_MAX;
+      uint16_t k, n;
+      int      sig;
+
+      for(sig = 0; sig < 4; sig++)
+      {
+         fftSignal(sig, size, re);
+         memset(im, 0, sizeof(im));
+         memcpy(in[0], re, sizeof(re));
+         FftFix_transform(re, im, log2Size);
+
+         for(k = 0; k < size; k++)
+         {
+            double dr = 0.0, di = 0.0, err;
+
+            for(n = 0; n < size; n++)
+            {
+               double a = -2.0*BENCH_PI*(double)((uint32_t)k*n % size)/size;
+
+               dr += in[0][n]*cos(a);
+               di += in[0][n]*sin(a);
+            }
+            err = fabs(re[k] - dr/size);
+            maxErr = (err > maxErr) ? err : maxErr;
+            err = fabs(im[k] - di/size);
+            maxErr = (err > maxErr) ? err : maxErr;
+         }
+      }
+
+      for(k = 1; k < size/2; k++)
+      {
+         for(n = 0; n < size; n++)
+         {
+            re[n] = (int16_t)lrint(16000.0*cos(2.0*BENCH_PI*k*n/size));
+         }
+         memset(im, 0, sizeof(im));
+         FftFix_window(re, log2Size);
+         FftFix_transform(re, im, log2Size);
+         FftFix_features(re, im, log2Size, BENCH_OUT_HZ, 2, 8, &feat);
+         if(feat.domFreq != (uint16_t)(((uint32_t)k*BENCH_OUT_HZ << 8) >> log2Size))
+         {
+            offBin++;
+         }
+      }
+
+      for(w = 0; w < BENCH_FFT_WINDOWS; w++)
+      {
+         fftSignal(2, size, in[w]);
+         in[w][w % size] += (int16_t)w;
+      }
+      for(run = 0; run < BENCH_RUNS; run++)
+      {
+         uint64_t total = 0;
+         uint64_t t0;
+
+         for(w = 0; w < BENCH_FFT_WINDOWS; w++)
+         {
+            memcpy(re, in[w], size*sizeof(re[0]));
+            memset(im, 0, size*sizeof(im[0]));
+            t0 = benchNow();
+            FftFix_window(re, log2Size);
+            FftFix_transform(re, im, log2Size);
+            FftFix_features(re, im, log2Size, BENCH_OUT_HZ, 2, 8, &feat);
+            total += benchNow() - t0;
+            l_benchSink += feat.domFreq;
+         }
+         best = (total < best) ? total : best;
+      }
+
+      failed |= (maxErr > BENCH_FFT_TOL_LSB) || (offBin != 0);
+      printf("       %6u  %8.2f of %.1f  %13u  %10.1f\n", size, maxErr,
+             BENCH_FFT_TOL_LSB, offBin, (double)best/BENCH_FFT_WINDOWS);
+   }
+   printf("       %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: gtzBank
+@endinternal
+
+@b Description: @n
+    Frequencies (Hz in Q8) and coefficients (2*cos(2*pi*f/fs) in Q14) of
+    MBSDA_GTZ_BINS detectors spread evenly over the band, as the
+    Goertzel frequency module of AlgMbsda.c lays them out.
+
+*******************************************************************************/
+static void gtzBank(uint16_t *freq, int16_t *coef)
+{
+   uint16_t bin;
+   double   hz;
+
+   for(bin = 0; bin < MBSDA_GTZ_BINS; bin++)
+   {
+      hz = MBSDA_FFT_BAND_LO + (double)bin*(MBSDA_FFT_BAND_HI -
+           MBSDA_FFT_BAND_LO)/(MBSDA_GTZ_BINS - 1);
+      freq[bin] = (uint16_t)lrint(hz*256.0);
+      coef[bin] = (int16_t)lrint(2.0*cos(2.0*BENCH_PI*hz/MBSDA_SAMPLE_HZ)*16384.0);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: gtzBlock
+@endinternal
+
+@b Description: @n
+    Runs one block through a fresh bank and returns its features. With
+    refPwr set it also fills the power of every detector frequency over
+    the block in double precision.
+
+*******************************************************************************/
+static void gtzBlock(int16_t const *x, uint16_t n, uint16_t const *freq,
+                     int16_t const *coef, FftFeatures *feat, double *refPwr)
+{
+   GoertzelBank bank;
+   uint16_t     i, bin;
+
+   Goertzel_init(&bank);
+   for(i = 0; i < n; i++)
+   {
+      Goertzel_update(&bank, coef, MBSDA_GTZ_BINS, x[i]);
+   }
+   Goertzel_read(&bank, coef, freq, MBSDA_GTZ_BINS, feat);
+
+   for(bin = 0; (refPwr != NULL) && (bin < MBSDA_GTZ_BINS); bin++)
+   {
+      double w  = 2.0*BENCH_PI*(freq[bin]/256.0)/MBSDA_SAMPLE_HZ;
+      double re = 0.0, im = 0.0;
+
+      for(i = 0; i < n; i++)
+      {
+         re += x[i]*cos(w*i);
+         im -= x[i]*sin(w*i);
+      }
+      refPwr[bin] = re*re + im*im;
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: gtzRecording
+@endinternal
+
+@b Description: @n
+    Splits a recording into MBSDA_GTZ_BLOCK blocks of the input the
+    Goertzel module sees, the squared magnitude at about 1 mg per LSB less
+    its running mean, and counts the blocks whose detected bin is not the
+    strongest in double precision. Bins within BENCH_GTZ_TIE of the
+    strongest count as detected: the truncated detector updates move the
+    power of a bin by a few percent on quiet blocks. Returns the number of blocks, or -1 if
+    the file cannot be read.
+
+*******************************************************************************/
+static int32_t gtzRecording(const char *path, uint16_t const *freq,
+                            int16_t const *coef, uint32_t *missed)
+{
+   FILE       *f = fopen(path, "r");
+   char        line[128];
+   int16_t     x[MBSDA_GTZ_BLOCK];
+   double      refPwr[MBSDA_GTZ_BINS];
+   double      maxPwr;
+   FftFeatures feat;
+   int32_t     blocks = 0;
+   int32_t     mean   = -1;
+   uint16_t    n      = 0;
+   uint16_t    bin, det;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return -1;
+   }
+   *missed = 0;
+
+   while(fgets(line, sizeof(line), f) != NULL)
+   {
+      unsigned long ts;
+      int32_t       ax, ay, az, mag, dev;
+
+      if(sscanf(line, "%lu,%d,%d,%d", &ts, &ax, &ay, &az) != 4)
+      {
+         continue;
+      }
+      mag  = (int32_t)((uint32_t)(ax*ax + ay*ay + az*az) >> 11);
+      mean = (mean < 0) ? (mag << 4) : mean + mag - (mean >> 4);
+      dev  = mag - (mean >> 4);
+      dev  = dev >  MAX_FX ?  MAX_FX : dev;
+      dev  = dev < -MAX_FX ? -MAX_FX : dev;
+      x[n++] = (int16_t)dev;
+      if(n < MBSDA_GTZ_BLOCK)
+      {
+         continue;
+      }
+      n = 0;
+
+      gtzBlock(x, MBSDA_GTZ_BLOCK, freq, coef, &feat, refPwr);
+      maxPwr = 0.0;
+      det    = 0;
+      for(bin = 0; bin < MBSDA_GTZ_BINS; bin++)
+      {
+         maxPwr = (refPwr[bin] > maxPwr) ? refPwr[bin] : maxPwr;
+         det    = (freq[bin] == feat.domFreq) ? bin : det;
+      }
+      if((maxPwr > 0.0) && (refPwr[det] < (1.0 - BENCH_GTZ_TIE)*maxPwr))
+      {
+         (*missed)++;
+      }
+      blocks++;
+   }
+   fclose(f);
+
+   return blocks;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: benchGoertzel
+@endinternal
+
+@b Description: @n
+    GoertzelFix with the bank of the MBSDA Goertzel frequency module at
+    MBSDA_SAMPLE_HZ, over one MBSDA_GTZ_BLOCK block at a time. A tone on
+    each detector's frequency, over noise, must be detected on that
+    detector with most of the block's power in the band, a tone well above
+    the band must leave little in it. The recordings in BENCH_RECORDINGS
+    are checked block by block against the same detectors evaluated in
+    double precision. The time per sample is that of Goertzel_update plus
+    the read out shared by the samples of a block.
+
+*******************************************************************************/
+static int benchGoertzel(void)
+{
+   static int16_t x[BENCH_GTZ_SAMPLES];
+   uint16_t     freq[MBSDA_GTZ_BINS];
+   int16_t      coef[MBSDA_GTZ_BINS];
+   FftFeatures  feat;
+   GoertzelBank bank;
+   const char  *recs = getenv("BENCH_RECORDINGS");
+   char         path[256];
+   uint32_t     seed    = 12345u;
+   uint32_t     offBin  = 0;
+   double       minIn   = 1.0;
+   double       maxOut  = 0.0;
+   uint64_t     best    = UINT64_MAX;
+   uint32_t     i, run, missed;
+   int32_t      blocks;
+   uint16_t     bin;
+   int          failed  = 0;
+
+   gtzBank(freq, coef);
+
+   for(i = 0; i < BENCH_GTZ_SAMPLES; i++)
+   {
+      seed = seed*1103515245u + 12345u;
+      x[i] = (int16_t)(seed >> 16)/64;
+   }
+
+   printf("goertzel  %u bins %.2f-%.2f Hz, %u Hz, blocks of %u\n",
+          MBSDA_GTZ_BINS, freq[0]/256.0, freq[MBSDA_GTZ_BINS - 1]/256.0,
+          MBSDA_SAMPLE_HZ, MBSDA_GTZ_BLOCK);
+
+   for(bin = 0; bin <= MBSDA_GTZ_BINS; bin++)
+   {
+      double  hz = (bin < MBSDA_GTZ_BINS) ? freq[bin]/256.0 : 20.0;
+      int16_t tone[MBSDA_GTZ_BLOCK];
+      double  ratio;
+
+      for(i = 0; i < MBSDA_GTZ_BLOCK; i++)
+      {
+         tone[i] = (int16_t)lrint(4000.0*sin(2.0*BENCH_PI*hz*i/MBSDA_SAMPLE_HZ
+                                             + bin) + x[i]);
+      }
+      gtzBlock(tone, MBSDA_GTZ_BLOCK, freq, coef, &feat, NULL);
+      ratio = feat.bandRatio/16384.0;
+
+      if(bin < MBSDA_GTZ_BINS)
+      {
+         offBin += (feat.domFreq != freq[bin]);
+         minIn   = (ratio < minIn) ? ratio : minIn;
+      }
+      else
+      {
+         maxOut = ratio;
+      }
+   }
+   failed |= (offBin != 0) || (minIn < BENCH_GTZ_IN_BAND) ||
+             (maxOut > BENCH_GTZ_OUT_BAND);
+   printf("          tones off their bin %u, band ratio on a bin >= %.2f "
+          "(at least %.2f), at 20 Hz %.2f (at most %.2f)\n",
+          offBin, minIn, BENCH_GTZ_IN_BAND, maxOut, BENCH_GTZ_OUT_BAND);
+
+   while((recs != NULL) && (*recs != '\0'))
+   {
+      size_t len = strcspn(recs, ":");
+
+      snprintf(path, sizeof(path), "%.*s", (int)len, recs);
+      recs += len + (recs[len] == ':');
+
+      blocks = gtzRecording(path, freq, coef, &missed);
+      if(blocks < 0)
+      {
+         failed = 1;
+         continue;
+      }
+      failed |= (missed != 0);
+      printf("          %-24s %6d blocks, %u off the strongest bin\n",
+             path, (int)blocks, missed);
+   }
+   if(getenv("BENCH_RECORDINGS") == NULL)
+   {
+      printf("          no recordings, set BENCH_RECORDINGS\n");
+   }
+
+   for(run = 0; run < BENCH_RUNS; run++)
+   {
+      uint64_t t0, t1;
+
+      Goertzel_init(&bank);
+      t0 = benchNow();
+      for(i = 0; i < BENCH_GTZ_SAMPLES; i++)
+      {
+         Goertzel_update(&bank, coef, MBSDA_GTZ_BINS, x[i]);
+         if(bank.count == MBSDA_GTZ_BLOCK)
+         {
+            Goertzel_read(&bank, coef, freq, MBSDA_GTZ_BINS, &feat);
+            l_benchSink += feat.domFreq;
+         }
+      }
+      t1 = benchNow();
+      best = ((t1 - t0) < best) ? (t1 - t0) : best;
+   }
+   printf("          %.1f %s/sample\n", (double)best/BENCH_GTZ_SAMPLES,
+          BENCH_UNIT);
+   printf("          %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+static const BenchSuite l_suites[] =
+{
+   { "decim",    benchDecim },
+   { "profiles", benchProfiles },
+   { "ckpt",     benchCkpt },
+   { "dispatch", benchDispatch },
+   { "layout",   benchLayout },
+   { "fft",      benchFft },
+   { "goertzel", benchGoertzel },
+};
+
+int main(int argc, char *argv[])
+{
+   uint32_t s;
+   int      arg;
+   int      failed = 0;
+
+   if(argc == 1)
+   {
+      for(s = 0; s < sizeof(l_suites)/sizeof(l_suites[0]); s++)
+      {
+         failed |= l_suites[s].run();
+      }
+      return failed;
+   }
+
+   for(arg = 1; arg < argc; arg++)
+   {
+      for(s = 0; s < sizeof(l_suites)/sizeof(l_suites[0]); s++)
+      {
+         if(strcmp(argv[arg], l_suites[s].name) == 0)
+         {
+            failed |= l_suites[s].run();
+            break;
+         }
+      }
+      if(s == sizeof(l_suites)/sizeof(l_suites[0]))
+      {
+         fprintf(stderr, "unknown suite %s\n", argv[arg]);
+         return 1;
+      }
+   }
+
+   return failed;
+}
@@ -0,0 +1,824 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  mbsda_exec.c
+
+@brief  @b Description: @n
+   Replays accelerometer recordings through one independent MBSDA instance
+   per recording on the work-stealing executor (FsmExec.c) and prints the
+   throughput and steal/migration report.
+
+   Build:  cc -O2 -DQF_HOST -Isrc -Ihost -o mbsda_exec host/mbsda_exec.c
+              host/FsmExec.c src/AlgMbsda.c src/DecimFix.c src/FftFix.c
+              src/GoertzelFix.c src/RingBuf.c src/MathFix.c src/qep.c
+              src/qfsm_ini.c src/qfsm_dis.c src/qfsm_dsn.c -lpthread
+           Add -DMBSDA_FREQ_MODULE=2 for the Goertzel frequency module,
+           -DMBSDA_INPUT_HZ=100 or 200 for recordings faster than 50 Hz, and
+           -DMBSDA_FREQ_GATE=0 to run the frequency module on every sample.
+           Add -DQ_SPY and src/qs.c for the traced variant, which takes -t,
+           and -no-pie so that qs_decode -m can name states from nm output.
+   Usage:  mbsda_exec [-w workers] [-q quantum] [-r copies] rec.csv ...
+           mbsda_exec -s maxWorkers [-q quantum] [-r copies] rec.csv ...
+           mbsda_exec -l lowHz rec.csv ...
+           mbsda_exec -p samples rec.csv ...
+
+      -w  worker threads (default 1)
+      -q  events dispatched per turn of an instance (default 256)
+      -r  instances per recording, to model a full night's batch from a
+          few files (default 1)
+      -s  instead of one run, sweep the workers from 1 up to maxWorkers,
+          doubling, and report the throughput and the speedup over one
+          worker, best of SWEEP_RUNS runs each
+      -t  Q_SPY builds only: run the executor once with every QS record
+          filtered out and once writing the QEP trace to the given file
+          (read it with qs_decode), and report the records, their size and
+          the cost per record, draining included
+      -l  instead of the executor, replay each recording as the worker
+          would with the rate switching at lowHz, and report what it saves
+          and what it costs in detection latency against a fixed rate
+      -p  instead of the executor, replay each recording through an
+          instance primed with zeros and one primed from the first sample
+          that leaves start-up after the given samples, both at the full
+          rate, and report when each leaves start-up and from when their
+          features match
+
+   Recordings are text files with one "timestamp,x,y,z" sample per line.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "qep_port.h"
+#include "AlgMbsda.h"
+#include "AlgMbsdaPrivate.h"
+#include "FsmExec.h"
+#ifdef Q_SPY
+   #include <time.h>
+   #include "qs_port.h"
+   #if defined(__x86_64__) || defined(__i386__)
+      #include <x86intrin.h>
+      #define TRACE_UNIT "cycles"
+   #else
+      #define TRACE_UNIT "ns"
+   #endif
+#endif
+
+#define REPLAY_MAX_BATCH    25   // Samples the accelerometer service buffers
+#define REPLAY_MAX_ONSETS   256
+#define REPLAY_ACT_TH       100  // stdaXyz of an activity detection
+#define REPLAY_BAND_TH      8192 // bandRatio of a rhythm detection, Q14
+#define REPLAY_MATCH_MS     2000 // Earliest match before a reference onset
+
+#define PRIME_NUM_FEATURES  5    // Features compared by replayPrime
+
+#define SWEEP_RUNS          5    // Runs per worker count, best is kept
+
+#define TRACE_REC_BYTES     32         // Room per record in the QS buffer
+#define TRACE_CHUNK         4096       // Bytes drained at a time
+
+typedef struct RecordingTag
+{
+   XlDataEvt *evts;
+   uint32_t   numEvts;
+
+} Recording;
+
+//====================================================================
+// Outcome of a replay at the rates one instance asked for
+//
+typedef struct ReplayTag
+{
+   uint32_t samples;   // samples dispatched
+   uint32_t batches;   // batches, one wake-up each
+   uint32_t lowMs;     // time spent below MBSDA_INPUT_HZ
+   uint32_t numAct;    // activity detections, rising edges
+   uint32_t numRhy;    // rhythm detections, rising edges
+   uint32_t actMs[REPLAY_MAX_ONSETS];
+   uint32_t rhyMs[REPLAY_MAX_ONSETS];
+
+} Replay;
+
+#ifdef Q_SPY
+static FILE    *l_traceFile;
+static uint64_t l_traceRecs;   // Records written to l_traceFile
+static uint64_t l_traceBytes;
+#endif
+
+void Q_onAssert(char_t const Q_ROM * const file, int_t line)
+{
+   fprintf(stderr, "assertion failed: %s:%d\n", file, (int)line);
+   exit(2);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: loadRecording
+@endinternal
+
+@b Description: @n
+    Reads a "timestamp,x,y,z" text recording into XL_DATA_SIG events.
+
+*******************************************************************************/
+static int loadRecording(const char *path, Recording *rec)
+{
+   FILE    *f = fopen(path, "r");
+   char     line[128];
+   uint32_t cap = 4096;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return -1;
+   }
+   rec->numEvts = 0;
+   rec->evts    = malloc(cap * sizeof(XlDataEvt));
+
+   while((rec->evts != NULL) && (fgets(line, sizeof(line), f) != NULL))
+   {
+      unsigned long ts;
+      int x, y, z;
+
+      if(sscanf(line, "%lu,%d,%d,%d", &ts, &x, &y, &z) != 4)
+      {
+         continue;
+      }
+      if(rec->numEvts == cap)
+      {
+         cap *= 2;
+         rec->evts = realloc(rec->evts, cap * sizeof(XlDataEvt));
+         if(rec->evts == NULL)
+         {
+            break;
+         }
+      }
+      memset(&rec->evts[rec->numEvts], 0, sizeof(XlDataEvt));
+      rec->evts[rec->numEvts].super.sig = XL_DATA_SIG;
+      rec->evts[rec->numEvts].timeStamp = (uint32_t)ts;
+      rec->evts[rec->numEvts].x         = (int16_t)x;
+      rec->evts[rec->numEvts].y         = (int16_t)y;
+      rec->evts[rec->numEvts].z         = (int16_t)z;
+      rec->numEvts++;
+   }
+   fclose(f);
+
+   if(rec->evts == NULL)
+   {
+      fprintf(stderr, "%s: out of memory\n", path);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: replayRates
+@endinternal
+
+@b Description: @n
+    Replays a recording made at MBSDA_INPUT_HZ the way the worker would see
+    it: samples at the rate the instance asks for, taken from the
+    recording, in batches of up to a second. After every batch the
+    detections are sampled and the rate asked for is applied, as the
+    worker does.
+
+*******************************************************************************/
+static void replayRates(const Recording *rec, uint16_t lowHz, Replay *out)
+{
+   static Mbsda inst;
+   XlDataEvt    batch[REPLAY_MAX_BATCH];
+   MbsdaSummary sum;
+   uint32_t     rateHz  = MBSDA_INPUT_HZ;
+   uint32_t     batchSz = REPLAY_MAX_BATCH;
+   uint32_t     n       = 0;
+   uint32_t     i;
+   uint32_t     nextMs;
+   uint32_t     lastMs;
+   int          act = 0;
+   int          rhy = 0;
+
+   memset(out, 0, sizeof(*out));
+   QMSM_INIT(Mbsda_ctorObj(&inst), (QEvt *)0);
+   Mbsda_setLowRate(&inst, lowHz);
+
+   if(rec->numEvts == 0)
+   {
+      return;
+   }
+   nextMs = lastMs = rec->evts[0].timeStamp;
+
+   for(i = 0; i < rec->numEvts; i++)
+   {
+      if(rec->evts[i].timeStamp < nextMs)
+      {
+         continue;
+      }
+      nextMs += 1000/rateHz;
+      batch[n++] = rec->evts[i];
+      if((n < batchSz) && (i + 1 < rec->numEvts))
+      {
+         continue;
+      }
+
+      QFsm_dispatchN(&inst.super, &batch[0].super, n, sizeof(XlDataEvt));
+      out->samples += n;
+      out->batches++;
+      if(rateHz < MBSDA_INPUT_HZ)
+      {
+         out->lowMs += batch[n - 1].timeStamp - lastMs;
+      }
+      lastMs = batch[n - 1].timeStamp;
+      n = 0;
+
+      Mbsda_getSummary(&inst, &sum);
+      if(!act && (sum.stdaXyz > REPLAY_ACT_TH) &&
+         (out->numAct < REPLAY_MAX_ONSETS))
+      {
+         out->actMs[out->numAct++] = lastMs;
+      }
+      act = (sum.stdaXyz > REPLAY_ACT_TH);
+      if(!rhy && act && (sum.bandRatio >= REPLAY_BAND_TH) &&
+         (out->numRhy < REPLAY_MAX_ONSETS))
+      {
+         out->rhyMs[out->numRhy++] = lastMs;
+      }
+      rhy = act && (sum.bandRatio >= REPLAY_BAND_TH);
+
+      if(sum.xlRateHz != rateHz)
+      {
+         rateHz  = sum.xlRateHz;
+         batchSz = (rateHz < REPLAY_MAX_BATCH) ? rateHz : REPLAY_MAX_BATCH;
+         nextMs  = lastMs + 1000/rateHz;
+      }
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: replayLatency
+@endinternal
+
+@b Description: @n
+    Matches every reference detection with the first one of the switching
+    replay that is no more than REPLAY_MATCH_MS earlier and comes before
+    the next reference detection. Prints the mean and worst delay and how
+    many were matched.
+
+*******************************************************************************/
+static void replayLatency(const uint32_t *ref, uint32_t numRef,
+                          const uint32_t *sw, uint32_t numSw)
+{
+   uint32_t i, j = 0;
+   uint32_t found = 0;
+   int32_t  delay;
+   int32_t  worst = 0;
+   int64_t  total = 0;
+
+   for(i = 0; i < numRef; i++)
+   {
+      while((j < numSw) && (sw[j] + REPLAY_MATCH_MS < ref[i]))
+      {
+         j++;
+      }
+      if((j == numSw) || ((i + 1 < numRef) && (sw[j] >= ref[i + 1])))
+      {
+         continue;
+      }
+      delay  = (int32_t)(sw[j] - ref[i]);
+      total += delay;
+      worst  = (delay > worst) ? delay : worst;
+      found++;
+      j++;
+   }
+
+   if(found == 0)
+   {
+      printf("         -/-     (0/%u)", numRef);
+      return;
+   }
+   printf("  %5.2f/%5.2f (%u/%u)", total/1000.0/found, worst/1000.0,
+          found, numRef);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: replayPrime
+@endinternal
+
+@b Description: @n
+    Replays a recording through an instance primed with zeros and one
+    primed from the first sample. Prints the time each leaves start-up
+    and, for the moving averages, stdaXyz, the low frequency magnitude,
+    the spectrum and mTpkR, the time from which both give the same values
+    to the end of the recording, "-" if they still differ at the end.
+
+*******************************************************************************/
+static void replayPrime(const Recording *rec, uint8_t samples)
+{
+   static Mbsda inst[2];
+   MbsdaSummary sum[2];
+   uint32_t     startMs[2] = { 0, 0 };
+   uint32_t     matchMs[PRIME_NUM_FEATURES];
+   int          differs[PRIME_NUM_FEATURES];
+   uint32_t     i, k, t;
+
+   for(k = 0; k < 2; k++)
+   {
+      Mbsda_ctorObj(&inst[k]);
+      Mbsda_setPrime(&inst[k], (k == 0) ? 0 : samples);
+      Mbsda_setLowRate(&inst[k], 0);
+      QMSM_INIT(&inst[k].super, (QEvt *)0);
+   }
+   for(k = 0; k < PRIME_NUM_FEATURES; k++)
+   {
+      matchMs[k] = 0;
+      differs[k] = 0;
+   }
+
+   for(i = 0; i < rec->numEvts; i++)
+   {
+      t = rec->evts[i].timeStamp - rec->evts[0].timeStamp;
+      for(k = 0; k < 2; k++)
+      {
+         QMSM_DISPATCH(&inst[k].super, &rec->evts[i].super);
+         Mbsda_getSummary(&inst[k], &sum[k]);
+         if((startMs[k] == 0) && (sum[k].state != MBSDA_STATE_STARTUP))
+         {
+            startMs[k] = t + 1;
+         }
+      }
+
+      differs[0] = memcmp(inst[0].lastXyzFilt, inst[1].lastXyzFilt,
+                          sizeof(inst[0].lastXyzFilt)) != 0;
+      differs[1] = sum[0].stdaXyz != sum[1].stdaXyz;
+      differs[2] = inst[0].lfFiltOutput != inst[1].lfFiltOutput;
+      differs[3] = (sum[0].domFreq != sum[1].domFreq) ||
+                   (sum[0].bandRatio != sum[1].bandRatio);
+      differs[4] = sum[0].mTpkR != sum[1].mTpkR;
+      for(k = 0; k < PRIME_NUM_FEATURES; k++)
+      {
+         if(differs[k])
+         {
+            matchMs[k] = (i + 1 < rec->numEvts)
+                       ? rec->evts[i + 1].timeStamp - rec->evts[0].timeStamp
+                       : t;
+         }
+      }
+   }
+
+   printf("  %6.2f  %6.2f ", (startMs[0] - 1)/1000.0,
+          (startMs[1] - 1)/1000.0);
+   for(k = 0; k < PRIME_NUM_FEATURES; k++)
+   {
+      if(differs[k])
+      {
+         printf("       -");
+      }
+      else
+      {
+         printf("  %6.2f", matchMs[k]/1000.0);
+      }
+   }
+   printf("\n");
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: initStreams
+@endinternal
+
+@b Description: @n
+    Constructs and initializes one instance per stream and points the
+    streams at the recordings. Recordings are shared read-only between
+    their copies, each copy has its own state machine.
+
+*******************************************************************************/
+static void initStreams(const Recording *recs, uint32_t numRecs, Mbsda *inst,
+                        FsmStream *streams, uint32_t numStreams)
+{
+   uint32_t i;
+
+   for(i = 0; i < numStreams; i++)
+   {
+      const Recording *rec = &recs[i % numRecs];
+      QFsm *fsm = Mbsda_ctorObj(&inst[i]);
+
+      QMSM_INIT(fsm, (QEvt *)0);
+      streams[i].fsm       = fsm;
+      streams[i].events    = &rec->evts[0].super;
+      streams[i].stride    = sizeof(XlDataEvt);
+      streams[i].numEvents = rec->numEvts;
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: sweepExec
+@endinternal
+
+@b Description: @n
+    Runs the executor on fresh instances with 1, 2, 4, ... up to
+    maxWorkers workers and prints the best throughput of each worker count
+    and its speedup and efficiency against one worker. The online CPU
+    count is printed with it, since workers beyond it can only time-slice.
+
+*******************************************************************************/
+static int sweepExec(const Recording *recs, uint32_t numRecs, Mbsda *inst,
+                     FsmStream *streams, uint32_t numStreams,
+                     uint32_t maxWorkers, uint32_t quantum,
+                     FsmExecReport *report)
+{
+   uint32_t workers;
+   uint32_t run;
+   uint32_t i;
+   uint64_t events;
+   uint64_t steals;
+   uint64_t migrations;
+   double   rate;
+   double   best;
+   double   base = 0.0;
+
+   printf("%u instances from %u recordings, quantum %u, %ld CPUs online\n",
+          numStreams, numRecs, quantum, sysconf(_SC_NPROCESSORS_ONLN));
+   printf("workers     events/s  speedup  efficiency    steals  migrations\n");
+   for(workers = 1; ; workers = (2*workers < maxWorkers) ? 2*workers
+                                                         : maxWorkers)
+   {
+      best       = 0.0;
+      steals     = 0;
+      migrations = 0;
+      for(run = 0; run < SWEEP_RUNS; run++)
+      {
+         initStreams(recs, numRecs, inst, streams, numStreams);
+         if(FsmExec_run(streams, numStreams, workers, quantum, report) != 0)
+         {
+            return -1;
+         }
+         events = 0;
+         for(i = 0; i < workers; i++)
+         {
+            events += report->worker[i].events;
+         }
+         rate = (report->seconds > 0.0) ? events/report->seconds : 0.0;
+         if(rate > best)
+         {
+            best       = rate;
+            steals     = 0;
+            migrations = 0;
+            for(i = 0; i < workers; i++)
+            {
+               steals     += report->worker[i].steals;
+               migrations += report->worker[i].migrations;
+            }
+         }
+      }
+      if(workers == 1)
+      {
+         base = best;
+      }
+      printf("%7u %12.0f %8.2f %10.0f%% %9llu %11llu\n", workers, best,
+             (base > 0.0) ? best/base : 0.0,
+             (base > 0.0) ? 100.0*best/base/workers : 0.0,
+             (unsigned long long)steals, (unsigned long long)migrations);
+      if(workers == maxWorkers)
+      {
+         break;
+      }
+   }
+   return 0;
+}
+
+#ifdef Q_SPY
+/**
+********************************************************************************
+@internal
+   Fuction Name: traceNow
+@endinternal
+
+@b Description: @n
+    Time stamp in TRACE_UNIT, also the QS time stamp (its low 32 bits).
+
+*******************************************************************************/
+static uint64_t traceNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+QSTimeCtr QS_onGetTime(void)
+{
+   return (QSTimeCtr)traceNow();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: traceDrain
+@endinternal
+
+@b Description: @n
+    Moves the trace from the QS buffer to l_traceFile, counting records.
+
+*******************************************************************************/
+static void traceDrain(void)
+{
+   static uint8_t chunk[TRACE_CHUNK];
+   uint_fast16_t  n;
+   uint_fast16_t  k;
+
+   while((n = QS_drain(chunk, sizeof(chunk))) != 0)
+   {
+      for(k = 0; k < n; k += chunk[k])
+      {
+         l_traceRecs++;
+      }
+      l_traceBytes += n;
+      fwrite(chunk, 1, n, l_traceFile);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: traceExec
+@endinternal
+
+@b Description: @n
+    Runs the executor twice on fresh instances, first with every QS record
+    filtered out, then tracing the QEP records. The difference in time over
+    the records written is the cost of one record. The QS buffer holds the
+    whole trace, which is drained into path after the run, as the app
+    would send it off the watch when idle, and timed on its own.
+
+*******************************************************************************/
+static int traceExec(const char *path, const Recording *recs,
+                     uint32_t numRecs, Mbsda *inst, FsmStream *streams,
+                     uint32_t numStreams, uint32_t numWorkers,
+                     uint32_t quantum, FsmExecReport *report)
+{
+   uint8_t  *buf;
+   uint64_t  bufSize = 4*QS_REC_MAX;
+   uint64_t  events  = 0;
+   uint32_t  i;
+   uint64_t  t0;
+   uint64_t  timeOff;
+   uint64_t  timeOn;
+   uint64_t  timeDrain;
+   uint64_t  written;
+
+   // A DISPATCH and a transition record per event, one INIT per instance
+   for(i = 0; i < numStreams; i++)
+   {
+      events += recs[i % numRecs].numEvts;
+   }
+   while(bufSize < (2*events + numStreams)*TRACE_REC_BYTES + 4*QS_REC_MAX)
+   {
+      bufSize *= 2;
+   }
+   buf = malloc(bufSize);
+   if(buf == NULL)
+   {
+      fprintf(stderr, "no room for a %llu byte trace\n",
+              (unsigned long long)bufSize);
+      return -1;
+   }
+   memset(buf, 0, bufSize); // Fault the pages in, like static RAM
+
+   QS_initBuf(buf, bufSize);
+   QS_FILTER_OFF(QS_ALL_RECORDS);
+   initStreams(recs, numRecs, inst, streams, numStreams);
+   t0 = traceNow();
+   if(FsmExec_run(streams, numStreams, numWorkers, quantum, report) != 0)
+   {
+      return -1;
+   }
+   timeOff = traceNow() - t0;
+
+   l_traceFile = fopen(path, "wb");
+   if(l_traceFile == NULL)
+   {
+      perror(path);
+      return -1;
+   }
+   QS_initBuf(buf, bufSize);
+   initStreams(recs, numRecs, inst, streams, numStreams);
+   t0 = traceNow();
+   if(FsmExec_run(streams, numStreams, numWorkers, quantum, report) != 0)
+   {
+      return -1;
+   }
+   timeOn = traceNow() - t0;
+   t0 = traceNow();
+   traceDrain();
+   timeDrain = traceNow() - t0;
+   fclose(l_traceFile);
+   free(buf);
+
+   written = l_traceRecs + QS_priv_.dropped;
+   printf("QS trace %s: %llu records of %.1f bytes on average, %u dropped\n"
+          "  signal %d, time stamp %d, pointers %d bytes\n",
+          path, (unsigned long long)l_traceRecs,
+          (l_traceRecs != 0) ? (double)l_traceBytes/l_traceRecs : 0.0,
+          (unsigned)QS_priv_.dropped, Q_SIGNAL_SIZE, QS_TIME_SIZE,
+          QS_OBJ_PTR_SIZE);
+   printf("  replay %llu %s untraced, %llu traced: %.1f %s per record\n",
+          (unsigned long long)timeOff, TRACE_UNIT,
+          (unsigned long long)timeOn,
+          (written != 0) ? ((double)timeOn - (double)timeOff)/written : 0.0,
+          TRACE_UNIT);
+   printf("  drain %llu %s: %.1f %s per record\n",
+          (unsigned long long)timeDrain, TRACE_UNIT,
+          (l_traceRecs != 0) ? (double)timeDrain/l_traceRecs : 0.0,
+          TRACE_UNIT);
+   return 0;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+   uint32_t       numWorkers = 1;
+   uint32_t       quantum    = 256;
+   uint32_t       copies     = 1;
+   int            lowHz      = -1;
+   int            prime      = -1;
+   uint32_t       sweep      = 0;
+#ifdef Q_SPY
+   const char    *tracePath  = NULL;
+#endif
+   uint32_t       numRecs;
+   uint32_t       numStreams;
+   uint32_t       i;
+   Recording     *recs;
+   Mbsda         *inst;
+   FsmStream     *streams;
+   FsmExecReport *report;
+   int            arg = 1;
+
+   for(; (arg < argc - 1) && (argv[arg][0] == '-'); arg += 2)
+   {
+      switch(argv[arg][1])
+      {
+         case 'w': numWorkers = (uint32_t)atoi(argv[arg + 1]); break;
+         case 'q': quantum    = (uint32_t)atoi(argv[arg + 1]); break;
+         case 'r': copies     = (uint32_t)atoi(argv[arg + 1]); break;
+         case 'l': lowHz      = atoi(argv[arg + 1]);           break;
+         case 'p': prime      = atoi(argv[arg + 1]);           break;
+         case 's': sweep      = (uint32_t)atoi(argv[arg + 1]); break;
+#ifdef Q_SPY
+         case 't': tracePath  = argv[arg + 1];                 break;
+#endif
+         default:
+            fprintf(stderr, "unknown option %s\n", argv[arg]);
+            return 1;
+      }
+   }
+   numRecs = (uint32_t)(argc - arg);
+   if((numRecs == 0) || (copies == 0))
+   {
+      fprintf(stderr, "usage: %s [-w workers] [-q quantum] [-r copies] rec.csv ...\n"
+                      "       %s -s maxWorkers [-q quantum] [-r copies] rec.csv ...\n"
+                      "       %s -l lowHz rec.csv ...\n"
+                      "       %s -p samples rec.csv ...\n",
+              argv[0], argv[0], argv[0], argv[0]);
+      return 1;
+   }
+
+   if(lowHz >= 0)
+   {
+      static Replay ref;
+      static Replay sw;
+      Recording     rec;
+
+      printf("rate switching %d Hz / %d Hz, batches of up to %d samples\n",
+             MBSDA_INPUT_HZ, lowHz, REPLAY_MAX_BATCH);
+      printf("recording            samples  wake-ups  low rate"
+             "  activity delay (s)  rhythm delay (s)\n");
+      for(i = 0; i < numRecs; i++)
+      {
+         if(loadRecording(argv[arg + i], &rec) != 0)
+         {
+            return 1;
+         }
+         replayRates(&rec, 0, &ref);
+         replayRates(&rec, (uint16_t)lowHz, &sw);
+
+         printf("%-20s %6.1f%%   %6.1f%%   %6.1f%%",
+                argv[arg + i], 100.0*sw.samples/ref.samples,
+                100.0*sw.batches/ref.batches,
+                100.0*sw.lowMs/(rec.evts[rec.numEvts - 1].timeStamp -
+                                rec.evts[0].timeStamp));
+         replayLatency(ref.actMs, ref.numAct, sw.actMs, sw.numAct);
+         replayLatency(ref.rhyMs, ref.numRhy, sw.rhyMs, sw.numRhy);
+         printf("\n");
+         free(rec.evts);
+      }
+      return 0;
+   }
+
+   if(prime >= 0)
+   {
+      Recording rec;
+
+      printf("zero primed against primed from the first sample, start-up "
+             "of %d samples\n", prime);
+      printf("recording            start-up (s)    features match from (s)\n"
+             "                       zero  primed  average    stda"
+             "  lf mag spectrum   mTpkR\n");
+      for(i = 0; i < numRecs; i++)
+      {
+         if(loadRecording(argv[arg + i], &rec) != 0)
+         {
+            return 1;
+         }
+         printf("%-20s", argv[arg + i]);
+         replayPrime(&rec, (uint8_t)prime);
+         free(rec.evts);
+      }
+      return 0;
+   }
+
+   numStreams = numRecs * copies;
+   recs    = calloc(numRecs, sizeof(Recording));
+   inst    = calloc(numStreams, sizeof(Mbsda));
+   streams = calloc(numStreams, sizeof(FsmStream));
+   report  = calloc(1, sizeof(FsmExecReport));
+   if((recs == NULL) || (inst == NULL) || (streams == NULL) || (report == NULL))
+   {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+   }
+
+   for(i = 0; i < numRecs; i++)
+   {
+      if(loadRecording(argv[arg + i], &recs[i]) != 0)
+      {
+         return 1;
+      }
+   }
+
+   if(sweep != 0)
+   {
+      if(sweep > FSMEXEC_MAX_WORKERS)
+      {
+         fprintf(stderr, "at most %d workers\n", FSMEXEC_MAX_WORKERS);
+         return 1;
+      }
+      if(sweepExec(recs, numRecs, inst, streams, numStreams, sweep, quantum,
+                   report) != 0)
+      {
+         fprintf(stderr, "executor failed to start\n");
+         return 1;
+      }
+      return 0;
+   }
+
+#ifdef Q_SPY
+   if(tracePath != NULL)
+   {
+      if(traceExec(tracePath, recs, numRecs, inst, streams, numStreams,
+                   numWorkers, quantum, report) != 0)
+      {
+         fprintf(stderr, "traced executor failed to start\n");
+         return 1;
+      }
+   }
+   else
+#endif
+   {
+      initStreams(recs, numRecs, inst, streams, numStreams);
+      if(FsmExec_run(streams, numStreams, numWorkers, quantum, report) != 0)
+      {
+         fprintf(stderr, "executor failed to start\n");
+         return 1;
+      }
+   }
+   printf("%u instances from %u recordings\n", numStreams, numRecs);
+   FsmExec_print(stdout, report);
+
+   return 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for the worker SDK header, the worker API is a subset of
+// the app one here
+#include "pebble.h"
@@ -0,0 +1,765 @@
+// Host implementation of the Pebble stand-in in host/pebble/.
+//
+// Runs the disc demo headless: the accelerometer is fed from a recorded
+// trace, time follows the trace, drawing goes to a 1-bit software
+// framebuffer that can be dumped as PBM images to diff rendering changes
+// pixel by pixel. At the end it reports the time spent per physics step
+// and per rendered frame.
+//
+// Build:
+//   cc -O2 -std=gnu99 -Ihost/pebble -Isrc -o accel_discs
+//     src/feature_accel_discs.c src/disc_physics.c host/pebble_host.c
+//
+// Run:
+//   PBL_TRACE=trace.csv [PBL_DUMP_DIR=frames] [PBL_DUMP_EVERY=n]
+//     [PBL_CLICKS=5000u,12000d] ./accel_discs
+//
+// PBL_CLICKS presses buttons at trace times in ms: u, s, d for up, select
+// and down.
+//
+// Frames drawn with no accel batch since the one before can only come from
+// the interpolation between physics steps. They are counted, and with
+// PBL_MIN_TWEENS=n the run fails when there are fewer than n. At 10 Hz
+// physics and a 50 ms render interval every batch spans four frames:
+//   PBL_TRACE=trace.csv PBL_CLICKS=1000u,1100u,1200u,1300d,1400d,1500d
+//     PBL_MIN_TWEENS=100 ./accel_discs
+//
+// The background worker runs the same way, built with pebble_worker.h:
+//   cc -O2 -std=gnu99 -Ihost/pebble -Isrc -o mbsda_worker
+//     worker_src/mbsda_worker.c src/AlgMbsda.c src/DecimFix.c src/FftFix.c
+//     src/GoertzelFix.c src/MathFix.c src/RingBuf.c src/qep.c src/qfsm_ini.c
+//     src/qfsm_dis.c src/qfsm_dsn.c src/qf_act.c src/qf_actq.c src/qf_dyn.c
+//     src/qf_gc.c src/qf_mem.c src/qf_ps.c src/qf_run.c host/pebble_host.c
+//   PBL_TRACE=night.csv [PBL_MSG_LOG=1] [PBL_PERSIST=store.bin] ./mbsda_worker
+// It reports the messages sent to the app and the wake-ups per hour.
+// PBL_PERSIST keeps persistent storage in a file, so a second run on a
+// later trace sees what the first one wrote.
+//
+// The trace has one "timestamp_ms,x,y,z" sample per line, as recorded for
+// host/mbsda_exec.c. It is resampled at whatever rate the app asks for.
+// Taps are not simulated.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "pebble.h"
+
+#define MAX_TIMERS 16
+#define MAX_BATCH 100
+#define MAX_CLICKS 64
+#define MAX_PERSIST 32
+
+struct Layer {
+  GRect frame;
+  LayerUpdateProc update_proc;
+  Layer *first_child;
+  Layer *next_sibling;
+};
+
+struct Window {
+  Layer root;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config_provider;
+  ClickHandler click_handlers[NUM_BUTTONS];
+  GColor background_color;
+  bool loaded;
+};
+
+struct GContext {
+  GColor fill_color;
+  GCompOp comp_op;
+  GPoint offset;
+  GRect clip;
+};
+
+struct AppTimer {
+  uint64_t due_ms;
+  AppTimerCallback callback;
+  void *data;
+  bool active;
+};
+
+typedef struct ScriptedClick {
+  uint64_t time_ms;
+  ButtonId button;
+} ScriptedClick;
+
+typedef struct PersistValue {
+  uint32_t key;
+  uint32_t size;
+  bool used;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistValue;
+
+typedef struct TraceSample {
+  uint64_t timestamp;
+  int16_t x;
+  int16_t y;
+  int16_t z;
+} TraceSample;
+
+// 0 is black, 1 is white, as on the display
+static uint8_t s_framebuffer[SCREEN_HEIGHT][SCREEN_WIDTH];
+
+static Window *s_window;
+
+static bool s_dirty;
+
+static uint64_t s_now_ms;
+
+static AppTimer s_timers[MAX_TIMERS];
+
+static TraceSample *s_trace;
+
+static size_t s_trace_len;
+
+static size_t s_trace_pos;
+
+static AccelDataHandler s_data_handler;
+
+static uint32_t s_samples_per_update;
+
+static AccelSamplingRate s_sampling_rate = ACCEL_SAMPLING_25HZ;
+
+static AccelData s_batch[MAX_BATCH];
+
+static uint32_t s_batch_len;
+
+static ScriptedClick s_clicks[MAX_CLICKS];
+
+static int s_num_clicks;
+
+static int s_next_click;
+
+static uint64_t s_messages;
+
+static bool s_log_messages;
+
+static PersistValue s_persist[MAX_PERSIST];
+
+static bool s_persist_loaded;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Geometry and drawing
+
+bool grect_equal(const GRect *const rect_a, const GRect *const rect_b) {
+  return rect_a->origin.x == rect_b->origin.x && rect_a->origin.y == rect_b->origin.y
+    && rect_a->size.w == rect_b->size.w && rect_a->size.h == rect_b->size.h;
+}
+
+static void put_pixel(GContext *ctx, int x, int y, bool src) {
+  x += ctx->offset.x;
+  y += ctx->offset.y;
+  if (x < ctx->clip.origin.x || x >= ctx->clip.origin.x + ctx->clip.size.w
+    || y < ctx->clip.origin.y || y >= ctx->clip.origin.y + ctx->clip.size.h) {
+    return;
+  }
+  uint8_t *dst = &s_framebuffer[y][x];
+  switch (ctx->comp_op) {
+    case GCompOpAssign: *dst = src; break;
+    case GCompOpAssignInverted: *dst = !src; break;
+    case GCompOpOr: *dst |= src; break;
+    case GCompOpAnd: *dst &= src; break;
+    case GCompOpClear: *dst &= !src; break;
+    case GCompOpSet: *dst |= !src; break;
+  }
+}
+
+static void fill_pixel(GContext *ctx, int x, int y) {
+  // Fills ignore the compositing mode, as on the watch
+  if (ctx->fill_color == GColorClear) {
+    return;
+  }
+  const GCompOp op = ctx->comp_op;
+  ctx->comp_op = GCompOpAssign;
+  put_pixel(ctx, x, y, ctx->fill_color == GColorWhite);
+  ctx->comp_op = op;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->comp_op = mode;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  // Corners are left square
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+    for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++) {
+      fill_pixel(ctx, x, y);
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  const int r = radius;
+  for (int dy = -r; dy <= r; dy++) {
+    for (int dx = -r; dx <= r; dx++) {
+      if (dx * dx + dy * dy <= r * r + r) {
+        fill_pixel(ctx, p.x + dx, p.y + dy);
+      }
+    }
+  }
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  // The bitmap is tiled over the rect
+  const uint8_t *bits = bitmap->addr;
+  const int w = bitmap->bounds.size.w;
+  const int h = bitmap->bounds.size.h;
+  for (int y = 0; y < rect.size.h; y++) {
+    const uint8_t *row = bits + (y % h) * bitmap->row_size_bytes;
+    for (int x = 0; x < rect.size.w; x++) {
+      const int bx = x % w;
+      put_pixel(ctx, rect.origin.x + x, rect.origin.y + y, (row[bx >> 3] >> (bx & 7)) & 1);
+    }
+  }
+}
+
+GBitmap *gbitmap_create_blank(GSize size) {
+  GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  // Rows are padded to 32 bits as on the watch
+  bitmap->row_size_bytes = ((size.w + 31) / 32) * 4;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->addr = calloc(size.h, bitmap->row_size_bytes);
+  if (!bitmap->addr) {
+    free(bitmap);
+    return NULL;
+  }
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (bitmap) {
+    free(bitmap->addr);
+    free(bitmap);
+  }
+}
+
+// Layers and windows
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = calloc(1, sizeof(Layer));
+  if (layer) {
+    layer->frame = frame;
+  }
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  Layer **link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  s_dirty = true;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  if (window) {
+    window->root.frame = GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    window->background_color = GColorWhite;
+  }
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (window->loaded && window->handlers.unload) {
+    window->handlers.unload(window);
+  }
+  if (s_window == window) {
+    s_window = NULL;
+  }
+  free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+  window->click_config_provider = click_config_provider;
+  if (s_window == window) {
+    click_config_provider(window);
+  }
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  // Only valid from the click config provider of the top window
+  s_window->click_handlers[button_id] = handler;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  s_window = window;
+  if (window->click_config_provider) {
+    window->click_config_provider(window);
+  }
+  if (!window->loaded && window->handlers.load) {
+    window->handlers.load(window);
+  }
+  window->loaded = true;
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+  s_dirty = true;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root;
+}
+
+static void render_layer(Layer *layer, GPoint origin) {
+  GContext ctx = {
+    .fill_color = GColorBlack,
+    .comp_op = GCompOpAssign,
+    .offset = GPoint(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y),
+  };
+  ctx.clip = GRect(ctx.offset.x, ctx.offset.y, layer->frame.size.w, layer->frame.size.h);
+  if (layer->update_proc) {
+    layer->update_proc(layer, &ctx);
+  }
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    render_layer(child, ctx.offset);
+  }
+}
+
+static void render(void) {
+  if (s_window->background_color != GColorClear) {
+    memset(s_framebuffer, s_window->background_color == GColorWhite, sizeof(s_framebuffer));
+  }
+  render_layer(&s_window->root, GPoint(0, 0));
+  s_dirty = false;
+}
+
+static void dump_frame(const char *dir, unsigned frame) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/frame_%05u.pbm", dir, frame);
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return;
+  }
+  // PBM bits are 1 for black, most significant bit leftmost
+  fprintf(f, "P4\n%d %d\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (int y = 0; y < SCREEN_HEIGHT; y++) {
+    uint8_t row[(SCREEN_WIDTH + 7) / 8] = { 0 };
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+      if (!s_framebuffer[y][x]) {
+        row[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+    fwrite(row, 1, sizeof(row), f);
+  }
+  fclose(f);
+}
+
+// Timers
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    if (!s_timers[i].active) {
+      s_timers[i] = (AppTimer) {
+        .due_ms = s_now_ms + timeout_ms,
+        .callback = callback,
+        .data = callback_data,
+        .active = true,
+      };
+      return &s_timers[i];
+    }
+  }
+  return NULL;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (timer_handle) {
+    timer_handle->active = false;
+  }
+}
+
+static AppTimer *next_timer(void) {
+  AppTimer *next = NULL;
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    if (s_timers[i].active && (!next || s_timers[i].due_ms < next->due_ms)) {
+      next = &s_timers[i];
+    }
+  }
+  return next;
+}
+
+// Buttons
+
+static void clicks_load(const char *script) {
+  while (script && *script && s_num_clicks < MAX_CLICKS) {
+    char *end;
+    const unsigned long long t = strtoull(script, &end, 10);
+    const ButtonId button = *end == 'u' ? BUTTON_ID_UP
+      : (*end == 'd' ? BUTTON_ID_DOWN : BUTTON_ID_SELECT);
+    s_clicks[s_num_clicks++] = (ScriptedClick) { t, button };
+    script = strchr(end, ',');
+    if (script) {
+      script++;
+    }
+  }
+}
+
+static void click(ButtonId button) {
+  if (s_window && s_window->click_handlers[button]) {
+    s_window->click_handlers[button](NULL, s_window);
+  }
+}
+
+// Accelerometer
+
+static void trace_load(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  size_t cap = 4096;
+  s_trace = malloc(cap * sizeof(TraceSample));
+  char line[128];
+  while (s_trace && fgets(line, sizeof(line), f)) {
+    unsigned long long ts;
+    int x, y, z;
+    if (sscanf(line, "%llu,%d,%d,%d", &ts, &x, &y, &z) != 4) {
+      continue;
+    }
+    if (s_trace_len == cap) {
+      cap *= 2;
+      s_trace = realloc(s_trace, cap * sizeof(TraceSample));
+      if (!s_trace) {
+        break;
+      }
+    }
+    s_trace[s_trace_len++] = (TraceSample) { ts, x, y, z };
+  }
+  fclose(f);
+  if (!s_trace || s_trace_len == 0) {
+    fprintf(stderr, "%s: no samples\n", path);
+    exit(1);
+  }
+}
+
+static AccelData trace_sample(void) {
+  // Latest recorded sample at the current time
+  while (s_trace_pos + 1 < s_trace_len && s_trace[s_trace_pos + 1].timestamp <= s_now_ms) {
+    s_trace_pos++;
+  }
+  const TraceSample *sample = &s_trace[s_trace_pos];
+  return (AccelData) {
+    .x = sample->x,
+    .y = sample->y,
+    .z = sample->z,
+    .did_vibrate = false,
+    .timestamp = s_now_ms,
+  };
+}
+
+int accel_service_peek(AccelData *data) {
+  *data = trace_sample();
+  return 0;
+}
+
+void accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler) {
+  s_data_handler = handler;
+  s_samples_per_update = samples_per_update < 1 ? 1
+    : (samples_per_update > MAX_BATCH ? MAX_BATCH : samples_per_update);
+  s_batch_len = 0;
+}
+
+void accel_data_service_unsubscribe(void) {
+  s_data_handler = NULL;
+  s_batch_len = 0;
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate) {
+  s_sampling_rate = rate;
+  return 0;
+}
+
+int accel_service_set_samples_per_update(uint32_t num_samples) {
+  s_samples_per_update = num_samples < 1 ? 1
+    : (num_samples > MAX_BATCH ? MAX_BATCH : num_samples);
+  return 0;
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+}
+
+void accel_tap_service_unsubscribe(void) {
+}
+
+// Worker messaging. The app side accepts everything, the worker side
+// counts what it sends and prints it with PBL_MSG_LOG set.
+
+AppWorkerResult app_worker_launch(void) {
+  return APP_WORKER_RESULT_SUCCESS;
+}
+
+AppWorkerResult app_worker_kill(void) {
+  return APP_WORKER_RESULT_SUCCESS;
+}
+
+bool app_worker_is_running(void) {
+  return false;
+}
+
+bool app_worker_message_subscribe(AppWorkerMessageHandler handler) {
+  return true;
+}
+
+bool app_worker_message_unsubscribe(void) {
+  return true;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data) {
+  s_messages++;
+  if (s_log_messages) {
+    printf("msg %llu %u %u %u %u\n", (unsigned long long)s_now_ms, type,
+        data->data0, data->data1, data->data2);
+  }
+}
+
+// Persistent storage. The whole store is read from PBL_PERSIST on first
+// use and written back after every change.
+
+static PersistValue *persist_find(uint32_t key) {
+  if (!s_persist_loaded) {
+    const char *path = getenv("PBL_PERSIST");
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (f) {
+      if (fread(s_persist, sizeof(s_persist), 1, f) != 1) {
+        memset(s_persist, 0, sizeof(s_persist));
+      }
+      fclose(f);
+    }
+    s_persist_loaded = true;
+  }
+  for (int i = 0; i < MAX_PERSIST; i++) {
+    if (s_persist[i].used && s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+  }
+  return NULL;
+}
+
+static void persist_store(void) {
+  const char *path = getenv("PBL_PERSIST");
+  FILE *f = path ? fopen(path, "wb") : NULL;
+  if (f) {
+    fwrite(s_persist, sizeof(s_persist), 1, f);
+    fclose(f);
+  }
+}
+
+bool persist_exists(const uint32_t key) {
+  return persist_find(key) != NULL;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  const PersistValue *value = persist_find(key);
+  if (!value) {
+    return E_DOES_NOT_EXIST;
+  }
+  const size_t size = value->size < buffer_size ? value->size : buffer_size;
+  memcpy(buffer, value->data, size);
+  return (int)size;
+}
+
+status_t persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  if (size > PERSIST_DATA_MAX_LENGTH) {
+    return E_INVALID_ARGUMENT;
+  }
+  PersistValue *value = persist_find(key);
+  for (int i = 0; !value && i < MAX_PERSIST; i++) {
+    if (!s_persist[i].used) {
+      value = &s_persist[i];
+    }
+  }
+  if (!value) {
+    return E_OUT_OF_STORAGE;
+  }
+  *value = (PersistValue) { .key = key, .size = size, .used = true };
+  memcpy(value->data, data, size);
+  persist_store();
+  return (status_t)size;
+}
+
+status_t persist_delete(const uint32_t key) {
+  PersistValue *value = persist_find(key);
+  if (!value) {
+    return E_DOES_NOT_EXIST;
+  }
+  value->used = false;
+  persist_store();
+  return S_SUCCESS;
+}
+
+// System
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  const uint16_t ms = s_now_ms % 1000;
+  if (t_utc) {
+    *t_utc = (time_t)(s_now_ms / 1000);
+  }
+  if (out_ms) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+time_t pbl_override_time(time_t *tloc) {
+  const time_t t = (time_t)(s_now_ms / 1000);
+  if (tloc) {
+    *tloc = t;
+  }
+  return t;
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  va_list args;
+  fprintf(stderr, "[%llu] %s:%d ", (unsigned long long)s_now_ms, src_filename, src_line_number);
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+static void event_loop(bool is_worker) {
+  const char *trace_path = getenv("PBL_TRACE");
+  const char *dump_dir = getenv("PBL_DUMP_DIR");
+  const char *dump_every_env = getenv("PBL_DUMP_EVERY");
+  const unsigned dump_every = dump_every_env ? (unsigned)atoi(dump_every_env) : 1;
+  const char *min_tweens_env = getenv("PBL_MIN_TWEENS");
+  s_log_messages = getenv("PBL_MSG_LOG") != NULL;
+  clicks_load(getenv("PBL_CLICKS"));
+
+  if (!trace_path) {
+    fprintf(stderr, "set PBL_TRACE to a timestamp,x,y,z accel trace\n");
+    exit(1);
+  }
+  trace_load(trace_path);
+
+  uint64_t batches = 0, samples = 0, frames = 0, tweens = 0, wakeups = 0;
+  bool batch_since_frame = true;
+  uint64_t handler_ns = 0, render_ns = 0;
+
+  s_now_ms = s_trace[0].timestamp;
+  uint64_t next_sample_ms = s_now_ms;
+  const uint64_t end_ms = s_trace[s_trace_len - 1].timestamp;
+
+  for (;;) {
+    AppTimer *timer = next_timer();
+    if (s_next_click < s_num_clicks && s_clicks[s_next_click].time_ms <= next_sample_ms
+      && (!timer || s_clicks[s_next_click].time_ms <= timer->due_ms)) {
+      s_now_ms = s_clicks[s_next_click].time_ms;
+      click(s_clicks[s_next_click++].button);
+      wakeups++;
+    } else if (timer && timer->due_ms <= next_sample_ms) {
+      s_now_ms = timer->due_ms;
+      if (s_now_ms > end_ms) {
+        break;
+      }
+      timer->active = false;
+      timer->callback(timer->data);
+      wakeups++;
+    } else {
+      s_now_ms = next_sample_ms;
+      if (s_now_ms > end_ms) {
+        break;
+      }
+      next_sample_ms += 1000 / s_sampling_rate;
+      if (s_data_handler) {
+        s_batch[s_batch_len++] = trace_sample();
+        if (s_batch_len >= s_samples_per_update) {
+          const uint32_t n = s_batch_len;
+          s_batch_len = 0;
+          const uint64_t t0 = now_ns();
+          s_data_handler(s_batch, n);
+          handler_ns += now_ns() - t0;
+          batches++;
+          batch_since_frame = true;
+          samples += n;
+          wakeups++;
+        }
+      }
+    }
+
+    if (s_dirty && s_window) {
+      const uint64_t t0 = now_ns();
+      render();
+      render_ns += now_ns() - t0;
+      if (dump_dir && dump_every && frames % dump_every == 0) {
+        dump_frame(dump_dir, (unsigned)frames);
+      }
+      frames++;
+      if (!batch_since_frame) {
+        tweens++;
+      }
+      batch_since_frame = false;
+    }
+  }
+
+  const double hours = (end_ms - s_trace[0].timestamp) / 3600000.0;
+  printf("trace    %zu samples, %.1f s\n", s_trace_len, hours * 3600.0);
+  printf("accel    %llu batches, %llu samples, %.0f ns per sample\n",
+      (unsigned long long)batches, (unsigned long long)samples,
+      samples ? (double)handler_ns / samples : 0.0);
+  printf("wake-ups %llu, %.0f per hour\n", (unsigned long long)wakeups,
+      hours > 0.0 ? wakeups / hours : 0.0);
+  if (is_worker) {
+    printf("messages %llu, %.1f per hour\n", (unsigned long long)s_messages,
+        hours > 0.0 ? s_messages / hours : 0.0);
+  } else {
+    printf("render   %llu frames, %llu between batches, %.0f ns per frame\n",
+        (unsigned long long)frames, (unsigned long long)tweens,
+        frames ? (double)render_ns / frames : 0.0);
+    if (min_tweens_env && tweens < (uint64_t)atoll(min_tweens_env)) {
+      fprintf(stderr, "%llu frames between batches, expected at least %s\n",
+          (unsigned long long)tweens, min_tweens_env);
+      exit(1);
+    }
+  }
+}
+
+void app_event_loop(void) {
+  event_loop(false);
+}
+
+void worker_event_loop(void) {
+  event_loop(true);
+}
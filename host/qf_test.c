@@ -0,0 +1,920 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  qf_test.c
+
+@brief  @b Description: @n
+   Host checks of the QF active object layer in src/qf_*.c, built for
+   QF_HOST. Each suite prints what it checked.
+
+   Build:  cc -O2 -DQF_HOST -Isrc -o qf_test host/qf_test.c src/qf_act.c
+              src/qf_actq.c src/qf_dyn.c src/qf_gc.c src/qf_mem.c
+              src/qf_ps.c src/qf_run.c src/qep.c src/qfsm_ini.c
+              src/qfsm_dis.c src/qfsm_dsn.c -lpthread
+           Add -DQ_SPY and src/qs.c to compare the QS traces in dsn.
+   Usage:  qf_test [suite ...]
+
+      run   posting, publishing and the scheduler: processing order of
+            QF_runOne() on one thread, QF_run() on its own thread fed by
+            producer threads, and QF_stop() before QF_run() starts
+      pool  QMPool_get()/QMPool_put() and Q_NEW_X()/QF_gc() from many
+            threads at once: no block handed out twice, the margin kept,
+            every block back on the free list at the end
+      dsn   QFsm_dispatchN() against one QFsm_dispatch_() per event on the
+            same events: same actions in the same states, same final
+            state and, built with Q_SPY, the same QS trace byte for byte
+
+   Without arguments every suite runs. The exit status is non-zero if any
+   suite failed, a QF assertion exits with 2.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "qf_port.h"
+#include "qf_pkg.h"
+#include "qassert.h"
+#ifdef Q_SPY
+   #include "qs_port.h"
+#endif
+
+#define TEST_QUEUE_LEN   64
+#define TEST_POOL_LEN    64
+#define TEST_LOG_LEN     32
+#define TEST_PRODUCERS   4
+#define TEST_EVENTS      20000  // Per producer
+#define TEST_PUB_EVERY   16     // One event in this many is published
+#define TEST_TIMEOUT_S   10
+#define TEST_THREADS     8
+#define TEST_ROUNDS      200000 // Per thread
+#define TEST_HOLD        4      // Blocks a thread holds at most
+#define TEST_MARGIN      2
+#define TEST_BLOCKS      16
+#define TEST_SLOTS       4      // Hand-off slots between threads
+#define TEST_FSM_EVENTS  4000
+#define TEST_FSM_BATCH   25     // Largest run given to QFsm_dispatchN()
+#define TEST_FSM_LOG     (3*TEST_FSM_EVENTS)
+#define TEST_QS_SIZE     (1 << 18)
+
+enum TestSignals
+{
+   TEST_POST_SIG = Q_USER_SIG,
+   TEST_PUB_SIG,
+   TEST_STAY_SIG,               // Internal transition
+   TEST_FLIP_SIG,               // Transition to the other state
+   TEST_GUARD_SIG,              // Unhandled by a guard
+   TEST_OTHER_SIG,              // Ignored
+
+   TEST_MAX_SIG
+};
+
+typedef struct TestEvtTag
+{
+   QEvt     super;
+   uint32_t seq;  // Sequence number within the producer
+   uint8_t  src;  // Producer
+
+} TestEvt;
+
+typedef struct TestAoTag
+{
+   QActive  super;
+   uint32_t numPost;                    // TEST_POST_SIG events processed
+   uint32_t numPub;                     // TEST_PUB_SIG events processed
+   uint32_t next[TEST_PRODUCERS];       // Next sequence number expected
+   uint32_t outOfOrder;                 // Events from a producer out of FIFO
+
+} TestAo;
+
+typedef struct TestBlockTag
+{
+   TestEvt  evt;    // Header when the block is an event
+   uint32_t owner;  // Thread that took the block
+
+} TestBlock;
+
+typedef struct TestFsmTag
+{
+   QFsm     super;
+   uint16_t log[TEST_FSM_LOG];  // State << 8 | signal of every action
+   uint32_t logLen;
+
+} TestFsm;
+
+typedef struct TestXlEvtTag     // Laid out like an accelerometer sample
+{
+   QEvt     super;
+   uint32_t timeStamp;
+   int16_t  x, y, z;
+
+} TestXlEvt;
+
+typedef struct TestSuiteTag
+{
+   const char *name;
+   int       (*run)(void);
+
+} TestSuite;
+
+static TestAo      l_lo;    // Priority 1
+static TestAo      l_hi;    // Priority 2
+static QEQueueSlot l_loQSto[TEST_QUEUE_LEN];
+static QEQueueSlot l_hiQSto[TEST_QUEUE_LEN];
+static QSubscrList l_subscrSto[TEST_MAX_SIG];
+static QF_MPOOL_EL(TestEvt) l_poolSto[TEST_POOL_LEN];
+
+static QMPool    l_pool;
+static QF_MPOOL_EL(TestBlock) l_blockSto[TEST_BLOCKS];
+Q_ASSERT_COMPILE(TEST_BLOCKS <= 32);         // testPoolRun() bit set
+
+static QMPool   *l_stress;                   // Pool under the stress test
+static uint32_t  l_owner[TEST_BLOCKS];       // Thread + 1 holding each block
+static TestBlock *l_slot[TEST_SLOTS];        // Blocks handed between threads
+static uint32_t  l_poolErrors;
+static bool      l_poolEvents;               // Q_NEW_X()/QF_gc() or QMPool
+
+static uint32_t l_log[TEST_LOG_LEN]; // prio << 16 | sig << 8 | seq
+static uint32_t l_logLen;
+
+static TestFsm   l_fsm;      // The same object both ways, as QS logs it
+static uint16_t  l_fsmLog[2][TEST_FSM_LOG];
+static uint32_t  l_fsmLogLen[2];
+static QStateHandler l_fsmFinal[2];
+static TestXlEvt l_fsmEvts[TEST_FSM_EVENTS];
+#ifdef Q_SPY
+static uint8_t   l_qsSto[TEST_QS_SIZE];
+static uint8_t   l_qsOut[2][TEST_QS_SIZE];
+static QSTimeCtr l_qsTime;
+#endif
+
+static QState testAoInitial(TestAo * const me, QEvt const * const e);
+static QState testAoActive (TestAo * const me, QEvt const * const e);
+static QState testFsmInitial(TestFsm * const me, QEvt const * const e);
+static QState testFsmA      (TestFsm * const me, QEvt const * const e);
+static QState testFsmB      (TestFsm * const me, QEvt const * const e);
+
+void Q_onAssert(char_t const Q_ROM * const file, int_t line)
+{
+   fprintf(stderr, "assertion failed: %s:%d\n", file, (int)line);
+   exit(2);
+}
+
+static void testTimeout(int sig)
+{
+   (void)sig;
+   fprintf(stderr, "timed out\n");
+   _exit(3);
+}
+
+QState testAoInitial(TestAo * const me, QEvt const * const e)
+{
+   (void)e;
+   return Q_TRAN(&testAoActive);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testAoActive
+@endinternal
+
+@b Description: @n
+    Only state of the test active objects. Counts the events, checks they
+    arrive in the order each producer sent them and logs the first ones.
+
+*******************************************************************************/
+QState testAoActive(TestAo * const me, QEvt const * const e)
+{
+   TestEvt const *te = (TestEvt const *)e;
+
+   switch(e->sig)
+   {
+      case TEST_POST_SIG:
+      case TEST_PUB_SIG:
+         if(e->sig == TEST_POST_SIG)
+         {
+            __atomic_store_n(&me->numPost, me->numPost + 1, __ATOMIC_RELEASE);
+         }
+         else
+         {
+            __atomic_store_n(&me->numPub, me->numPub + 1, __ATOMIC_RELEASE);
+         }
+         if(te->seq < me->next[te->src])
+         {
+            me->outOfOrder++;
+         }
+         me->next[te->src] = te->seq + 1;
+         if(l_logLen < TEST_LOG_LEN)
+         {
+            l_log[l_logLen++] = ((uint32_t)me->super.prio << 16) |
+                                ((uint32_t)e->sig << 8) | (te->seq & 0xFF);
+         }
+         return Q_HANDLED();
+   }
+   return Q_IGNORED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testStart
+@endinternal
+
+@b Description: @n
+    Fresh QF with one event pool of TestEvt and the two active objects,
+    both subscribed to TEST_PUB_SIG.
+
+*******************************************************************************/
+static void testStart(void)
+{
+   memset(&l_lo, 0, sizeof(l_lo));
+   memset(&l_hi, 0, sizeof(l_hi));
+   l_logLen = 0;
+
+   QF_init();
+   QF_psInit(l_subscrSto, TEST_MAX_SIG);
+   QF_poolInit(l_poolSto, sizeof(l_poolSto), sizeof(l_poolSto[0]));
+
+   QActive_ctor(&l_lo.super, (QStateHandler)&testAoInitial);
+   QActive_ctor(&l_hi.super, (QStateHandler)&testAoInitial);
+   QActive_start(&l_lo.super, 1, l_loQSto, TEST_QUEUE_LEN, (QEvt *)0);
+   QActive_start(&l_hi.super, 2, l_hiQSto, TEST_QUEUE_LEN, (QEvt *)0);
+   QActive_subscribe(&l_lo.super, TEST_PUB_SIG);
+   QActive_subscribe(&l_hi.super, TEST_PUB_SIG);
+}
+
+static TestEvt *testNew(QSignal sig, uint8_t src, uint32_t seq)
+{
+   TestEvt *te;
+
+   Q_NEW_X(te, TestEvt, 1, sig);
+   if(te != (TestEvt *)0)
+   {
+      te->src = src;
+      te->seq = seq;
+   }
+   return te;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testProducer
+@endinternal
+
+@b Description: @n
+    Producer thread: posts TEST_EVENTS events alternately to l_hi and
+    l_lo, publishing one in TEST_PUB_EVERY instead. Retries while the pool
+    or a queue is short.
+
+*******************************************************************************/
+static void *testProducer(void *arg)
+{
+   uint8_t  src = (uint8_t)(uintptr_t)arg;
+   uint32_t seq;
+   TestEvt *te;
+   bool     pub;
+
+   for(seq = 0; seq < TEST_EVENTS; seq++)
+   {
+      pub = (seq % TEST_PUB_EVERY) == 0;
+      while((te = testNew(pub ? TEST_PUB_SIG : TEST_POST_SIG, src, seq)) ==
+            (TestEvt *)0)
+      {
+         sched_yield();
+      }
+      if(pub)
+      {
+         QF_PUBLISH(&te->super, 0);
+         continue;
+      }
+      while(!QACTIVE_POST_X((seq & 1) ? &l_lo.super : &l_hi.super,
+                            &te->super, 1))
+      {
+         sched_yield();
+      }
+   }
+   return NULL;
+}
+
+static void *testScheduler(void *arg)
+{
+   (void)arg;
+   (void)QF_run();
+   return NULL;
+}
+
+static uint32_t testProcessed(TestAo *ao)
+{
+   return __atomic_load_n(&ao->numPost, __ATOMIC_ACQUIRE) +
+          __atomic_load_n(&ao->numPub, __ATOMIC_ACQUIRE);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testRun
+@endinternal
+
+@b Description: @n
+    On one thread, QF_runOne() has to take the events of l_hi before
+    those of l_lo and each queue in order, deliver a published event to
+    both and return every event to its pool. With QF_run() on its own
+    thread, TEST_PRODUCERS threads posting and publishing at once must get
+    every event delivered once and in order per producer, and QF_stop()
+    must end it. A QF_stop() before QF_run() must make it return at once.
+
+*******************************************************************************/
+static int testRun(void)
+{
+   static const uint32_t expect[] =
+   {
+      (2 << 16) | (TEST_POST_SIG << 8) | 0,
+      (2 << 16) | (TEST_POST_SIG << 8) | 1,
+      (2 << 16) | (TEST_PUB_SIG  << 8) | 2,
+      (1 << 16) | (TEST_POST_SIG << 8) | 0,
+      (1 << 16) | (TEST_POST_SIG << 8) | 1,
+      (1 << 16) | (TEST_PUB_SIG  << 8) | 2,
+   };
+   static TestEvt const stat = { { TEST_POST_SIG, 0, 0 }, 0, 0 };
+   pthread_t sched;
+   pthread_t prod[TEST_PRODUCERS];
+   QMPool   *pool = &QF_pool_[0];
+   uint32_t  i;
+   uint32_t  wantLo;
+   uint32_t  wantHi;
+   int       ok;
+   int       failed = 0;
+
+   signal(SIGALRM, testTimeout);
+
+   // Order on one thread
+   testStart();
+   QACTIVE_POST(&l_lo.super, &testNew(TEST_POST_SIG, 0, 0)->super);
+   QACTIVE_POST(&l_lo.super, &testNew(TEST_POST_SIG, 0, 1)->super);
+   QACTIVE_POST(&l_hi.super, &testNew(TEST_POST_SIG, 0, 0)->super);
+   QACTIVE_POST(&l_hi.super, &testNew(TEST_POST_SIG, 0, 1)->super);
+   QF_PUBLISH(&testNew(TEST_PUB_SIG, 0, 2)->super, 0);
+   while(QF_runOne())
+   {
+   }
+   ok = (l_logLen == sizeof(expect)/sizeof(expect[0])) &&
+        (memcmp(l_log, expect, sizeof(expect)) == 0) &&
+        (pool->nFree == pool->nTot) &&
+        (QF_getPoolMin(1) == pool->nTot - 5);
+
+   // A full queue refuses a post with a margin, not a static event
+   for(i = 0; i < TEST_QUEUE_LEN - 1; i++)
+   {
+      QACTIVE_POST(&l_lo.super, &stat.super);
+   }
+   ok &= !QACTIVE_POST_X(&l_lo.super, &stat.super, 1);
+   ok &= QACTIVE_POST_X(&l_lo.super, &stat.super, 0);
+   while(QF_runOne())
+   {
+   }
+   ok &= (l_lo.numPost == 2 + TEST_QUEUE_LEN);
+   failed |= !ok;
+   printf("run    QF_runOne  priority and FIFO order, publish to both, "
+          "post margin on a full queue, pool back to %u of %u  %s\n",
+          (unsigned)pool->nFree, (unsigned)pool->nTot, ok ? "ok" : "FAIL");
+
+   // QF_run fed by producer threads
+   testStart();
+   alarm(TEST_TIMEOUT_S);
+   pthread_create(&sched, NULL, testScheduler, NULL);
+   for(i = 0; i < TEST_PRODUCERS; i++)
+   {
+      pthread_create(&prod[i], NULL, testProducer, (void *)(uintptr_t)i);
+   }
+   for(i = 0; i < TEST_PRODUCERS; i++)
+   {
+      pthread_join(prod[i], NULL);
+   }
+   // Odd events go to l_lo, even ones to l_hi unless published to both
+   wantLo = TEST_PRODUCERS*(TEST_EVENTS/2 + TEST_EVENTS/TEST_PUB_EVERY);
+   wantHi = TEST_PRODUCERS*(TEST_EVENTS/2);
+   while((testProcessed(&l_lo) < wantLo) || (testProcessed(&l_hi) < wantHi))
+   {
+      struct timespec ts = { 0, 1000000 };
+      nanosleep(&ts, NULL);
+   }
+   QF_stop();
+   pthread_join(sched, NULL);
+   alarm(0);
+
+   ok = (testProcessed(&l_lo) == wantLo) && (testProcessed(&l_hi) == wantHi) &&
+        (l_lo.outOfOrder == 0) && (l_hi.outOfOrder == 0) &&
+        (pool->nFree == pool->nTot);
+   failed |= !ok;
+   printf("       QF_run     %u producers, %u + %u events delivered, %u out "
+          "of order, pool back to %u of %u (low %u)  %s\n",
+          TEST_PRODUCERS, (unsigned)testProcessed(&l_hi),
+          (unsigned)testProcessed(&l_lo),
+          (unsigned)(l_lo.outOfOrder + l_hi.outOfOrder),
+          (unsigned)pool->nFree, (unsigned)pool->nTot,
+          (unsigned)QF_getPoolMin(1), ok ? "ok" : "FAIL");
+
+   // QF_stop before QF_run
+   testStart();
+   QF_stop();
+   alarm(TEST_TIMEOUT_S);
+   (void)QF_run();
+   alarm(0);
+   printf("       QF_stop    before QF_run  ok\n");
+
+   return failed;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testPoolTake
+@endinternal
+
+@b Description: @n
+    Marks a block handed out by the pool as held by thread tid. Counts an
+    error if it is still marked as held by anyone.
+
+*******************************************************************************/
+static uint32_t testPoolIdx(TestBlock const *b)
+{
+   return (uint32_t)(((uint8_t const *)b - (uint8_t const *)l_stress->start)/
+                     l_stress->blockSize);
+}
+
+static void testPoolTake(TestBlock *b, uint32_t tid)
+{
+   uint32_t none = 0;
+
+   if(!__atomic_compare_exchange_n(&l_owner[testPoolIdx(b)], &none, tid + 1,
+                                   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+   {
+      __atomic_add_fetch(&l_poolErrors, 1, __ATOMIC_RELAXED);
+   }
+   b->owner = tid;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testPoolGive
+@endinternal
+
+@b Description: @n
+    Clears the mark of a block and returns it to the pool under test, from
+    whichever thread holds it now. Counts an error if the mark does not
+    match the thread that took the block.
+
+*******************************************************************************/
+static void testPoolGive(TestBlock *b)
+{
+   if(__atomic_exchange_n(&l_owner[testPoolIdx(b)], 0, __ATOMIC_ACQ_REL) !=
+      b->owner + 1)
+   {
+      __atomic_add_fetch(&l_poolErrors, 1, __ATOMIC_RELAXED);
+   }
+   if(l_poolEvents)
+   {
+      QF_gc(&b->evt.super);
+   }
+   else
+   {
+      QMPool_put(l_stress, b);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testPoolWorker
+@endinternal
+
+@b Description: @n
+    Thread body of the pool suite: takes up to TEST_HOLD blocks with
+    TEST_MARGIN blocks to spare, either straight from the pool or as events
+    through Q_NEW_X(). Gives them back itself, except on odd rounds the last
+    one, which it swaps into a hand-off slot and gives back the block it
+    finds there, taken by another thread.
+
+*******************************************************************************/
+static void *testPoolWorker(void *arg)
+{
+   uint32_t   tid = (uint32_t)(uintptr_t)arg;
+   TestBlock *held[TEST_HOLD];
+   TestBlock *other;
+   TestEvt   *te;
+   uint32_t   round;
+   uint32_t   n;
+   uint32_t   want;
+
+   for(round = 0; round < TEST_ROUNDS; round++)
+   {
+      want = 1 + (round + tid) % TEST_HOLD;
+      for(n = 0; n < want; n++)
+      {
+         if(l_poolEvents)
+         {
+            // The pool is sized for TestBlock, which starts with a TestEvt
+            Q_NEW_X(te, TestEvt, TEST_MARGIN, TEST_POST_SIG);
+            held[n] = (TestBlock *)te;
+         }
+         else
+         {
+            held[n] = (TestBlock *)QMPool_get(l_stress, TEST_MARGIN);
+         }
+         if(held[n] == (TestBlock *)0)
+         {
+            break;
+         }
+         testPoolTake(held[n], tid);
+      }
+      if((n > 0) && (round & 1))
+      {
+         n--;
+         other = __atomic_exchange_n(&l_slot[(round/2 + tid) % TEST_SLOTS],
+                                     held[n], __ATOMIC_ACQ_REL);
+         if(other != (TestBlock *)0)
+         {
+            testPoolGive(other);
+         }
+      }
+      while(n > 0)
+      {
+         n--;
+         testPoolGive(held[n]);
+      }
+   }
+   return NULL;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testPoolRun
+@endinternal
+
+@b Description: @n
+    Runs TEST_THREADS pool workers on pool and checks it afterwards: no
+    block held twice, never fewer than TEST_MARGIN blocks left, all blocks
+    counted free, and all of them distinct on the free list.
+
+*******************************************************************************/
+static int testPoolRun(const char *what, QMPool *pool)
+{
+   pthread_t thr[TEST_THREADS];
+   void     *b;
+   uint32_t  i;
+   uint32_t  n;
+   uint32_t  taken = 0;
+   uint32_t  listed;
+   uint32_t  low;
+   int       ok;
+
+   memset(l_owner, 0, sizeof(l_owner));
+   l_poolErrors = 0;
+   l_stress     = pool;
+   alarm(TEST_TIMEOUT_S);
+   for(i = 0; i < TEST_THREADS; i++)
+   {
+      pthread_create(&thr[i], NULL, testPoolWorker, (void *)(uintptr_t)i);
+   }
+   for(i = 0; i < TEST_THREADS; i++)
+   {
+      pthread_join(thr[i], NULL);
+   }
+   alarm(0);
+   for(i = 0; i < TEST_SLOTS; i++)
+   {
+      if(l_slot[i] != (TestBlock *)0)
+      {
+         testPoolGive(l_slot[i]);
+         l_slot[i] = (TestBlock *)0;
+      }
+   }
+
+   low = pool->nMin;
+   ok  = (l_poolErrors == 0) && (low >= TEST_MARGIN) &&
+         (pool->nFree == pool->nTot);
+
+   // Every block must come back once from the free list
+   for(n = 0; n < pool->nTot; n++)
+   {
+      b = QMPool_get(pool, 0);
+      if(b == (void *)0)
+      {
+         break;
+      }
+      i = (uint32_t)(((uint8_t *)b - (uint8_t *)pool->start)/pool->blockSize);
+      ok &= (i < 32) && ((taken & (1u << i)) == 0);
+      taken |= 1u << (i & 31);
+   }
+   listed = n;
+   ok &= (listed == pool->nTot) && (QMPool_get(pool, 0) == (void *)0);
+   while(n > 0)
+   {
+      n--;
+      QMPool_put(pool, (uint8_t *)pool->start + n*pool->blockSize);
+   }
+
+   printf("pool   %-9s  %u threads x %u rounds, %u ownership errors, low %u "
+          "(margin %u), %u failed, free list %u of %u  %s\n", what,
+          TEST_THREADS, TEST_ROUNDS, (unsigned)l_poolErrors,
+          (unsigned)low, TEST_MARGIN, (unsigned)pool->nFail,
+          (unsigned)listed, (unsigned)pool->nTot, ok ? "ok" : "FAIL");
+   return !ok;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testPool
+@endinternal
+
+@b Description: @n
+    Pool stress suite: a QMPool used directly, then the QF event pool
+    through Q_NEW_X() and QF_gc(). Both are sized so the threads keep
+    running into the margin.
+
+*******************************************************************************/
+static int testPool(void)
+{
+   int failed = 0;
+
+   signal(SIGALRM, testTimeout);
+
+   l_poolEvents = false;
+   QMPool_init(&l_pool, l_blockSto, sizeof(l_blockSto), sizeof(l_blockSto[0]));
+   failed |= testPoolRun("QMPool", &l_pool);
+
+   l_poolEvents = true;
+   QF_init();
+   QF_poolInit(l_blockSto, sizeof(l_blockSto), sizeof(l_blockSto[0]));
+   failed |= testPoolRun("Q_NEW_X", &QF_pool_[0]);
+
+   return failed;
+}
+
+#ifdef Q_SPY
+QSTimeCtr QS_onGetTime(void)
+{
+   return ++l_qsTime;
+}
+#endif
+
+QState testFsmInitial(TestFsm * const me, QEvt const * const e)
+{
+   (void)e;
+   return Q_TRAN(&testFsmA);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testFsmState
+@endinternal
+
+@b Description: @n
+    Body of both states of the dsn test FSM, id 0 for A and 1 for B. Every
+    action is logged with the state it ran in.
+
+*******************************************************************************/
+static QState testFsmState(TestFsm * const me, QEvt const * const e,
+                           uint16_t id, QStateHandler other)
+{
+   if(me->logLen < TEST_FSM_LOG)
+   {
+      me->log[me->logLen++] = (uint16_t)((id << 8) | e->sig);
+   }
+
+   switch(e->sig)
+   {
+      case Q_ENTRY_SIG:
+      case Q_EXIT_SIG:
+      case TEST_STAY_SIG:
+         return Q_HANDLED();
+      case TEST_FLIP_SIG:
+         return Q_TRAN(other);
+      case TEST_GUARD_SIG:
+         return Q_UNHANDLED();
+      default:
+         return Q_IGNORED();
+   }
+}
+
+QState testFsmA(TestFsm * const me, QEvt const * const e)
+{
+   return testFsmState(me, e, 0, (QStateHandler)&testFsmB);
+}
+
+QState testFsmB(TestFsm * const me, QEvt const * const e)
+{
+   return testFsmState(me, e, 1, (QStateHandler)&testFsmA);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testFsmRun
+@endinternal
+
+@b Description: @n
+    Starts l_fsm and dispatches all of l_fsmEvts to it, in runs of 1 to
+    TEST_FSM_BATCH events through QFsm_dispatchN() for way 0 and one
+    QFsm_dispatch_() per event for way 1. The actions and final state are
+    kept per way. With Q_SPY the trace is drained into l_qsOut[way] and its
+    length returned.
+
+*******************************************************************************/
+static uint32_t testFsmRun(uint32_t way)
+{
+   TestFsm *me   = &l_fsm;
+   uint32_t seed = 777u;
+   uint32_t i, n;
+   uint32_t len  = 0;
+
+#ifdef Q_SPY
+   uint_fast16_t got;
+
+   l_qsTime = 0;
+   QS_initBuf(l_qsSto, sizeof(l_qsSto));
+#endif
+
+   me->logLen = 0;
+   QFsm_ctor(&me->super, (QStateHandler)&testFsmInitial);
+   QMSM_INIT(&me->super, (QEvt *)0);
+
+   for(i = 0; i < TEST_FSM_EVENTS; i += n)
+   {
+      seed = seed*1103515245u + 12345u;
+      n    = 1 + (seed >> 16) % TEST_FSM_BATCH;
+      n    = (n > TEST_FSM_EVENTS - i) ? TEST_FSM_EVENTS - i : n;
+
+      if(way == 0)
+      {
+         QFsm_dispatchN(&me->super, &l_fsmEvts[i].super, (uint_fast16_t)n,
+                        sizeof(l_fsmEvts[0]));
+      }
+      else
+      {
+         uint32_t k;
+
+         for(k = 0; k < n; k++)
+         {
+            QMSM_DISPATCH(&me->super, &l_fsmEvts[i + k].super);
+         }
+      }
+   }
+
+   memcpy(l_fsmLog[way], me->log, sizeof(me->log));
+   l_fsmLogLen[way] = me->logLen;
+   l_fsmFinal[way]  = me->super.state.fun;
+
+#ifdef Q_SPY
+   while((got = QS_drain(&l_qsOut[way][len], 4096)) != 0)
+   {
+      len += got;
+   }
+   if(QS_priv_.dropped != 0)
+   {
+      printf("dsn    FAIL %u QS records dropped\n", (unsigned)QS_priv_.dropped);
+      len = 0;
+   }
+#endif
+   return len;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: testDsn
+@endinternal
+
+@b Description: @n
+    dsn suite: a flat FSM with internal transitions, transitions between
+    two states, guards that leave an event unhandled and ignored signals,
+    fed a random mix of them laid out as accelerometer samples.
+
+*******************************************************************************/
+static int testDsn(void)
+{
+   static const QSignal sigs[] =
+   {
+      TEST_STAY_SIG, TEST_STAY_SIG, TEST_STAY_SIG, TEST_FLIP_SIG,
+      TEST_GUARD_SIG, TEST_OTHER_SIG
+   };
+   uint32_t seed = 12345u;
+   uint32_t i, lenN, len1;
+   uint32_t diff = TEST_FSM_LOG;
+   int      failed;
+
+   memset(l_fsmEvts, 0, sizeof(l_fsmEvts));
+   for(i = 0; i < TEST_FSM_EVENTS; i++)
+   {
+      seed = seed*1103515245u + 12345u;
+      l_fsmEvts[i].super.sig = sigs[(seed >> 16) % (sizeof(sigs)/sizeof(sigs[0]))];
+      l_fsmEvts[i].timeStamp = i*20u;
+   }
+
+   lenN = testFsmRun(0);
+   len1 = testFsmRun(1);
+
+   for(i = 0; i < l_fsmLogLen[0]; i++)
+   {
+      if(l_fsmLog[0][i] != l_fsmLog[1][i])
+      {
+         diff = i;
+         break;
+      }
+   }
+   failed = (l_fsmLogLen[0] != l_fsmLogLen[1]) || (diff != TEST_FSM_LOG) ||
+            (l_fsmFinal[0] != l_fsmFinal[1]);
+   printf("dsn    %u events, %u actions each way, first difference %s, "
+          "final states %s\n", TEST_FSM_EVENTS, (unsigned)l_fsmLogLen[0],
+          (diff == TEST_FSM_LOG) ? "none" : "found",
+          (l_fsmFinal[0] == l_fsmFinal[1]) ? "equal" : "differ");
+
+#ifdef Q_SPY
+   diff = (lenN == len1) ? len1 : 0;
+   for(i = 0; i < diff; i++)
+   {
+      if(l_qsOut[0][i] != l_qsOut[1][i])
+      {
+         diff = i;
+         break;
+      }
+   }
+   failed |= (lenN == 0) || (lenN != len1) || (diff != len1);
+   printf("       QS trace %u and %u bytes, %s\n", (unsigned)lenN,
+          (unsigned)len1, ((lenN != 0) && (lenN == len1) && (diff == len1))
+          ? "identical" : "DIFFERENT");
+#else
+   (void)lenN;
+   (void)len1;
+   printf("       QS trace not compared, build with -DQ_SPY\n");
+#endif
+   printf("       %s\n", failed ? "FAIL" : "ok");
+
+   return failed;
+}
+
+static const TestSuite l_suites[] =
+{
+   { "run",  testRun },
+   { "pool", testPool },
+   { "dsn",  testDsn },
+};
+
+int main(int argc, char *argv[])
+{
+   uint32_t s;
+   int      arg;
+   int      failed = 0;
+
+   setvbuf(stdout, NULL, _IOLBF, 0);
+   if(argc == 1)
+   {
+      for(s = 0; s < sizeof(l_suites)/sizeof(l_suites[0]); s++)
+      {
+         failed |= l_suites[s].run();
+      }
+      return failed;
+   }
+
+   for(arg = 1; arg < argc; arg++)
+   {
+      for(s = 0; s < sizeof(l_suites)/sizeof(l_suites[0]); s++)
+      {
+         if(strcmp(argv[arg], l_suites[s].name) == 0)
+         {
+            failed |= l_suites[s].run();
+            break;
+         }
+      }
+      if(s == sizeof(l_suites)/sizeof(l_suites[0]))
+      {
+         fprintf(stderr, "unknown suite %s\n", argv[arg]);
+         return 1;
+      }
+   }
+
+   return failed;
+}
@@ -0,0 +1,531 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  qs_decode.c
+
+@brief  @b Description: @n
+   Host decoder for the binary QS trace produced by src/qs.c. Reads a dump
+   of drained trace records (QS_drain) and writes a human-readable or CSV
+   timeline, and optionally the time spent per state. The sizes of signals,
+   time stamps and pointers are taken from the session record that opens
+   the trace.
+
+   Build:  cc -O2 -o qs_decode host/qs_decode.c
+   Usage:  qs_decode [-p ptrSize] [-m symbols.txt] [-c] [-s] [dump.bin]
+
+      -p  size in bytes of object/function pointers, only for dumps that
+          lost their session record (4 for the watch, 8 for a QF_HOST
+          build; default 4, with 2-byte signals and 4-byte time stamps)
+      -m  symbol table in 'nm' format (address type name), used to print
+          state handler and object names instead of addresses
+      -c  CSV output: time,record,object,signal,state,target
+      -s  print the accumulated run-to-completion time per state, measured
+          from each DISPATCH record to the record that completes it
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Record types, must match enum QSpyRecords in src/qs.h
+//
+enum
+{
+   QS_EMPTY,
+   QS_QEP_STATE_ENTRY,
+   QS_QEP_STATE_EXIT,
+   QS_QEP_STATE_INIT,
+   QS_QEP_INIT_TRAN,
+   QS_QEP_INTERN_TRAN,
+   QS_QEP_TRAN,
+   QS_QEP_IGNORED,
+   QS_QEP_DISPATCH,
+   QS_QEP_UNHANDLED,
+
+   QS_USER = 70
+};
+
+#define MAX_SYMBOLS 4096
+#define MAX_STATES   256
+#define MAX_OBJECTS  1024
+
+typedef struct SymbolTag
+{
+   uint64_t addr;
+   char     name[64];
+
+} Symbol;
+
+typedef struct StateStatTag
+{
+   uint64_t fun;
+   uint64_t rtcCnt;   // number of completed RTC steps
+   uint64_t rtcTime;  // accumulated RTC time, QS_onGetTime() units
+
+} StateStat;
+
+// DISPATCH of a state machine waiting for the record that completes it
+typedef struct PendingTag
+{
+   uint64_t obj;
+   uint64_t fun;
+   uint32_t time;
+   int      pending;
+
+} Pending;
+
+static Symbol    symbols[MAX_SYMBOLS];
+static int       numSymbols;
+static StateStat states[MAX_STATES];
+static int       numStates;
+
+// Field sizes, from the session record or the defaults of the watch
+static int      sigSize  = 2;
+static int      timeSize = 4;
+static int      ptrSize  = 4;
+static int      funSize  = 4;
+static int      csvOut;
+static int      summary;
+
+// Pending DISPATCH per state machine, closed by its next INTERN_TRAN, TRAN
+// or IGNORED record. Traces of several threads interleave the machines.
+static Pending  pend[MAX_OBJECTS];
+static int      numPend;
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: loadSymbols
+@endinternal
+
+@b Description: @n
+    Reads 'nm' output lines of the form "address type name".
+
+*******************************************************************************/
+static void loadSymbols(const char *path)
+{
+   FILE *f = fopen(path, "r");
+   char line[256];
+
+   if(f == NULL)
+   {
+      perror(path);
+      exit(1);
+   }
+   while((numSymbols < MAX_SYMBOLS) && (fgets(line, sizeof(line), f) != NULL))
+   {
+      unsigned long long addr;
+      char type;
+      char name[64];
+
+      if(sscanf(line, "%llx %c %63s", &addr, &type, name) == 3)
+      {
+         symbols[numSymbols].addr = addr;
+         strcpy(symbols[numSymbols].name, name);
+         numSymbols++;
+      }
+   }
+   fclose(f);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: symName
+@endinternal
+
+@b Description: @n
+    Returns the symbol name for an address, or the address in hex. The
+    Thumb bit of function addresses on the watch is ignored.
+
+*******************************************************************************/
+static const char *symName(uint64_t addr)
+{
+   static char buf[4][32];
+   static int  bufIdx;
+   int i;
+
+   for(i = 0; i < numSymbols; i++)
+   {
+      if((symbols[i].addr == addr) || (symbols[i].addr == (addr & ~1ULL)))
+      {
+         return symbols[i].name;
+      }
+   }
+   bufIdx = (bufIdx + 1) % 4;
+   snprintf(buf[bufIdx], sizeof(buf[0]), "0x%08llX", (unsigned long long)addr);
+   return buf[bufIdx];
+}
+
+static uint32_t getU(const uint8_t **p, int size)
+{
+   uint32_t v = 0;
+   int i;
+
+   for(i = 0; i < size; i++)
+   {
+      v |= (uint32_t)(*p)[i] << (8*i);
+   }
+   *p += size;
+   return v;
+}
+
+static uint64_t getPtr(const uint8_t **p, int size)
+{
+   uint64_t lo = getU(p, 4);
+   uint64_t hi = (size == 8) ? getU(p, 4) : 0;
+
+   return lo | (hi << 32);
+}
+
+static Pending *pending(uint64_t obj)
+{
+   int i;
+
+   for(i = 0; i < numPend; i++)
+   {
+      if(pend[i].obj == obj)
+      {
+         return &pend[i];
+      }
+   }
+   if(numPend == MAX_OBJECTS)
+   {
+      return NULL;
+   }
+   pend[numPend].obj     = obj;
+   pend[numPend].pending = 0;
+   return &pend[numPend++];
+}
+
+static StateStat *stateStat(uint64_t fun)
+{
+   int i;
+
+   for(i = 0; i < numStates; i++)
+   {
+      if(states[i].fun == fun)
+      {
+         return &states[i];
+      }
+   }
+   if(numStates == MAX_STATES)
+   {
+      return NULL;
+   }
+   states[numStates].fun = fun;
+   return &states[numStates++];
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: closeRtc
+@endinternal
+
+@b Description: @n
+    Accounts the time from the pending DISPATCH of obj to the current record
+    to the state that processed the event.
+
+*******************************************************************************/
+static void closeRtc(uint64_t obj, uint32_t time)
+{
+   Pending *pd = pending(obj);
+
+   if((pd != NULL) && pd->pending)
+   {
+      StateStat *st = stateStat(pd->fun);
+
+      if(st != NULL)
+      {
+         st->rtcCnt++;
+         // Time stamps of 2 bytes wrap at 2^16
+         st->rtcTime += (uint32_t)(time - pd->time) &
+                        ((timeSize == 2) ? 0xFFFFu : 0xFFFFFFFFu);
+      }
+      pd->pending = 0;
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: emit
+@endinternal
+
+@b Description: @n
+    Prints one decoded QEP record as a text or CSV line. Fields that the
+    record does not carry are passed as negative/zero and left empty.
+
+*******************************************************************************/
+static void emit(const char *recName, int64_t time, uint64_t obj,
+                 int32_t sig, uint64_t state, uint64_t target)
+{
+   char timeStr[16] = "";
+   char sigStr[16]  = "";
+
+   if(summary)
+   {
+      return;
+   }
+   if(time >= 0)
+   {
+      snprintf(timeStr, sizeof(timeStr), "%010lu", (unsigned long)time);
+   }
+   if(sig >= 0)
+   {
+      snprintf(sigStr, sizeof(sigStr), "%ld", (long)sig);
+   }
+   if(csvOut)
+   {
+      printf("%s,%s,%s,%s,%s,%s\n", timeStr, recName, symName(obj), sigStr,
+             symName(state), (target != 0) ? symName(target) : "");
+   }
+   else
+   {
+      printf("%10s %-12s Obj=%s", timeStr, recName, symName(obj));
+      if(sig >= 0)
+      {
+         printf(" Sig=%s", sigStr);
+      }
+      printf(" State=%s", symName(state));
+      if(target != 0)
+      {
+         printf(" -> %s", symName(target));
+      }
+      printf("\n");
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: emitUser
+@endinternal
+
+@b Description: @n
+    Prints an application-specific record, whose data items each carry a
+    format byte (type in the low nibble, display width in the high nibble).
+
+*******************************************************************************/
+static void emitUser(uint8_t rec, const uint8_t *p, const uint8_t *end)
+{
+   if(summary)
+   {
+      return;
+   }
+   printf(csvOut ? ",USER%u" : "           USER%-8u", rec - QS_USER);
+   while(p < end)
+   {
+      uint8_t fmt   = *p++;
+      int     width = fmt >> 4;
+      long    v;
+
+      switch(fmt & 0x0F)
+      {
+         case 0:  v = (int8_t)getU(&p, 1);   break;
+         case 1:  v = (uint8_t)getU(&p, 1);  break;
+         case 2:  v = (int16_t)getU(&p, 2);  break;
+         case 3:  v = (uint16_t)getU(&p, 2); break;
+         case 4:  v = (int32_t)getU(&p, 4);  break;
+         case 5:  v = (long)getU(&p, 4);     break;
+         default: p = end; continue;
+      }
+      printf(csvOut ? ",%*ld" : " %*ld", width, v);
+   }
+   printf("\n");
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: decodeRecord
+@endinternal
+
+@b Description: @n
+    Decodes one record of the given length, header included.
+
+*******************************************************************************/
+static void decodeRecord(const uint8_t *rec, unsigned len)
+{
+   const uint8_t *p   = rec + 2;
+   const uint8_t *end = rec + len;
+   uint8_t  type = rec[1];
+   uint32_t time;
+   uint32_t sig;
+   uint64_t obj;
+   uint64_t fun;
+   uint64_t tgt;
+   Pending *pd;
+
+   switch(type)
+   {
+      case QS_EMPTY:
+         if(len >= 6)
+         {
+            sigSize  = rec[2];
+            timeSize = rec[3];
+            ptrSize  = rec[4];
+            funSize  = rec[5];
+         }
+         break;
+
+      case QS_QEP_STATE_ENTRY:
+      case QS_QEP_STATE_EXIT:
+         obj = getPtr(&p, ptrSize);
+         fun = getPtr(&p, funSize);
+         emit((type == QS_QEP_STATE_ENTRY) ? "ENTRY" : "EXIT",
+              -1, obj, -1, fun, 0);
+         break;
+
+      case QS_QEP_STATE_INIT:
+      case QS_QEP_INIT_TRAN:
+         obj = getPtr(&p, ptrSize);
+         fun = getPtr(&p, funSize);
+         tgt = getPtr(&p, funSize);
+         emit("INIT", -1, obj, -1, fun, tgt);
+         break;
+
+      case QS_QEP_DISPATCH:
+         time = getU(&p, timeSize);
+         sig  = getU(&p, sigSize);
+         obj  = getPtr(&p, ptrSize);
+         fun  = getPtr(&p, funSize);
+         pd   = pending(obj);
+         if(pd != NULL)
+         {
+            pd->pending = 1;
+            pd->time    = time;
+            pd->fun     = fun;
+         }
+         emit("DISPATCH", time, obj, (int32_t)sig, fun, 0);
+         break;
+
+      case QS_QEP_INTERN_TRAN:
+      case QS_QEP_IGNORED:
+         time = getU(&p, timeSize);
+         sig  = getU(&p, sigSize);
+         obj  = getPtr(&p, ptrSize);
+         fun  = getPtr(&p, funSize);
+         closeRtc(obj, time);
+         emit((type == QS_QEP_IGNORED) ? "IGNORED" : "INTERN", time, obj,
+              (int32_t)sig, fun, 0);
+         break;
+
+      case QS_QEP_TRAN:
+         time = getU(&p, timeSize);
+         sig  = getU(&p, sigSize);
+         obj  = getPtr(&p, ptrSize);
+         fun  = getPtr(&p, funSize);
+         tgt  = getPtr(&p, funSize);
+         closeRtc(obj, time);
+         emit("TRAN", time, obj, (int32_t)sig, fun, tgt);
+         break;
+
+      case QS_QEP_UNHANDLED:
+         sig = getU(&p, sigSize);
+         obj = getPtr(&p, ptrSize);
+         fun = getPtr(&p, funSize);
+         emit("UNHANDLED", -1, obj, (int32_t)sig, fun, 0);
+         break;
+
+      default:
+         if(type >= QS_USER)
+         {
+            emitUser(type, p, end);
+         }
+         break;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   FILE *in = stdin;
+   uint8_t rec[256];
+   int argIdx;
+   int i;
+   int c;
+
+   for(argIdx = 1; argIdx < argc; argIdx++)
+   {
+      if(strcmp(argv[argIdx], "-p") == 0 && (argIdx + 1) < argc)
+      {
+         ptrSize = atoi(argv[++argIdx]);
+      }
+      else if(strcmp(argv[argIdx], "-m") == 0 && (argIdx + 1) < argc)
+      {
+         loadSymbols(argv[++argIdx]);
+      }
+      else if(strcmp(argv[argIdx], "-c") == 0)
+      {
+         csvOut = 1;
+      }
+      else if(strcmp(argv[argIdx], "-s") == 0)
+      {
+         summary = 1;
+      }
+      else if((in = fopen(argv[argIdx], "rb")) == NULL)
+      {
+         perror(argv[argIdx]);
+         return 1;
+      }
+   }
+   if((ptrSize != 4) && (ptrSize != 8))
+   {
+      fprintf(stderr, "pointer size must be 4 or 8\n");
+      return 1;
+   }
+   funSize = ptrSize;
+   if(csvOut && !summary)
+   {
+      printf("time,record,object,signal,state,target\n");
+   }
+
+   // Records are [length][type][payload...], length includes the header
+   while((c = fgetc(in)) != EOF)
+   {
+      unsigned len = (unsigned)c;
+
+      if(len < 2)
+      {
+         fprintf(stderr, "corrupt record length %u\n", len);
+         return 1;
+      }
+      rec[0] = (uint8_t)len;
+      if(fread(&rec[1], 1, len - 1, in) != (len - 1))
+      {
+         break; // truncated last record
+      }
+      decodeRecord(rec, len);
+   }
+
+   if(summary)
+   {
+      printf(csvOut ? "state,rtcSteps,rtcTime,avgTime\n"
+                    : "%-32s %12s %14s %10s\n",
+             "state", "rtcSteps", "rtcTime", "avgTime");
+      for(i = 0; i < numStates; i++)
+      {
+         printf(csvOut ? "%s,%llu,%llu,%.2f\n" : "%-32s %12llu %14llu %10.2f\n",
+                symName(states[i].fun),
+                (unsigned long long)states[i].rtcCnt,
+                (unsigned long long)states[i].rtcTime,
+                (states[i].rtcCnt != 0)
+                   ? (double)states[i].rtcTime / (double)states[i].rtcCnt : 0.0);
+      }
+   }
+   return 0;
+}
@@ -1,306 +1,1941 @@
-#include <stdint.h>
-#include "qep_port.h"
-#include "AlgMbsda.h"
-#include "AlgMbsdaPrivate.h"
-#include "RingBuf.h"
-#include "MathFix.h"
-
-
-//====================================================================
-// Global signals
-//
-enum SystemSignals
-{
-   XL_DATA_SIG = Q_USER_SIG,  // 4,
-   TEST_SIG
-};
-
-//====================================================================
-// Event structure for collected accelerometer data
-//
-typedef struct XlDataEvtTag
-{
-   // QP event structure for all events
-   QEvt super;
-
-   uint32_t timeStamp;
-   int16_t  x;
-   int16_t  y;
-   int16_t  z;
-
-} XlDataEvt;
-
-#define MBSDA_STARTUP_DELAY 3000
-
-// Protected State function prototypes
-//
-static QState Mbsda_initial     (Mbsda * const me, QEvt const * const e);
-static QState Mbsda_startUp     (Mbsda * const me, QEvt const * const e);
-static QState Mbsda_idle        (Mbsda * const me, QEvt const * const e);
-
-// Local objects
-Mbsda l_mbsda;     // Single instance of the Mbsda class
-
-QFsm * const FSM_Mbsda = (QFsm *)&l_mbsda;  // "opaque" QHsm pointer
-
-
-/**
-********************************************************************************
-@internal
-   Fuction Name: Mbsda_ctor
-@endinternal
-
-@b Parameter: @n
-@b   Input:   parent   - pointer to parent Active Object  @n
-@b   Returns: (QHsm *) - pointer to "this" module for dispatching events  @n
-
-@b Description: @n
-    MBSDA constructor that is used to call other QP constructors and initialize
-    any necessary variables
-
-*******************************************************************************/
-QFsm * Mbsda_ctor(void)
-{
-   uint16_t orderIdx;
-   uint16_t widthIdx;
-
-   Mbsda *me       = &l_mbsda;
-
-   // Call QP related constructors
-   //
-   QFsm_ctor(&me->super, (QStateHandler)&Mbsda_initial);
-
-   // Initializing data members used in the Motion-Based Algorithm
-   //
-/*
-   me->pgm.alpha         = MBSDA_DEF_ALPHA;
-   me->pgm.stdaThLow     = MBSDA_DEF_ACT_THL;
-   me->pgm.stdaThHigh    = MBSDA_DEF_ACT_THH;
-   me->pgm.activityTime  = MBSDA_DEF_ACT_TIME;
-   me->pgm.mTpkThLow     = MBSDA_DEF_MTPK_THL;
-   me->pgm.mTpkThHigh    = MBSDA_DEF_MTPK_THH;
-   me->pgm.mTpkRThLow    = MBSDA_DEF_MTPKR_THL;
-   me->pgm.mTpkRThHigh   = MBSDA_DEF_MTPKR_THH;
-   me->pgm.freqPendTime  = MBSDA_DEF_FREQ_TIME;
-   me->pgm.freqDelayTime = MBSDA_DEF_FREQDLY_TIME;
-   me->pgm.zTh           = MBSDA_DEF_Z_TH;
-   me->pgm.zStdTh        = MBSDA_DEF_ZSTD_TH;
-   me->pgm.expTime       = MBSDA_DEF_EXP_TIME;
-   me->pgm.freqHys       = MBSDA_DEF_FREQ_HYS;
-   me->pgm.freqPkCnt     = MBSDA_DEF_FREQ_PK_CNT;
-*/
-   me->xlSampleCnt = 0;
-
-   me->xQ.in = me->xQ.rIn = me->xQ.wIn = me->xBufSto;
-   me->yQ.in = me->yQ.rIn = me->yQ.wIn = me->yBufSto;
-   me->zQ.in = me->zQ.rIn = me->zQ.wIn = me->zBufSto;
-
-   me->lastXyzFilt[0] = 0;
-   me->lastXyzFilt[1] = 0;
-   me->lastXyzFilt[2] = 0;
-
-   me->lastTimestamp = 0;
-   me->startTick     = 0;
-
-   //
-   // Initialize parameters related to low frequency magnitude filtration
-   //
-   me->lfFiltOutput = 0;
-   for(orderIdx = 0; orderIdx < MBSDA_LFMAG_ORDR_SZ; orderIdx++)
-   {
-      me->lowFreqMag[orderIdx].aggregate = 0;
-
-      me->lowFreqMag[orderIdx].queue.in     =
-         me->lowFreqMag[orderIdx].queue.rIn =
-         me->lowFreqMag[orderIdx].queue.wIn =
-                                   (me->lfBufSto+MBSDA_LFMAG_WDTH_SZ*orderIdx);
-
-      for(widthIdx = 0; widthIdx < MBSDA_LFMAG_WDTH_SZ; widthIdx++)
-      {
-         WriteBuf(&me->lowFreqMag[orderIdx].queue.wIn,
-                   me->lowFreqMag[orderIdx].queue.in, 0, MBSDA_LFMAG_WDTH_SZ);
-      }
-   }
-
-   //
-   // Initialize parameters related to scaled derivative calculations
-   //
-   me->sclDerCurr = 0;
-   me->sclDerPrev = 0;
-   me->sclDer.queue.in     =
-      me->sclDer.queue.rIn =
-      me->sclDer.queue.wIn = me->sclDerBufSto;
-   for(widthIdx = 0; widthIdx < MBSDA_DER_WDTH_SZ; widthIdx++)
-   {
-      WriteBuf(&me->sclDer.queue.wIn, me->sclDer.queue.in,
-                0, MBSDA_DER_WDTH_SZ);
-   }
-
-   //
-   // Initialize parameters related to peak-peak period calculations
-   //
-   me->mTpkFiltOutput  = 0;
-   me->mdTpkFiltOutput = 0;
-   for(orderIdx = 0; orderIdx < MBSDA_INT_ORDR_SZ; orderIdx++)
-   {
-      me->mTpk[orderIdx].aggregate  = 0;
-      me->mdTpk[orderIdx].aggregate = 0;
-
-      me->mTpk[orderIdx].queue.in     =
-         me->mTpk[orderIdx].queue.rIn =
-         me->mTpk[orderIdx].queue.wIn =
-                                   (me->mTpkBufSto+MBSDA_INT_WDTH_SZ*orderIdx);
-
-      me->mdTpk[orderIdx].queue.in     =
-         me->mdTpk[orderIdx].queue.rIn =
-         me->mdTpk[orderIdx].queue.wIn =
-                                   (me->mdTpkBufSto+MBSDA_INT_WDTH_SZ*orderIdx);
-      for(widthIdx = 0; widthIdx < MBSDA_INT_WDTH_SZ; widthIdx++)
-      {
-         WriteBuf(&me->mTpk[orderIdx].queue.wIn,
-                   me->mTpk[orderIdx].queue.in,  0, MBSDA_LFMAG_WDTH_SZ);
-         WriteBuf(&me->mdTpk[orderIdx].queue.wIn,
-                   me->mdTpk[orderIdx].queue.in, 0, MBSDA_LFMAG_WDTH_SZ);
-      }
-   }
-
-   me->freqNumPk[MBSDA_PKNEG_IDX] = 0;
-   me->freqNumPk[MBSDA_PKPOS_IDX] = 0;
-
-   me->szFlags     = 0;
-   me->freqPkCntr  = 0;
-
-   me->pgmSsValue = 0;  // Set to '0' to indicate using default values for
-                        //  a possible failed setting attempt
-
-   return (QFsm *)me;
-}
-
-/**
-********************************************************************************
-@internal
-   Fuction Name: Mbsda_initial
-@endinternal
-
-@b Parameter: @n
-@b   Input:   none  @n
-@b   Returns: none  @n
-
-@b Description: @n
-     ...
-
-*******************************************************************************/
-QState Mbsda_initial(Mbsda * const me, QEvt const * const e)
-{
-   (void)e; // suppress the compiler warning about unused parameter
-
-   return Q_TRAN(&Mbsda_startUp);
-}
-
-/**
-********************************************************************************
-@internal
-   Fuction Name: Mbsda_startUp
-@endinternal
-
-@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
-
-@b Description: @n
-    This state is used to let the filter settle before starting to check
-      for activity levels.
-@n
-@b Constraints: @n
-    This state and others that have guard conditions based on a timeout & will
-    calculate a delta time from the timestamp provided in the accelerometer
-    data event. This is used instead of a QP timer to allow the processor to
-    enter a lower power state while the time period is getting checked. The
-    QP timer currently requires the high frequency clock which does not run
-    in the lower power state.
-    @n
-    Another reason for using a delta time calculation is to support running
-    this state machine in a simulated environment where the data is provided
-    from a file instead of the accelerometer directly. This allows running
-    more data in a shorter period of time.
-
-*******************************************************************************/
-QState Mbsda_startUp(Mbsda * const me, QEvt const * const e)
-{
-   switch (e->sig)
-   {
-      case Q_ENTRY_SIG:
-      {
-         // Capture the current timestamp, will check against the timestamp
-         //  received in the XL_DATA for the timeout condition.
-         //
-         me->startTick = me->lastTimestamp;
-
-         return Q_HANDLED();
-      }
-      case Q_EXIT_SIG:
-      {
-         return Q_HANDLED();
-      }
-
-      case XL_DATA_SIG:
-      {
-//         Mbsda_process(me, e);
-
-         if((me->lastTimestamp - me->startTick) > MBSDA_STARTUP_DELAY)
-         {
-            return Q_TRAN(&Mbsda_idle);
-         }
-
-         return Q_HANDLED();
-      }
-   }
-   return Q_IGNORED();
-}
-
-/**
-********************************************************************************
-@internal
-   Fuction Name: Mbsda_idle
-@endinternal
-
-@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
-
-@b Description: @n
-    Process incoming accelerometer data using the motion-based seizure
-    detection algorithm. After processing the data, the activity will be
-    checked and if lower than the programmed low threshold will transition
-    to the low activity state.
-
-*******************************************************************************/
-QState Mbsda_idle(Mbsda * const me, QEvt const * const e)
-{
-   switch (e->sig)
-   {
-      case Q_ENTRY_SIG:
-      {
-         return Q_HANDLED();
-      }
-      case Q_EXIT_SIG:
-      {
-         return Q_HANDLED();
-      }
-
-      case XL_DATA_SIG:
-      {
-/*
-         Mbsda_process(me, e);
-
-         if(me->stdaXyz < me->pgm.stdaThLow)
-         {
-            return Q_TRAN(&Mbsda_lowActivity);
-         }
-*/
-         return Q_HANDLED();
-      }
-   }
-   return Q_IGNORED();
-}
-
-
-
-
-
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "qep_port.h"
+#include "qassert.h"
+#include "AlgMbsda.h"
+#include "AlgMbsdaPrivate.h"
+#include "RingBuf.h"
+#include "MathFix.h"
+
+
+#define MBSDA_STARTUP_DELAY 3000 // ms of event timestamps, at any rate
+#define MBSDA_SAMPLE_MS     (1000/MBSDA_SAMPLE_HZ) // ms between filter samples
+
+//==============================================================================
+// Activity stage
+//
+// stdaXyz adds up each axis' distance from its MBSDA_ORD_SIZE moving average
+// and smooths it by 1/2^MBSDA_DEF_ALPHA per sample. On the bench recordings
+// it stays within 27-51 at rest and at 267 or more in motion. At 50 Hz an
+// alpha of 4 is the lightest smoothing that keeps the rest ripple under
+// MBSDA_DEF_ACT_THL, where 3 reaches 63, and it still crosses
+// MBSDA_DEF_ACT_THH within a sample of the onset of motion.
+//==============================================================================
+#define MBSDA_DEF_ACT_THL     60 // stdaXyz under which activity is low
+#define MBSDA_DEF_ACT_THH    100 // stdaXyz over which activity is back
+#define MBSDA_DEF_ACT_TIME  5000 // ms under MBSDA_DEF_ACT_THL before lowActivity
+
+//==============================================================================
+// Magnitude, low frequency cascade and peak pairs
+//
+// The frequency module tracks |a|^2 >> MBSDA_MAG_SHIFT. Around 1 g that moves
+// by 2*1000/2^11, about one LSB per mg, and 4 g on all three axes still fits
+// the int16_t the filters take, where a shift of 10 overflows from 5.8 g. The
+// squared norm has no kink; an L1 norm rectifies each axis and doubles the
+// frequency of a rhythm along gravity.
+//
+// The cascade (MBSDA_LFMAG_*, the original design) is 3 dB down at 2.9 Hz,
+// 13.5 dB at 6 Hz and 18 dB at 7 Hz for 50 Hz. A peak only counts once it is
+// MBSDA_DEF_FREQ_HYS off the last opposite peak. Noise at rest is not its
+// job, the module is gated under MBSDA_DEF_ACT_THL there, but ripple riding
+// on the small swings at the top of the band is. On the single tone segments
+// of the bench recordings 20 mg gives the right mTpk from 1 to 6 Hz; 40 mg
+// stretches 6 Hz from 8 to 11 samples. The 7 Hz tone is only resolved from
+// 40 mg, so past 6 Hz the rhythm is left to the spectral stage.
+//
+// mTpkR is mdTpk/mTpk in Q14. It saturates at MAX_FX from a ratio of
+// MBSDA_TPKR_RATIO_MAX, the most Q14 holds in 16 bits; periods that far
+// apart are no rhythm.
+//==============================================================================
+#define MBSDA_MAG_SHIFT      11 // Squared magnitude to about 1 mg per LSB at 1 g
+#define MBSDA_DEF_FREQ_HYS   20 // Smallest peak to peak swing counted, mg
+#define MBSDA_TPKR_RATIO_MAX  2 // mdTpk/mTpk over which mTpkR saturates
+
+#define MBSDA_CKPT_VERSION   3  // Bump with any change to Mbsda_ckptWalk
+#define MBSDA_CKPT_MAGIC0  'M'
+#define MBSDA_CKPT_MAGIC1  'B'
+#define MBSDA_CKPT_HDR_SZ   13  // magic, version, state, profile, length, time
+#define MBSDA_CKPT_SUM_SZ    2  // Fletcher-16 of everything before it
+
+// Layout of Mbsda, see MBSDA_LAYOUT. The member sizes add up to the
+// structure but for padding, so no member is left out of the list, and
+// the HOT members sit within MBSDA_HOT_MAX bytes of the start.
+#define MBSDA_LAYOUT_SIZE(grp_, mbr_) + sizeof(((Mbsda *)0)->mbr_)
+#define MBSDA_LAYOUT_HOT(grp_, mbr_) \
+   && ((MBSDA_GRP_##grp_ != MBSDA_GRP_HOT) || \
+       (offsetof(Mbsda, mbr_) + sizeof(((Mbsda *)0)->mbr_) <= MBSDA_HOT_MAX))
+
+Q_ASSERT_COMPILE(sizeof(Mbsda) - (0 MBSDA_LAYOUT(MBSDA_LAYOUT_SIZE)) <=
+                 MBSDA_LAYOUT_PAD_MAX);
+Q_ASSERT_COMPILE(1 MBSDA_LAYOUT(MBSDA_LAYOUT_HOT));
+
+// ===================================================================
+/// struct @b MbsdaCkpt - cursor of a checkpoint being saved or restored
+// ===================================================================
+typedef struct MbsdaCkptTag
+{
+   uint8_t       *out;    // Save: window of the blob to fill, NULL to count
+   uint8_t const *in;     // Restore: whole blob
+   uint16_t       offset; // Save: blob position of out[0]
+   uint16_t       size;   // Save: bytes of out
+   uint16_t       pos;    // Blob position of the next byte
+   uint8_t        sum1;   // Running Fletcher-16 of the saved bytes
+   uint8_t        sum2;
+   uint8_t        ok;     // Restore: every queue index was in range
+
+} MbsdaCkpt;
+
+// Protected State function prototypes
+//
+static QState Mbsda_initial     (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_startUp     (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_idle        (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_lowActivity (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_resume      (Mbsda * const me, QEvt const * const e);
+
+// Sample processing prototypes
+//
+static void    Mbsda_process     (Mbsda * const me, XlDataEvt const * const e);
+static void    Mbsda_processHeld (Mbsda * const me, XlDataEvt const * const e);
+static int32_t Mbsda_activity    (Mbsda * const me, int16_t const * const xyz);
+static int32_t Mbsda_magnitude   (int16_t const * const xyz);
+static void    Mbsda_frequency   (Mbsda * const me, int32_t mag,
+                                  uint32_t sampleIdx);
+static void    Mbsda_prime       (Mbsda * const me, XlDataEvt const * const e);
+static void    Mbsda_freqGate    (Mbsda * const me);
+static void    Mbsda_freqRebuild (Mbsda * const me);
+static void    Mbsda_freqSeed    (Mbsda * const me, int32_t mag);
+static int32_t Mbsda_boxcar      (XlFilter * const filt, int16_t data,
+                                  uint16_t width);
+static void    Mbsda_getPkPrStat (Mbsda * const me, uint8_t signIdx,
+                                  uint32_t sampleIdx);
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+static void    Mbsda_freqSpectrum(Mbsda * const me, int16_t mag);
+#elif (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+static void    Mbsda_freqGoertzel(Mbsda * const me, int16_t mag,
+                                  uint32_t sampleIdx);
+#endif
+
+// Checkpoint prototypes
+//
+static void    Mbsda_ckptWalk    (Mbsda * const me, MbsdaCkpt * const ck);
+static void    Mbsda_ckptByte    (MbsdaCkpt * const ck, uint8_t * const data);
+static void    Mbsda_ckptVal     (MbsdaCkpt * const ck, void * const val,
+                                  uint16_t bytes);
+static void    Mbsda_ckptArr     (MbsdaCkpt * const ck, void * const arr,
+                                  uint16_t count, uint16_t bytes);
+static void    Mbsda_ckptQueue   (MbsdaCkpt * const ck, XlQueue * const q,
+                                  uint16_t size);
+
+#define MBSDA_CKPT_VAL(ck_, val_) \
+   Mbsda_ckptVal((ck_), &(val_), sizeof(val_))
+#define MBSDA_CKPT_ARR(ck_, arr_) \
+   Mbsda_ckptArr((ck_), (arr_), sizeof(arr_)/sizeof((arr_)[0]), \
+                 sizeof((arr_)[0]))
+
+// State action prototypes, one per handled signal of each state
+//
+static QState Mbsda_handled      (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_startUpEntry (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_startUpXlData(Mbsda * const me, QEvt const * const e);
+static QState Mbsda_idleEntry    (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_idleXlData   (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_lowActivityEntry (Mbsda * const me, QEvt const * const e);
+static QState Mbsda_lowActivityXlData(Mbsda * const me, QEvt const * const e);
+
+//====================================================================
+// State [signal] -> action descriptions
+//
+// Each flat state is described once as a list of (signal, action) pairs.
+// By default the list expands into the usual switch on e->sig. Defining
+// MBSDA_SIG_TABLE expands it instead into a const action table indexed by
+// the signal (see Q_SIG_TABLE_HANDLER), so dispatch is a bounds check and
+// an indexed call. Signals that are not listed return Q_IGNORED() in both
+// forms. The "dispatch" suite of host/mbsda_bench.c times the two.
+//
+#define MBSDA_STARTUP_ACTIONS(ACTION_) \
+   ACTION_(Q_ENTRY_SIG, Mbsda_startUpEntry)  \
+   ACTION_(Q_EXIT_SIG,  Mbsda_handled)       \
+   ACTION_(XL_DATA_SIG, Mbsda_startUpXlData)
+
+#define MBSDA_IDLE_ACTIONS(ACTION_) \
+   ACTION_(Q_ENTRY_SIG, Mbsda_idleEntry)     \
+   ACTION_(Q_EXIT_SIG,  Mbsda_handled)       \
+   ACTION_(XL_DATA_SIG, Mbsda_idleXlData)
+
+#define MBSDA_LOW_ACTIVITY_ACTIONS(ACTION_) \
+   ACTION_(Q_ENTRY_SIG, Mbsda_lowActivityEntry) \
+   ACTION_(Q_EXIT_SIG,  Mbsda_handled)          \
+   ACTION_(XL_DATA_SIG, Mbsda_lowActivityXlData)
+
+#ifdef MBSDA_SIG_TABLE
+   #define MBSDA_STATE_HANDLER(state_, actions_) \
+      Q_SIG_TABLE_HANDLER(state_, Mbsda, MBSDA_MAX_SIG, actions_)
+#else
+   #define MBSDA_STATE_HANDLER(state_, actions_) \
+      Q_SIG_SWITCH_HANDLER(state_, Mbsda, actions_)
+#endif
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+// Goertzel detectors evenly spread over the band of the rate profile, the
+// spacing is about one bin of a MBSDA_GTZ_BLOCK point transform
+//
+static int16_t const Q_ROM l_gtzCoef[MBSDA_GTZ_BINS] =   // 2*cos(2*pi*f/fs), Q14
+{
+#if   (MBSDA_SAMPLE_HZ == 10)
+   10126,  4399, -1470, -7292,-12879,-18052,-22645,-26510
+#elif (MBSDA_SAMPLE_HZ == 25)
+   28715, 24677, 19498, 13417,  6717,  -294, -7292,-13952
+#elif (MBSDA_SAMPLE_HZ == 50)
+   31739, 30679, 29263, 27508, 25435, 23066, 20431, 17558
+#elif (MBSDA_SAMPLE_HZ == 100)
+   32510, 32241, 31880, 31426, 30880, 30245, 29523, 28715
+#endif
+};
+static uint16_t const Q_ROM l_gtzFreq[MBSDA_GTZ_BINS] =  // f, Hz in Q8
+{
+#if (MBSDA_FFT_BAND_HI == 4)
+     512,   585,   658,   731,   805,   878,   951,  1024
+#else
+     512,   731,   951,  1170,  1390,  1609,  1829,  2048
+#endif
+};
+#endif
+
+// Local objects
+Mbsda l_mbsda;     // Single instance of the Mbsda class
+
+QFsm * const FSM_Mbsda = (QFsm *)&l_mbsda;  // "opaque" QHsm pointer
+
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ctor
+@endinternal
+
+@b Parameter: @n
+@b   Input:   parent   - pointer to parent Active Object  @n
+@b   Returns: (QHsm *) - pointer to "this" module for dispatching events  @n
+
+@b Description: @n
+    MBSDA constructor that is used to call other QP constructors and initialize
+    any necessary variables
+
+*******************************************************************************/
+QFsm * Mbsda_ctor(void)
+{
+   return Mbsda_ctorObj(&l_mbsda);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ctorObj
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me       - pointer to the Mbsda instance to construct  @n
+@b   Returns: (QFsm *) - pointer to "this" module for dispatching events  @n
+
+@b Description: @n
+    Constructs a given Mbsda instance. Used by Mbsda_ctor for the single
+    instance on the watch, and by the host tools that run one independent
+    instance per recording.
+
+*******************************************************************************/
+QFsm * Mbsda_ctorObj(Mbsda * const me)
+{
+   uint16_t orderIdx;
+   uint16_t widthIdx;
+
+   // Call QP related constructors
+   //
+   QFsm_ctor(&me->super, (QStateHandler)&Mbsda_initial);
+
+   // Initializing data members used in the Motion-Based Algorithm
+   //
+/*
+   me->pgm.alpha         = MBSDA_DEF_ALPHA;
+   me->pgm.stdaThLow     = MBSDA_DEF_ACT_THL;
+   me->pgm.stdaThHigh    = MBSDA_DEF_ACT_THH;
+   me->pgm.activityTime  = MBSDA_DEF_ACT_TIME;
+   me->pgm.mTpkThLow     = MBSDA_DEF_MTPK_THL;
+   me->pgm.mTpkThHigh    = MBSDA_DEF_MTPK_THH;
+   me->pgm.mTpkRThLow    = MBSDA_DEF_MTPKR_THL;
+   me->pgm.mTpkRThHigh   = MBSDA_DEF_MTPKR_THH;
+   me->pgm.freqPendTime  = MBSDA_DEF_FREQ_TIME;
+   me->pgm.freqDelayTime = MBSDA_DEF_FREQDLY_TIME;
+   me->pgm.zTh           = MBSDA_DEF_Z_TH;
+   me->pgm.zStdTh        = MBSDA_DEF_ZSTD_TH;
+   me->pgm.expTime       = MBSDA_DEF_EXP_TIME;
+   me->pgm.freqHys       = MBSDA_DEF_FREQ_HYS;
+   me->pgm.freqPkCnt     = MBSDA_DEF_FREQ_PK_CNT;
+*/
+   me->xlSampleCnt = 0;
+
+   me->xQ.in = me->xBufSto;
+   me->yQ.in = me->yBufSto;
+   me->zQ.in = me->zBufSto;
+   me->xQ.rIdx = me->xQ.wIdx = 0;
+   me->yQ.rIdx = me->yQ.wIdx = 0;
+   me->zQ.rIdx = me->zQ.wIdx = 0;
+   for(widthIdx = 0; widthIdx < MBSDA_ORD_SIZE; widthIdx++)
+   {
+      WriteBufIdx(&me->xQ.wIdx, me->xQ.in, 0, MBSDA_ORD_SIZE);
+      WriteBufIdx(&me->yQ.wIdx, me->yQ.in, 0, MBSDA_ORD_SIZE);
+      WriteBufIdx(&me->zQ.wIdx, me->zQ.in, 0, MBSDA_ORD_SIZE);
+   }
+#if (MBSDA_DECIM > 1)
+   DecimFix_init(&me->decim[XL_X_AXIS]);
+   DecimFix_init(&me->decim[XL_Y_AXIS]);
+   DecimFix_init(&me->decim[XL_Z_AXIS]);
+#endif
+   me->xyzAggregate[0] = 0;
+   me->xyzAggregate[1] = 0;
+   me->xyzAggregate[2] = 0;
+   me->stdaXyz = 0;
+
+   me->lastXyzFilt[0] = 0;
+   me->lastXyzFilt[1] = 0;
+   me->lastXyzFilt[2] = 0;
+
+   me->xlRateHz = MBSDA_INPUT_HZ;
+   me->xlLowHz  = MBSDA_LOW_HZ;
+
+   me->lastTimestamp = 0;
+   me->startTick     = 0;
+
+   //
+   // Initialize parameters related to low frequency magnitude filtration
+   //
+   me->lfFiltOutput = 0;
+   for(orderIdx = 0; orderIdx < MBSDA_LFMAG_ORDR_SZ; orderIdx++)
+   {
+      me->lowFreqMag[orderIdx].aggregate = 0;
+
+      me->lowFreqMag[orderIdx].queue.in =
+                                   (me->lfBufSto+MBSDA_LFMAG_WDTH_SZ*orderIdx);
+      me->lowFreqMag[orderIdx].queue.rIdx =
+         me->lowFreqMag[orderIdx].queue.wIdx = 0;
+
+      for(widthIdx = 0; widthIdx < MBSDA_LFMAG_WDTH_SZ; widthIdx++)
+      {
+         WriteBufIdx(&me->lowFreqMag[orderIdx].queue.wIdx,
+                      me->lowFreqMag[orderIdx].queue.in, 0,
+                      MBSDA_LFMAG_WDTH_SZ);
+      }
+   }
+
+   //
+   // Initialize parameters related to scaled derivative calculations
+   //
+   me->sclDerCurr = 0;
+   me->sclDerPrev = 0;
+   me->sclDer.queue.in   = me->sclDerBufSto;
+   me->sclDer.queue.rIdx = me->sclDer.queue.wIdx = 0;
+   for(widthIdx = 0; widthIdx < MBSDA_DER_WDTH_SZ; widthIdx++)
+   {
+      WriteBufIdx(&me->sclDer.queue.wIdx, me->sclDer.queue.in,
+                   0, MBSDA_DER_WDTH_SZ);
+   }
+
+   //
+   // Initialize parameters related to peak-peak period calculations
+   //
+   me->mTpkFiltOutput  = 0;
+   me->mdTpkFiltOutput = 0;
+   for(orderIdx = 0; orderIdx < MBSDA_INT_ORDR_SZ; orderIdx++)
+   {
+      me->mTpk[orderIdx].aggregate  = 0;
+      me->mdTpk[orderIdx].aggregate = 0;
+
+      me->mTpk[orderIdx].queue.in =
+                                   (me->mTpkBufSto+MBSDA_INT_WDTH_SZ*orderIdx);
+      me->mTpk[orderIdx].queue.rIdx =
+         me->mTpk[orderIdx].queue.wIdx = 0;
+
+      me->mdTpk[orderIdx].queue.in =
+                                   (me->mdTpkBufSto+MBSDA_INT_WDTH_SZ*orderIdx);
+      me->mdTpk[orderIdx].queue.rIdx =
+         me->mdTpk[orderIdx].queue.wIdx = 0;
+      for(widthIdx = 0; widthIdx < MBSDA_INT_WDTH_SZ; widthIdx++)
+      {
+         WriteBufIdx(&me->mTpk[orderIdx].queue.wIdx,
+                      me->mTpk[orderIdx].queue.in,  0, MBSDA_INT_WDTH_SZ);
+         WriteBufIdx(&me->mdTpk[orderIdx].queue.wIdx,
+                      me->mdTpk[orderIdx].queue.in, 0, MBSDA_INT_WDTH_SZ);
+      }
+   }
+   me->mTpkR = 0;
+
+   me->freqNumPk[MBSDA_PKNEG_IDX] = 0;
+   me->freqNumPk[MBSDA_PKPOS_IDX] = 0;
+   me->freqPkV[MBSDA_PKNEG_IDX]   = 0;
+   me->freqPkV[MBSDA_PKPOS_IDX]   = 0;
+   me->freqTpkCurr = 0;
+   me->freqTpkPrev = 0;
+   me->freqDpk     = 0;
+
+   //
+   // Initialize parameters related to the magnitude spectrum
+   //
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   me->fftMagQ.in   = me->fftMagBufSto;
+   me->fftMagQ.rIdx = me->fftMagQ.wIdx = 0;
+   for(widthIdx = 0; widthIdx < MBSDA_FFT_SIZE; widthIdx++)
+   {
+      WriteBufIdx(&me->fftMagQ.wIdx, me->fftMagQ.in, 0, MBSDA_FFT_SIZE);
+   }
+   me->fftHopCntr         = 0;
+#elif (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   Goertzel_init(&me->gtzBank);
+#endif
+   me->freqSpec.domFreq   = 0;
+   me->freqSpec.bandRatio = 0;
+   me->freqSpec.bandPwr   = 0;
+   me->freqSpec.totalPwr  = 0;
+   me->freqSampleCnt      = 0;
+   me->freqGated          = 0;
+
+   me->primeCnt    = MBSDA_PRIME_SAMPLES;
+   me->startCnt    = 0;
+
+   me->szFlags     = 0;
+   me->freqPkCntr  = 0;
+
+   me->pgmSsValue = 0;  // Set to '0' to indicate using default values for
+                        //  a possible failed setting attempt
+
+   return (QFsm *)me;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_initial
+@endinternal
+
+@b Parameter: @n
+@b   Input:   none  @n
+@b   Returns: none  @n
+
+@b Description: @n
+     ...
+
+*******************************************************************************/
+QState Mbsda_initial(Mbsda * const me, QEvt const * const e)
+{
+   (void)e; // suppress the compiler warning about unused parameter
+
+   return Q_TRAN(&Mbsda_startUp);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_resume
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Initial transition of an instance restored by Mbsda_restore. The filters
+    are already settled, so Mbsda_startUp is skipped.
+
+*******************************************************************************/
+QState Mbsda_resume(Mbsda * const me, QEvt const * const e)
+{
+   (void)e; // suppress the compiler warning about unused parameter
+
+   return Q_TRAN(&Mbsda_idle);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_handled
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Common action for signals a state handles without doing anything, such as
+    empty entry and exit actions.
+
+*******************************************************************************/
+QState Mbsda_handled(Mbsda * const me, QEvt const * const e)
+{
+   (void)me; // suppress the compiler warning about unused parameter
+   (void)e;
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_startUp
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    This state is used to let the filter settle before starting to check
+      for activity levels.
+@n
+@b Constraints: @n
+    This state and others that have guard conditions based on a timeout & will
+    calculate a delta time from the timestamp provided in the accelerometer
+    data event. This is used instead of a QP timer to allow the processor to
+    enter a lower power state while the time period is getting checked. The
+    QP timer currently requires the high frequency clock which does not run
+    in the lower power state.
+    @n
+    Another reason for using a delta time calculation is to support running
+    this state machine in a simulated environment where the data is provided
+    from a file instead of the accelerometer directly. This allows running
+    more data in a shorter period of time.
+
+*******************************************************************************/
+MBSDA_STATE_HANDLER(Mbsda_startUp, MBSDA_STARTUP_ACTIONS)
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_startUpEntry
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Entry action of Mbsda_startUp. The start-up is timed from the first
+    sample, the first timestamp known.
+
+*******************************************************************************/
+QState Mbsda_startUpEntry(Mbsda * const me, QEvt const * const e)
+{
+   (void)e; // suppress the compiler warning about unused parameter
+
+   me->startCnt = 0;
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_startUpXlData
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    XL_DATA_SIG action of Mbsda_startUp. Primed filters start settled and
+    it leaves for Mbsda_idle after primeCnt samples, which give stdaXyz
+    time to pick up motion. Filters primed with zeros get
+    MBSDA_STARTUP_DELAY to settle.
+
+*******************************************************************************/
+QState Mbsda_startUpXlData(Mbsda * const me, QEvt const * const e)
+{
+   XlDataEvt const * const xl = (XlDataEvt const *)e;
+
+   if(me->startCnt == 0)
+   {
+      me->startTick = xl->timeStamp;
+      if(me->primeCnt != 0)
+      {
+         Mbsda_prime(me, xl);
+      }
+   }
+   if(me->startCnt < UINT8_MAX)
+   {
+      me->startCnt++;
+   }
+
+   Mbsda_process(me, xl);
+
+   if(me->primeCnt != 0)
+   {
+      if(me->startCnt >= me->primeCnt)
+      {
+         return Q_TRAN(&Mbsda_idle);
+      }
+   }
+   else if((me->lastTimestamp - me->startTick) > MBSDA_STARTUP_DELAY)
+   {
+      return Q_TRAN(&Mbsda_idle);
+   }
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_idle
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Process incoming accelerometer data using the motion-based seizure
+    detection algorithm. After processing the data, the activity will be
+    checked and if lower than the programmed low threshold will transition
+    to the low activity state.
+
+*******************************************************************************/
+MBSDA_STATE_HANDLER(Mbsda_idle, MBSDA_IDLE_ACTIONS)
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_idleEntry
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Entry action of Mbsda_idle, asks for the full accelerometer rate. When
+    coming back from the low rate the decimators, which were bypassed,
+    restart from the moving averages; the frequency module is rebuilt by
+    Mbsda_process.
+
+*******************************************************************************/
+QState Mbsda_idleEntry(Mbsda * const me, QEvt const * const e)
+{
+#if (MBSDA_DECIM > 1)
+   uint16_t axisIdx;
+#endif
+
+   (void)e; // suppress the compiler warning about unused parameter
+
+   if(me->xlRateHz != MBSDA_INPUT_HZ)
+   {
+#if (MBSDA_DECIM > 1)
+      for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+      {
+         DecimFix_seed(&me->decim[axisIdx],
+                       me->lastXyzFilt[axisIdx]);
+      }
+#endif
+      me->xlRateHz = MBSDA_INPUT_HZ;
+   }
+
+   // Start of the time spent under the low activity threshold
+   //
+   me->startTick = me->lastTimestamp;
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_idleXlData
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    XL_DATA_SIG action of Mbsda_idle. Leaves for Mbsda_lowActivity once
+    stdaXyz stayed under MBSDA_DEF_ACT_THL for MBSDA_DEF_ACT_TIME, unless
+    the low rate is disabled.
+
+*******************************************************************************/
+QState Mbsda_idleXlData(Mbsda * const me, QEvt const * const e)
+{
+   Mbsda_process(me, (XlDataEvt const *)e);
+
+   if(me->stdaXyz >= MBSDA_DEF_ACT_THL)
+   {
+      me->startTick = me->lastTimestamp;
+   }
+   else if((me->xlLowHz != 0) &&
+           ((me->lastTimestamp - me->startTick) > MBSDA_DEF_ACT_TIME))
+   {
+      return Q_TRAN(&Mbsda_lowActivity);
+   }
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_lowActivity
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    The wearer is still or asleep, there is no rhythm to analyse. The
+    accelerometer runs at xlLowHz and only the activity stage is kept up to
+    date, until stdaXyz goes over MBSDA_DEF_ACT_THH.
+
+*******************************************************************************/
+MBSDA_STATE_HANDLER(Mbsda_lowActivity, MBSDA_LOW_ACTIVITY_ACTIONS)
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_lowActivityEntry
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    Entry action of Mbsda_lowActivity, asks for the low accelerometer rate.
+    The frequency module does not run at that rate.
+
+*******************************************************************************/
+QState Mbsda_lowActivityEntry(Mbsda * const me, QEvt const * const e)
+{
+   (void)e; // suppress the compiler warning about unused parameter
+
+   me->xlRateHz = me->xlLowHz;
+   Mbsda_freqGate(me);
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_lowActivityXlData
+@endinternal
+
+@b Parameter: Standard QP State inputs/returns. Defined in qpc\include\qep.h @n
+
+@b Description: @n
+    XL_DATA_SIG action of Mbsda_lowActivity.
+
+*******************************************************************************/
+QState Mbsda_lowActivityXlData(Mbsda * const me, QEvt const * const e)
+{
+   Mbsda_processHeld(me, (XlDataEvt const *)e);
+
+   if(me->stdaXyz > MBSDA_DEF_ACT_THH)
+   {
+      return Q_TRAN(&Mbsda_idle);
+   }
+
+   return Q_HANDLED();
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_process
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance  @n
+@b            e  - accelerometer sample           @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Runs one accelerometer sample through the algorithm. Samples faster
+    than MBSDA_SAMPLE_HZ are decimated first, only every MBSDA_DECIM-th
+    event goes any further. The activity stage always runs. The frequency
+    module only runs while stdaXyz says there is activity to analyse: it is
+    suspended under MBSDA_DEF_ACT_THL and rebuilt from the activity queues
+    over MBSDA_DEF_ACT_THH. The FFT window keeps being filled while
+    suspended, only the transforms are skipped.
+
+*******************************************************************************/
+void Mbsda_process(Mbsda * const me, XlDataEvt const * const e)
+{
+   int16_t  xyz[XL_NUM_AXIS];
+   int32_t  mag;
+
+   me->lastTimestamp = e->timeStamp;
+
+#if (MBSDA_DECIM > 1)
+   DecimFix_push(&me->decim[XL_X_AXIS], MBSDA_DECIM, e->x, &xyz[XL_X_AXIS]);
+   DecimFix_push(&me->decim[XL_Y_AXIS], MBSDA_DECIM, e->y, &xyz[XL_Y_AXIS]);
+   if(!DecimFix_push(&me->decim[XL_Z_AXIS], MBSDA_DECIM, e->z,
+                     &xyz[XL_Z_AXIS]))
+   {
+      return;
+   }
+#else
+   xyz[XL_X_AXIS] = e->x;
+   xyz[XL_Y_AXIS] = e->y;
+   xyz[XL_Z_AXIS] = e->z;
+#endif
+
+   mag = Mbsda_activity(me, xyz);
+
+   if(me->freqGated)
+   {
+      if(me->stdaXyz > MBSDA_DEF_ACT_THH)
+      {
+         Mbsda_freqRebuild(me);
+      }
+   }
+#if (MBSDA_FREQ_GATE != 0)
+   else if(me->stdaXyz < MBSDA_DEF_ACT_THL)
+   {
+      Mbsda_freqGate(me);
+   }
+#endif
+   else
+   {
+      Mbsda_frequency(me, mag, me->xlSampleCnt);
+   }
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   Mbsda_freqSpectrum(me, (int16_t)mag);
+#endif
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_frequency
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me        - pointer to the Mbsda instance               @n
+@b            mag       - scaled squared magnitude of the sample      @n
+@b            sampleIdx - xlSampleCnt of the sample                   @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Frequency module but the FFT. It works on the squared magnitude, scaled
+    so it changes by about one LSB per mg around 1 g. It has no rectifying
+    kink so a rhythm along gravity keeps its frequency. The module low-pass
+    filters it, finds its peaks from the sign changes of the scaled
+    derivative and feeds the Goertzel bank when that is the
+    MBSDA_FREQ_MODULE stage.
+
+*******************************************************************************/
+void Mbsda_frequency(Mbsda * const me, int32_t mag, uint32_t sampleIdx)
+{
+   uint16_t orderIdx;
+   int32_t  lf;
+
+   lf = mag;
+   for(orderIdx = 0; orderIdx < MBSDA_LFMAG_ORDR_SZ; orderIdx++)
+   {
+      lf = Mbsda_boxcar(&me->lowFreqMag[orderIdx], (int16_t)lf,
+                        MBSDA_LFMAG_WDTH_SZ);
+   }
+   me->lfFiltOutput = lf;
+
+   me->sclDerPrev = me->sclDerCurr;
+   me->sclDerCurr = (lf - ReadBufIdx(&me->sclDer.queue.rIdx,
+                                     me->sclDer.queue.in,
+                                     MBSDA_DER_WDTH_SZ)) *
+                    (MBSDA_SAMPLE_HZ/MBSDA_DER_WDTH_SZ); // mg/s
+   WriteBufIdx(&me->sclDer.queue.wIdx, me->sclDer.queue.in, (int16_t)lf,
+               MBSDA_DER_WDTH_SZ);
+   me->sclDer.output = me->sclDerCurr;
+
+   // A peak is where the derivative changes sign
+   //
+   if((me->sclDerPrev > 0) && (me->sclDerCurr <= 0))
+   {
+      Mbsda_getPkPrStat(me, MBSDA_PKPOS_IDX, sampleIdx);
+   }
+   else if((me->sclDerPrev < 0) && (me->sclDerCurr >= 0))
+   {
+      Mbsda_getPkPrStat(me, MBSDA_PKNEG_IDX, sampleIdx);
+   }
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   Mbsda_freqGoertzel(me, (int16_t)mag, sampleIdx);
+#endif
+
+   me->freqSampleCnt = sampleIdx;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_activity
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me  - pointer to the Mbsda instance       @n
+@b            xyz - new sample at MBSDA_SAMPLE_HZ      @n
+@b   Returns: scaled squared magnitude of the sample  @n
+
+@b Description: @n
+    Activity stage, the residual of each axis around its moving average
+    over MBSDA_ORD_SIZE samples smoothed into stdaXyz.
+
+*******************************************************************************/
+int32_t Mbsda_activity(Mbsda * const me, int16_t const * const xyz)
+{
+   XlQueue *queue[XL_NUM_AXIS];
+   uint16_t axisIdx;
+   int32_t  filt;
+   int32_t  act = 0;
+
+   me->xlSampleCnt++;
+
+   queue[XL_X_AXIS] = &me->xQ;
+   queue[XL_Y_AXIS] = &me->yQ;
+   queue[XL_Z_AXIS] = &me->zQ;
+
+   for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+   {
+      me->xyzAggregate[axisIdx] -= ReadBufIdx(&queue[axisIdx]->rIdx,
+                                              queue[axisIdx]->in,
+                                              MBSDA_ORD_SIZE);
+      me->xyzAggregate[axisIdx] += xyz[axisIdx];
+      WriteBufIdx(&queue[axisIdx]->wIdx, queue[axisIdx]->in, xyz[axisIdx],
+                  MBSDA_ORD_SIZE);
+
+      filt = me->xyzAggregate[axisIdx] / MBSDA_ORD_SIZE;
+      me->lastXyzFilt[axisIdx] = (int16_t)filt;
+
+      act += labs(xyz[axisIdx] - filt);
+   }
+   me->stdaXyz = (uint16_t)(me->stdaXyz +
+                            ((act - (int32_t)me->stdaXyz) >> MBSDA_DEF_ALPHA));
+
+   return Mbsda_magnitude(xyz);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_magnitude
+@endinternal
+
+@b Parameter: @n
+@b   Input:   xyz - sample at MBSDA_SAMPLE_HZ  @n
+@b   Returns: squared magnitude, about 1 mg per LSB at 1 g  @n
+
+*******************************************************************************/
+int32_t Mbsda_magnitude(int16_t const * const xyz)
+{
+   uint32_t mag = (uint32_t)((int32_t)xyz[XL_X_AXIS]*xyz[XL_X_AXIS]) +
+                  (uint32_t)((int32_t)xyz[XL_Y_AXIS]*xyz[XL_Y_AXIS]) +
+                  (uint32_t)((int32_t)xyz[XL_Z_AXIS]*xyz[XL_Z_AXIS]);
+
+   return (int32_t)(mag >> MBSDA_MAG_SHIFT);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_processHeld
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance  @n
+@b            e  - accelerometer sample           @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Activity stage only, for samples slower than MBSDA_SAMPLE_HZ. Each
+    sample is held for the MBSDA_SAMPLE_MS steps its timestamp covers, so
+    the moving averages and stdaXyz keep their time constants and stay in
+    MBSDA_SAMPLE_HZ units at any rate. The decimator is bypassed and the
+    frequency module suspended, the FFT window is still filled. Samples
+    closer than MBSDA_SAMPLE_MS, still in flight from the full rate, are
+    dropped until a step is due.
+
+*******************************************************************************/
+void Mbsda_processHeld(Mbsda * const me, XlDataEvt const * const e)
+{
+   int16_t  xyz[XL_NUM_AXIS];
+   int32_t  mag;
+   uint32_t steps = (e->timeStamp - me->lastTimestamp) / MBSDA_SAMPLE_MS;
+
+   if(steps == 0)
+   {
+      return;
+   }
+
+   // After a gap the whole window is the new sample
+   //
+   if(steps > MBSDA_ORD_SIZE)
+   {
+      steps = MBSDA_ORD_SIZE;
+      me->lastTimestamp = e->timeStamp;
+   }
+   else
+   {
+      me->lastTimestamp += steps*MBSDA_SAMPLE_MS;
+   }
+
+   xyz[XL_X_AXIS] = e->x;
+   xyz[XL_Y_AXIS] = e->y;
+   xyz[XL_Z_AXIS] = e->z;
+   while(steps-- > 0)
+   {
+      mag = Mbsda_activity(me, xyz);
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+      Mbsda_freqSpectrum(me, (int16_t)mag);
+#else
+      (void)mag;
+#endif
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_prime
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance  @n
+@b            e  - first accelerometer sample     @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Primes the filters from the first sample instead of zero, as if the
+    wrist had held still in that position all along: the decimators, the
+    moving averages and lastXyzFilt at the sample, stdaXyz at rest, the
+    frequency module and FFT window at its magnitude. The peak pair
+    smoothers have no rest value and start from zero either way. Every
+    sample, the first one included, is then processed as usual.
+
+*******************************************************************************/
+void Mbsda_prime(Mbsda * const me, XlDataEvt const * const e)
+{
+   XlQueue *queue[XL_NUM_AXIS];
+   int16_t  xyz[XL_NUM_AXIS];
+   uint16_t widthIdx;
+   uint16_t axisIdx;
+   int32_t  mag;
+
+   queue[XL_X_AXIS] = &me->xQ;
+   queue[XL_Y_AXIS] = &me->yQ;
+   queue[XL_Z_AXIS] = &me->zQ;
+   xyz[XL_X_AXIS]   = e->x;
+   xyz[XL_Y_AXIS]   = e->y;
+   xyz[XL_Z_AXIS]   = e->z;
+
+   for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+   {
+      for(widthIdx = 0; widthIdx < MBSDA_ORD_SIZE; widthIdx++)
+      {
+         WriteBufIdx(&queue[axisIdx]->wIdx, queue[axisIdx]->in, xyz[axisIdx],
+                     MBSDA_ORD_SIZE);
+      }
+      me->xyzAggregate[axisIdx] = (int32_t)xyz[axisIdx]*MBSDA_ORD_SIZE;
+      me->lastXyzFilt[axisIdx]  = xyz[axisIdx];
+#if (MBSDA_DECIM > 1)
+      DecimFix_seed(&me->decim[axisIdx], xyz[axisIdx]);
+#endif
+   }
+   me->stdaXyz = 0;
+
+   mag = Mbsda_magnitude(xyz);
+   Mbsda_freqSeed(me, mag);
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   for(widthIdx = 0; widthIdx < MBSDA_FFT_SIZE; widthIdx++)
+   {
+      WriteBufIdx(&me->fftMagQ.wIdx, me->fftMagQ.in, (int16_t)mag,
+                  MBSDA_FFT_SIZE);
+   }
+#endif
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_freqGate
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Suspends the frequency module. Its features are cleared, nothing
+    updates them until Mbsda_freqRebuild.
+
+*******************************************************************************/
+void Mbsda_freqGate(Mbsda * const me)
+{
+   me->freqGated = 1;
+
+   me->freqSpec.domFreq   = 0;
+   me->freqSpec.bandRatio = 0;
+   me->freqSpec.bandPwr   = 0;
+   me->freqSpec.totalPwr  = 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_freqRebuild
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Resumes the frequency module by running it over the samples it missed,
+    read back from the MBSDA_ORD_SIZE sample activity queues. When it
+    missed no more than that it simply catches up and its state is what
+    running on every sample would have given. Otherwise it restarts as if
+    the magnitude of the oldest queued sample had been its input all along
+    and runs over the whole queue; the boxcar cascade and the derivative
+    remember (MBSDA_LFMAG_WDTH_SZ-1)*MBSDA_LFMAG_ORDR_SZ+MBSDA_DER_WDTH_SZ
+    samples, fewer than the queue holds, so they end up the same too. Peak
+    pairs restart and only see the peaks of the queue.
+
+*******************************************************************************/
+void Mbsda_freqRebuild(Mbsda * const me)
+{
+   XlQueue *queue[XL_NUM_AXIS];
+   uint8_t  rd[XL_NUM_AXIS];
+   int16_t  xyz[XL_NUM_AXIS];
+   uint32_t missed = me->xlSampleCnt - me->freqSampleCnt;
+   uint16_t widthIdx;
+   uint16_t axisIdx;
+
+   queue[XL_X_AXIS] = &me->xQ;
+   queue[XL_Y_AXIS] = &me->yQ;
+   queue[XL_Z_AXIS] = &me->zQ;
+
+   // The read indices of the queues are at their oldest samples
+   //
+   for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+   {
+      rd[axisIdx] = queue[axisIdx]->rIdx;
+   }
+
+   if(missed >= MBSDA_ORD_SIZE)
+   {
+      missed = MBSDA_ORD_SIZE;
+      for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+      {
+         xyz[axisIdx] = queue[axisIdx]->in[rd[axisIdx]];
+      }
+      Mbsda_freqSeed(me, Mbsda_magnitude(xyz));
+   }
+
+   for(widthIdx = 0; widthIdx < MBSDA_ORD_SIZE; widthIdx++)
+   {
+      for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+      {
+         xyz[axisIdx] = ReadBufIdx(&rd[axisIdx], queue[axisIdx]->in,
+                                   MBSDA_ORD_SIZE);
+      }
+      if(widthIdx >= MBSDA_ORD_SIZE - missed)
+      {
+         Mbsda_frequency(me, Mbsda_magnitude(xyz),
+                         me->xlSampleCnt - (MBSDA_ORD_SIZE - 1) + widthIdx);
+      }
+   }
+
+   me->freqGated = 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_freqSeed
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me  - pointer to the Mbsda instance          @n
+@b            mag - magnitude to start the module from     @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Restarts the frequency module as if mag had been its input all along:
+    the boxcar cascade and the derivative at their steady state, no peak
+    pairs and an empty Goertzel block.
+
+*******************************************************************************/
+void Mbsda_freqSeed(Mbsda * const me, int32_t mag)
+{
+   uint16_t orderIdx;
+   uint16_t widthIdx;
+
+   for(orderIdx = 0; orderIdx < MBSDA_LFMAG_ORDR_SZ; orderIdx++)
+   {
+      for(widthIdx = 0; widthIdx < MBSDA_LFMAG_WDTH_SZ; widthIdx++)
+      {
+         WriteBufIdx(&me->lowFreqMag[orderIdx].queue.wIdx,
+                      me->lowFreqMag[orderIdx].queue.in, (int16_t)mag,
+                      MBSDA_LFMAG_WDTH_SZ);
+      }
+      me->lowFreqMag[orderIdx].aggregate = mag*MBSDA_LFMAG_WDTH_SZ;
+      me->lowFreqMag[orderIdx].output    = mag;
+   }
+   me->lfFiltOutput = mag;
+
+   for(widthIdx = 0; widthIdx < MBSDA_DER_WDTH_SZ; widthIdx++)
+   {
+      WriteBufIdx(&me->sclDer.queue.wIdx, me->sclDer.queue.in,
+                  (int16_t)mag, MBSDA_DER_WDTH_SZ);
+   }
+   me->sclDerCurr    = 0;
+   me->sclDerPrev    = 0;
+   me->sclDer.output = 0;
+
+   me->freqNumPk[MBSDA_PKNEG_IDX] = 0;
+   me->freqNumPk[MBSDA_PKPOS_IDX] = 0;
+   me->freqPkV[MBSDA_PKNEG_IDX]   = mag;
+   me->freqPkV[MBSDA_PKPOS_IDX]   = mag;
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   Goertzel_init(&me->gtzBank);
+#endif
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_boxcar
+@endinternal
+
+@b Parameter: @n
+@b   Input:   filt  - filter stage, its queue holds the last width inputs  @n
+@b            data  - new input                                            @n
+@b            width - number of averaged inputs                            @n
+@b   Returns: average of the last width inputs  @n
+
+@b Description: @n
+    One stage of a boxcar (moving average) cascade, the oldest input leaves
+    the running sum as the new one enters it.
+
+*******************************************************************************/
+int32_t Mbsda_boxcar(XlFilter * const filt, int16_t data, uint16_t width)
+{
+   filt->aggregate -= ReadBufIdx(&filt->queue.rIdx, filt->queue.in, width);
+   filt->aggregate += data;
+   WriteBufIdx(&filt->queue.wIdx, filt->queue.in, data, width);
+
+   filt->output = filt->aggregate / width;
+
+   return filt->output;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_getPkPrStat
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me        - pointer to the Mbsda instance            @n
+@b            signIdx   - MBSDA_PKPOS_IDX or MBSDA_PKNEG_IDX       @n
+@b            sampleIdx - xlSampleCnt of the peak                   @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Peak-pair statistics. Peaks whose swing from the last opposite peak is
+    under MBSDA_DEF_FREQ_HYS are noise and dropped. The interval between two
+    peaks of the same sign is a period, its smoothed value is mTpk and the
+    smoothed change between consecutive periods is mdTpk. mTpkR, their ratio
+    in Q14, is low for a steady rhythm.
+
+*******************************************************************************/
+void Mbsda_getPkPrStat(Mbsda * const me, uint8_t signIdx, uint32_t sampleIdx)
+{
+   uint16_t orderIdx;
+   int32_t  tpk;
+   int32_t  dpk;
+   int32_t  swing = me->lfFiltOutput - me->freqPkV[signIdx ^ 1];
+
+   if(labs(swing) < MBSDA_DEF_FREQ_HYS)
+   {
+      return;
+   }
+
+   me->freqPkV[signIdx]       = me->lfFiltOutput;
+   me->freqPkIdxPrev[signIdx] = me->freqPkIdxCurr[signIdx];
+   me->freqPkIdxCurr[signIdx] = (int32_t)sampleIdx;
+
+   if(me->freqNumPk[signIdx] < 2)
+   {
+      // A period needs two peaks of the same sign
+      me->freqNumPk[signIdx]++;
+      if(me->freqNumPk[signIdx] < 2)
+      {
+         return;
+      }
+   }
+
+   me->freqTpkPrev = me->freqTpkCurr;
+   me->freqTpkCurr = me->freqPkIdxCurr[signIdx] - me->freqPkIdxPrev[signIdx];
+   me->freqDpk     = (int16_t)labs(me->freqTpkCurr - me->freqTpkPrev);
+
+   tpk = me->freqTpkCurr > MAX_FX ? MAX_FX : me->freqTpkCurr;
+   dpk = me->freqDpk;
+   for(orderIdx = 0; orderIdx < MBSDA_INT_ORDR_SZ; orderIdx++)
+   {
+      tpk = Mbsda_boxcar(&me->mTpk[orderIdx],  (int16_t)tpk, MBSDA_INT_WDTH_SZ);
+      dpk = Mbsda_boxcar(&me->mdTpk[orderIdx], (int16_t)dpk, MBSDA_INT_WDTH_SZ);
+   }
+   me->mTpkFiltOutput  = tpk;
+   me->mdTpkFiltOutput = dpk;
+
+   if((tpk > 0) && (dpk < MBSDA_TPKR_RATIO_MAX*tpk))
+   {
+      me->mTpkR = DivFx((int16_t)dpk, (int16_t)tpk, N14);
+   }
+   else
+   {
+      me->mTpkR = MAX_FX;
+   }
+
+   if(me->freqPkCntr < UINT8_MAX)
+   {
+      me->freqPkCntr++;
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_freqSpectrum
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me  - pointer to the Mbsda instance  @n
+@b            mag - scaled squared magnitude of the new sample  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Keeps the last MBSDA_FFT_SIZE magnitude samples and every MBSDA_FFT_HOP
+    samples transforms them, so consecutive windows overlap by half. The
+    window mean is removed and the Hann windowed spectrum reduced to the
+    dominant frequency and the power in the MBSDA_FFT_BAND_LO to
+    MBSDA_FFT_BAND_HI band, published in freqSpec.
+@n
+@b Constraints: @n
+    The transform works on the stack, 4*MBSDA_FFT_SIZE bytes.
+
+*******************************************************************************/
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+void Mbsda_freqSpectrum(Mbsda * const me, int16_t mag)
+{
+   int16_t  re[MBSDA_FFT_SIZE];
+   int16_t  im[MBSDA_FFT_SIZE];
+   uint8_t  rd;
+   int32_t  sum = 0;
+   int32_t  mean;
+   int32_t  dev;
+   uint16_t n;
+
+   WriteBufIdx(&me->fftMagQ.wIdx, me->fftMagQ.in, mag, MBSDA_FFT_SIZE);
+
+   if(++me->fftHopCntr < MBSDA_FFT_HOP)
+   {
+      return;
+   }
+   me->fftHopCntr = 0;
+
+   // Suspended, the window and its hops stay in step for when it resumes
+   //
+   if(me->freqGated)
+   {
+      return;
+   }
+
+   // The write index is at the oldest sample
+   //
+   rd = me->fftMagQ.wIdx;
+   for(n = 0; n < MBSDA_FFT_SIZE; n++)
+   {
+      re[n] = ReadBufIdx(&rd, me->fftMagQ.in, MBSDA_FFT_SIZE);
+      sum  += re[n];
+   }
+   mean = sum >> MBSDA_FFT_LOG2;
+
+   // Twice the residual, saturated, keeps one more bit through the transform
+   //
+   for(n = 0; n < MBSDA_FFT_SIZE; n++)
+   {
+      dev   = (re[n] - mean) << 1;
+      dev   = dev >  MAX_FX ?  MAX_FX : dev;
+      dev   = dev < -MAX_FX ? -MAX_FX : dev;
+      re[n] = (int16_t)dev;
+      im[n] = 0;
+   }
+
+   FftFix_window(re, MBSDA_FFT_LOG2);
+   FftFix_transform(re, im, MBSDA_FFT_LOG2);
+   FftFix_features(re, im, MBSDA_FFT_LOG2, MBSDA_SAMPLE_HZ,
+                   MBSDA_FFT_BAND_LO, MBSDA_FFT_BAND_HI, &me->freqSpec);
+}
+#endif
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_freqGoertzel
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me        - pointer to the Mbsda instance               @n
+@b            mag       - scaled squared magnitude of the new sample  @n
+@b            sampleIdx - xlSampleCnt of the sample                   @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Low power alternative to Mbsda_freqSpectrum. The magnitude, less that
+    of the moving average of the axes, feeds a bank of MBSDA_GTZ_BINS
+    detectors across the band, one multiply-accumulate per detector and
+    sample. Every MBSDA_GTZ_BLOCK samples their powers are published in
+    freqSpec. There is no sample buffer and no out of band information, the
+    total power comes from the block energy instead.
+@n
+    Blocks end on multiples of MBSDA_GTZ_BLOCK samples whether the module
+    ran or not, so after Mbsda_freqRebuild they line up with those of an
+    instance that never stopped. A block that got less than half its
+    samples is dropped.
+
+*******************************************************************************/
+void Mbsda_freqGoertzel(Mbsda * const me, int16_t mag, uint32_t sampleIdx)
+{
+   int32_t  grav = 0;
+   int32_t  filt;
+   int32_t  dev;
+   uint16_t axisIdx;
+
+   for(axisIdx = 0; axisIdx < XL_NUM_AXIS; axisIdx++)
+   {
+      filt  = me->lastXyzFilt[axisIdx];
+      grav += filt*filt;
+   }
+   dev = mag - (grav >> MBSDA_MAG_SHIFT);
+   dev = dev >  MAX_FX ?  MAX_FX : dev;
+   dev = dev < -MAX_FX ? -MAX_FX : dev;
+
+   Goertzel_update(&me->gtzBank, l_gtzCoef, MBSDA_GTZ_BINS, (int16_t)dev);
+
+   if((sampleIdx % MBSDA_GTZ_BLOCK) == 0)
+   {
+      if(me->gtzBank.count >= MBSDA_GTZ_BLOCK/2)
+      {
+         Goertzel_read(&me->gtzBank, l_gtzCoef, l_gtzFreq, MBSDA_GTZ_BINS,
+                       &me->freqSpec);
+      }
+      else
+      {
+         Goertzel_init(&me->gtzBank);
+      }
+   }
+}
+#endif
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_getSummary
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me  - pointer to the Mbsda instance  @n
+@b   Output:  sum - current state and main features  @n
+
+@b Description: @n
+    Fills a compact summary of the instance, used by the background worker
+    to report state changes and features without exposing the module
+    structure.
+
+*******************************************************************************/
+void Mbsda_getSummary(Mbsda const * const me, MbsdaSummary * const sum)
+{
+   if(me->super.state.fun == Q_STATE_CAST(&Mbsda_startUp))
+   {
+      sum->state = MBSDA_STATE_STARTUP;
+   }
+   else if(me->super.state.fun == Q_STATE_CAST(&Mbsda_idle))
+   {
+      sum->state = MBSDA_STATE_IDLE;
+   }
+   else if(me->super.state.fun == Q_STATE_CAST(&Mbsda_lowActivity))
+   {
+      sum->state = MBSDA_STATE_LOW_ACTIVITY;
+   }
+   else
+   {
+      sum->state = MBSDA_STATE_NONE;
+   }
+
+   sum->szFlags     = me->szFlags;
+   sum->stdaXyz     = me->stdaXyz;
+   sum->mTpkR       = me->mTpkR;
+   sum->domFreq     = me->freqSpec.domFreq;
+   sum->bandRatio   = me->freqSpec.bandRatio;
+   sum->xlRateHz    = me->xlRateHz;
+   sum->xlSampleCnt = me->xlSampleCnt;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_setLowRate
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me    - pointer to the Mbsda instance                     @n
+@b            lowHz - accelerometer rate in Mbsda_lowActivity, 0 to    @n
+@b                    stay at MBSDA_INPUT_HZ                             @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Changes the rate asked for while activity is low, MBSDA_LOW_HZ by
+    default. Takes effect the next time Mbsda_lowActivity is entered; the
+    host reads the rate to set from the summary after every batch.
+
+*******************************************************************************/
+void Mbsda_setLowRate(Mbsda * const me, uint16_t lowHz)
+{
+   me->xlLowHz = (lowHz < MBSDA_SAMPLE_HZ) ? lowHz : 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_setPrime
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me      - pointer to the Mbsda instance                   @n
+@b            samples - input samples Mbsda_startUp lasts with primed  @n
+@b                      filters, 0 to prime them with zeros             @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Picks how the filters start, MBSDA_PRIME_SAMPLES by default. Takes
+    effect at the next start-up, so call it before QMSM_INIT.
+
+*******************************************************************************/
+void Mbsda_setPrime(Mbsda * const me, uint8_t samples)
+{
+   me->primeCnt = samples;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_save
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me     - pointer to the Mbsda instance                     @n
+@b            offset - position in the checkpoint of blob[0]            @n
+@b            size   - bytes available in blob                          @n
+@b   Output:  blob   - bytes offset to offset+size-1 of the checkpoint,  @n
+@b                     NULL to get the checkpoint size                   @n
+@b   Returns: bytes written, 0 past the end of the checkpoint, or the    @n
+@b            checkpoint size when blob is NULL                          @n
+
+@b Description: @n
+    Serialises the state of the instance into a compact little endian
+    checkpoint, to be handed back to Mbsda_restore after a restart. The
+    header carries a version, the rate profile and frequency module it was
+    built with, its length and the last sample timestamp; a Fletcher-16
+    closes it. Queue pointers are saved as indices into their buffers.
+@n
+    The checkpoint can be written out in pieces, one call per window, so
+    the host does not need a buffer for all of it. The instance must not
+    process samples between the calls of one checkpoint.
+
+*******************************************************************************/
+uint16_t Mbsda_save(Mbsda const * const me, uint8_t * const blob,
+                    uint16_t offset, uint16_t size)
+{
+   MbsdaCkpt    ck = { NULL, NULL, 0, 0, 0, 0, 0, 1 };
+   MbsdaSummary sum;
+   uint8_t      hdr[MBSDA_CKPT_HDR_SZ];
+   uint8_t      fletcher[MBSDA_CKPT_SUM_SZ];
+   uint16_t     len;
+   uint16_t     idx;
+
+   // Size of the body, the instance is only read
+   //
+   Mbsda_ckptWalk((Mbsda *)me, &ck);
+   len = MBSDA_CKPT_HDR_SZ + ck.pos + MBSDA_CKPT_SUM_SZ;
+   if(blob == NULL)
+   {
+      return len;
+   }
+
+   Mbsda_getSummary(me, &sum);
+   hdr[0]  = MBSDA_CKPT_MAGIC0;
+   hdr[1]  = MBSDA_CKPT_MAGIC1;
+   hdr[2]  = MBSDA_CKPT_VERSION;
+   hdr[3]  = sum.state;
+   hdr[4]  = MBSDA_SAMPLE_HZ;
+   hdr[5]  = MBSDA_DECIM;
+   hdr[6]  = MBSDA_FREQ_MODULE;
+   hdr[7]  = (uint8_t)len;
+   hdr[8]  = (uint8_t)(len >> 8);
+   hdr[9]  = (uint8_t)me->lastTimestamp;
+   hdr[10] = (uint8_t)(me->lastTimestamp >> 8);
+   hdr[11] = (uint8_t)(me->lastTimestamp >> 16);
+   hdr[12] = (uint8_t)(me->lastTimestamp >> 24);
+
+   ck.out    = blob;
+   ck.offset = offset;
+   ck.size   = size;
+   ck.pos    = 0;
+   ck.sum1   = 0;
+   ck.sum2   = 0;
+   for(idx = 0; idx < MBSDA_CKPT_HDR_SZ; idx++)
+   {
+      Mbsda_ckptByte(&ck, &hdr[idx]);
+   }
+   Mbsda_ckptWalk((Mbsda *)me, &ck);
+   fletcher[0] = ck.sum1;
+   fletcher[1] = ck.sum2;
+   Mbsda_ckptByte(&ck, &fletcher[0]);
+   Mbsda_ckptByte(&ck, &fletcher[1]);
+
+   if(offset >= len)
+   {
+      return 0;
+   }
+   return ((len - offset) < size) ? (len - offset) : size;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_restore
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me       - pointer to a constructed, not yet initialised  @n
+@b                       Mbsda instance                                  @n
+@b            blob     - checkpoint from Mbsda_save                      @n
+@b            len      - bytes in blob                                   @n
+@b            now      - timestamp of the next sample to be dispatched   @n
+@b            maxAgeMs - oldest checkpoint accepted                      @n
+@b   Returns: true if the instance was restored  @n
+
+@b Description: @n
+    Loads a checkpoint written by the same build, taken in Mbsda_idle or
+    Mbsda_lowActivity no more than maxAgeMs before now. The initial
+    transition of the restored instance goes straight to Mbsda_idle, which
+    asks for the full accelerometer rate again; the low rate setting of the
+    instance is kept. On any mismatch the instance is left as constructed
+    and goes through Mbsda_startUp as usual.
+
+*******************************************************************************/
+bool Mbsda_restore(Mbsda * const me, uint8_t const * const blob, uint16_t len,
+                   uint32_t now, uint32_t maxAgeMs)
+{
+   MbsdaCkpt ck = { NULL, NULL, 0, 0, 0, 0, 0, 1 };
+   uint32_t  saved;
+   uint16_t  lowHz;
+   uint16_t  idx;
+   uint8_t   data;
+
+   if((len < MBSDA_CKPT_HDR_SZ + MBSDA_CKPT_SUM_SZ) ||
+      (blob[0] != MBSDA_CKPT_MAGIC0) || (blob[1] != MBSDA_CKPT_MAGIC1) ||
+      (blob[2] != MBSDA_CKPT_VERSION) ||
+      ((blob[3] != MBSDA_STATE_IDLE) && (blob[3] != MBSDA_STATE_LOW_ACTIVITY)) ||
+      (blob[4] != MBSDA_SAMPLE_HZ) || (blob[5] != MBSDA_DECIM) ||
+      (blob[6] != MBSDA_FREQ_MODULE) ||
+      ((uint16_t)(blob[7] | (blob[8] << 8)) != len))
+   {
+      return false;
+   }
+
+   // Fletcher-16 over everything but itself, as Mbsda_ckptByte runs it
+   //
+   ck.out  = NULL;
+   ck.size = 0;
+   for(idx = 0; idx < len - MBSDA_CKPT_SUM_SZ; idx++)
+   {
+      data = blob[idx];
+      Mbsda_ckptByte(&ck, &data);
+   }
+   if((blob[len - 2] != ck.sum1) || (blob[len - 1] != ck.sum2))
+   {
+      return false;
+   }
+
+   saved = (uint32_t)blob[9]          | ((uint32_t)blob[10] << 8) |
+           ((uint32_t)blob[11] << 16) | ((uint32_t)blob[12] << 24);
+   if((uint32_t)(now - saved) > maxAgeMs)
+   {
+      return false;
+   }
+
+   ck.in  = blob;
+   ck.pos = MBSDA_CKPT_HDR_SZ;
+   Mbsda_ckptWalk(me, &ck);
+   if(!ck.ok || (ck.pos != len - MBSDA_CKPT_SUM_SZ))
+   {
+      lowHz = me->xlLowHz;
+      Mbsda_ctorObj(me);
+      me->xlLowHz = lowHz;
+      return false;
+   }
+
+   me->lastTimestamp = now;
+   QFsm_ctor(&me->super, (QStateHandler)&Mbsda_resume);
+
+   return true;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ckptWalk
+@endinternal
+
+@b Parameter: @n
+@b   Input:   me - pointer to the Mbsda instance                        @n
+@b            ck - checkpoint cursor, saving if ck->in is NULL          @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Visits every member of the instance that carries state, in checkpoint
+    order, so saving and restoring cannot drift apart. Buffer bases, the
+    state machine and the low rate and priming settings are left out: the
+    first two come from the constructor, the others belong to the host.
+    The last timestamp is in the header.
+
+*******************************************************************************/
+void Mbsda_ckptWalk(Mbsda * const me, MbsdaCkpt * const ck)
+{
+   uint16_t idx;
+
+   MBSDA_CKPT_VAL(ck, me->pgmSsValue);
+
+   MBSDA_CKPT_ARR(ck, me->xBufSto);
+   MBSDA_CKPT_ARR(ck, me->yBufSto);
+   MBSDA_CKPT_ARR(ck, me->zBufSto);
+   MBSDA_CKPT_ARR(ck, me->lfBufSto);
+   MBSDA_CKPT_ARR(ck, me->sclDerBufSto);
+   MBSDA_CKPT_ARR(ck, me->mTpkBufSto);
+   MBSDA_CKPT_ARR(ck, me->mdTpkBufSto);
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   MBSDA_CKPT_ARR(ck, me->fftMagBufSto);
+#endif
+
+#if (MBSDA_DECIM > 1)
+   for(idx = 0; idx < XL_NUM_AXIS; idx++)
+   {
+      MBSDA_CKPT_ARR(ck, me->decim[idx].line);
+      MBSDA_CKPT_VAL(ck, me->decim[idx].acc);
+      MBSDA_CKPT_VAL(ck, me->decim[idx].phase);
+      MBSDA_CKPT_VAL(ck, me->decim[idx].pos);
+   }
+#endif
+
+   Mbsda_ckptQueue(ck, &me->xQ, MBSDA_ORD_SIZE);
+   Mbsda_ckptQueue(ck, &me->yQ, MBSDA_ORD_SIZE);
+   Mbsda_ckptQueue(ck, &me->zQ, MBSDA_ORD_SIZE);
+
+   MBSDA_CKPT_VAL(ck, me->stdaXyz);
+   MBSDA_CKPT_VAL(ck, me->xlSampleCnt);
+   MBSDA_CKPT_ARR(ck, me->xyzAggregate);
+   MBSDA_CKPT_ARR(ck, me->lastXyzFilt);
+   MBSDA_CKPT_VAL(ck, me->xlRateHz);
+   MBSDA_CKPT_VAL(ck, me->startTick);
+
+   MBSDA_CKPT_VAL(ck, me->lfFiltOutput);
+   for(idx = 0; idx < MBSDA_LFMAG_ORDR_SZ; idx++)
+   {
+      MBSDA_CKPT_VAL(ck, me->lowFreqMag[idx].output);
+      MBSDA_CKPT_VAL(ck, me->lowFreqMag[idx].aggregate);
+      Mbsda_ckptQueue(ck, &me->lowFreqMag[idx].queue, MBSDA_LFMAG_WDTH_SZ);
+   }
+   MBSDA_CKPT_VAL(ck, me->sclDerCurr);
+   MBSDA_CKPT_VAL(ck, me->sclDerPrev);
+   MBSDA_CKPT_VAL(ck, me->sclDer.output);
+   MBSDA_CKPT_VAL(ck, me->sclDer.aggregate);
+   Mbsda_ckptQueue(ck, &me->sclDer.queue, MBSDA_DER_WDTH_SZ);
+   MBSDA_CKPT_VAL(ck, me->mTpkFiltOutput);
+   MBSDA_CKPT_VAL(ck, me->mdTpkFiltOutput);
+   for(idx = 0; idx < MBSDA_INT_ORDR_SZ; idx++)
+   {
+      MBSDA_CKPT_VAL(ck, me->mTpk[idx].output);
+      MBSDA_CKPT_VAL(ck, me->mTpk[idx].aggregate);
+      Mbsda_ckptQueue(ck, &me->mTpk[idx].queue, MBSDA_INT_WDTH_SZ);
+      MBSDA_CKPT_VAL(ck, me->mdTpk[idx].output);
+      MBSDA_CKPT_VAL(ck, me->mdTpk[idx].aggregate);
+      Mbsda_ckptQueue(ck, &me->mdTpk[idx].queue, MBSDA_INT_WDTH_SZ);
+   }
+
+   MBSDA_CKPT_VAL(ck, me->mTpkR);
+   MBSDA_CKPT_VAL(ck, me->zAct);
+   MBSDA_CKPT_VAL(ck, me->zStdFreq);
+   MBSDA_CKPT_ARR(ck, me->freqNumPk);
+   MBSDA_CKPT_ARR(ck, me->freqPkV);
+   MBSDA_CKPT_ARR(ck, me->freqPkIdxCurr);
+   MBSDA_CKPT_ARR(ck, me->freqPkIdxPrev);
+   MBSDA_CKPT_VAL(ck, me->freqTpkCurr);
+   MBSDA_CKPT_VAL(ck, me->freqTpkPrev);
+   MBSDA_CKPT_VAL(ck, me->freqDpk);
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   Mbsda_ckptQueue(ck, &me->fftMagQ, MBSDA_FFT_SIZE);
+   MBSDA_CKPT_VAL(ck, me->fftHopCntr);
+#elif (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   MBSDA_CKPT_ARR(ck, me->gtzBank.s1);
+   MBSDA_CKPT_ARR(ck, me->gtzBank.s2);
+   MBSDA_CKPT_VAL(ck, me->gtzBank.energy);
+   MBSDA_CKPT_VAL(ck, me->gtzBank.count);
+#endif
+   MBSDA_CKPT_VAL(ck, me->freqSpec.domFreq);
+   MBSDA_CKPT_VAL(ck, me->freqSpec.bandRatio);
+   MBSDA_CKPT_VAL(ck, me->freqSpec.bandPwr);
+   MBSDA_CKPT_VAL(ck, me->freqSpec.totalPwr);
+   MBSDA_CKPT_VAL(ck, me->freqSampleCnt);
+   MBSDA_CKPT_VAL(ck, me->freqGated);
+
+   MBSDA_CKPT_VAL(ck, me->startCnt);
+   MBSDA_CKPT_VAL(ck, me->szFlags);
+   MBSDA_CKPT_VAL(ck, me->freqPkCntr);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ckptByte
+@endinternal
+
+@b Parameter: @n
+@b   Input:   ck   - checkpoint cursor                             @n
+@b   In/Out:  data - byte to save, or the restored byte            @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Moves one byte between the instance and the blob. When saving, the
+    byte goes to the output window if it falls inside it and into the
+    running Fletcher-16.
+
+*******************************************************************************/
+void Mbsda_ckptByte(MbsdaCkpt * const ck, uint8_t * const data)
+{
+   if(ck->in != NULL)
+   {
+      *data = ck->in[ck->pos];
+   }
+   else
+   {
+      if((ck->out != NULL) && (ck->pos >= ck->offset) &&
+         (ck->pos - ck->offset < ck->size))
+      {
+         ck->out[ck->pos - ck->offset] = *data;
+      }
+      ck->sum1 = (uint8_t)((ck->sum1 + *data) % 255);
+      ck->sum2 = (uint8_t)((ck->sum2 + ck->sum1) % 255);
+   }
+   ck->pos++;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ckptVal
+@endinternal
+
+@b Parameter: @n
+@b   Input:   ck    - checkpoint cursor                            @n
+@b            bytes - size of the integer, 1, 2, 4 or 8            @n
+@b   In/Out:  val   - integer member to save or restore            @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Saves or restores one integer member, least significant byte first.
+
+*******************************************************************************/
+void Mbsda_ckptVal(MbsdaCkpt * const ck, void * const val, uint16_t bytes)
+{
+   uint64_t data = 0;
+   uint8_t  byte;
+   uint16_t byteIdx;
+
+   switch(bytes)
+   {
+      case 1: data = *(uint8_t  *)val; break;
+      case 2: data = *(uint16_t *)val; break;
+      case 4: data = *(uint32_t *)val; break;
+      case 8: data = *(uint64_t *)val; break;
+   }
+
+   for(byteIdx = 0; byteIdx < bytes; byteIdx++)
+   {
+      byte = (uint8_t)(data >> (8*byteIdx));
+      Mbsda_ckptByte(ck, &byte);
+      data = (data & ~((uint64_t)0xFF << (8*byteIdx))) |
+             ((uint64_t)byte << (8*byteIdx));
+   }
+
+   if(ck->in != NULL)
+   {
+      switch(bytes)
+      {
+         case 1: *(uint8_t  *)val = (uint8_t)data;  break;
+         case 2: *(uint16_t *)val = (uint16_t)data; break;
+         case 4: *(uint32_t *)val = (uint32_t)data; break;
+         case 8: *(uint64_t *)val = data;           break;
+      }
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ckptArr
+@endinternal
+
+@b Parameter: @n
+@b   Input:   ck    - checkpoint cursor                            @n
+@b            count - elements of the array                        @n
+@b            bytes - size of one element                          @n
+@b   In/Out:  arr   - integer array member to save or restore      @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Saves or restores an array of integers, one element at a time.
+
+*******************************************************************************/
+void Mbsda_ckptArr(MbsdaCkpt * const ck, void * const arr, uint16_t count,
+                   uint16_t bytes)
+{
+   uint16_t idx;
+
+   for(idx = 0; idx < count; idx++)
+   {
+      Mbsda_ckptVal(ck, (uint8_t *)arr + idx*bytes, bytes);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Mbsda_ckptQueue
+@endinternal
+
+@b Parameter: @n
+@b   Input:   ck   - checkpoint cursor                             @n
+@b            size - size of the queue buffer                      @n
+@b   In/Out:  q    - queue whose read and write indices to save    @n
+@b                   or restore                                    @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Saves or restores the read and write indices of a queue, a restored
+    index past the end of the buffer fails the restore. The buffer
+    contents go with the storage arrays.
+
+*******************************************************************************/
+void Mbsda_ckptQueue(MbsdaCkpt * const ck, XlQueue * const q, uint16_t size)
+{
+   Mbsda_ckptByte(ck, &q->rIdx);
+   Mbsda_ckptByte(ck, &q->wIdx);
+
+   if((q->rIdx >= size) || (q->wIdx >= size))
+   {
+      ck->ok = 0;
+   }
+}
@@ -1,33 +1,95 @@
-/**
-********************************************************************************
-@internal
-Copyright(c) 2013 Cyberonics Inc.  All Rights Reserved.
-
-This software is proprietary and confidential.  By using this software
-You agree with the terms of the associated Cyberonics Inc. License Agreement
-This file is documented using Doxygen annotations for extraction of detail
-design description items.
-@endinternal
-
-@file  AlgMbsda.h
-
-@brief  @b Description: @n
-   This file includes the function prototypes for the Motion Based Seizure
-   Detection Algorithm (MBSDA).
-
-@internal
-* Change Log: Major releases will be captured here, minor releases will use
-*             SVN check-in/history log for details.
-@endinternal
-*******************************************************************************/
-#ifndef ALGMBSDA_H
-#define ALGMBSDA_H
-
-//
-// PUBLIC FUNCTION PROTOTYPE
-//
-QFsm * Mbsda_ctor(void);
-
-extern QFsm * const FSM_Mbsda;
-
-#endif // ALGMBSDA_H
+/**
+********************************************************************************
+@internal
+Copyright(c) 2013 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  AlgMbsda.h
+
+@brief  @b Description: @n
+   This file includes the function prototypes for the Motion Based Seizure
+   Detection Algorithm (MBSDA).
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#ifndef ALGMBSDA_H
+#define ALGMBSDA_H
+
+//====================================================================
+// Global signals
+//
+enum SystemSignals
+{
+   XL_DATA_SIG = Q_USER_SIG,  // 4,
+   TEST_SIG,
+
+   MBSDA_MAX_SIG              // Keep last, sizes the signal action tables
+};
+
+//====================================================================
+// Event structure for collected accelerometer data
+//
+typedef struct XlDataEvtTag
+{
+   // QP event structure for all events
+   QEvt super;
+
+   uint32_t timeStamp;
+   int16_t  x;
+   int16_t  y;
+   int16_t  z;
+
+} XlDataEvt;
+
+//====================================================================
+// Compact view of an Mbsda instance, for reporting outside the module
+//
+enum MbsdaStateId
+{
+   MBSDA_STATE_NONE = 0,
+   MBSDA_STATE_STARTUP,
+   MBSDA_STATE_IDLE,
+   MBSDA_STATE_LOW_ACTIVITY
+};
+
+typedef struct MbsdaSummaryTag
+{
+   uint8_t  state;       // enum MbsdaStateId
+   uint8_t  szFlags;     // status flags
+   uint16_t stdaXyz;     // short term dynamic activity
+   int16_t  mTpkR;       // ratio of filtered mdTpk and mTpk
+   uint16_t domFreq;     // dominant frequency of the magnitude, Hz in Q8
+   uint16_t bandRatio;   // share of the power in the band, Q14
+   uint16_t xlRateHz;    // accelerometer rate the instance asks for
+   uint32_t xlSampleCnt; // accumulated count of XL samples
+
+} MbsdaSummary;
+
+struct MbsdaTag;
+
+//
+// PUBLIC FUNCTION PROTOTYPE
+//
+QFsm * Mbsda_ctor(void);
+QFsm * Mbsda_ctorObj(struct MbsdaTag * const me);
+void   Mbsda_getSummary(struct MbsdaTag const * const me, MbsdaSummary * const sum);
+void   Mbsda_setLowRate(struct MbsdaTag * const me, uint16_t lowHz);
+void   Mbsda_setPrime(struct MbsdaTag * const me, uint8_t samples);
+
+// Checkpoint of the whole instance, to resume detection after a restart
+uint16_t Mbsda_save(struct MbsdaTag const * const me, uint8_t * const blob,
+                    uint16_t offset, uint16_t size);
+bool     Mbsda_restore(struct MbsdaTag * const me, uint8_t const * const blob,
+                       uint16_t len, uint32_t now, uint32_t maxAgeMs);
+
+extern QFsm * const FSM_Mbsda;
+
+#endif // ALGMBSDA_H
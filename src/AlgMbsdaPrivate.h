@@ -1,146 +1,309 @@
-/**
-********************************************************************************
-@internal
-Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
-
-This software is proprietary and confidential.  By using this software
-You agree with the terms of the associated Cyberonics Inc. License Agreement
-This file is documented using Doxygen annotations for extraction of detail
-design description items.
-@endinternal
-
-@file  AlgMbsdaPrivate.h
-
-@brief  @b Description: @n
-   This file includes the structure that defines the MBSDA component. Most
-    cases will have this structure defined in the source file, but for testing
-    purposes this structure needs to be exposed to test related source files.
-
-@internal
-* Change Log: Major releases will be captured here, minor releases will use
-*             SVN check-in/history log for details.
-@endinternal
-*******************************************************************************/
-#ifndef ALGMBSDA_PRIVATE_H
-#define ALGMBSDA_PRIVATE_H
-
-#include "qep_port.h"
-
-//==============================================================================
-// Mbsda state machine structure definition dependencies
-//==============================================================================
-#define MBSDA_ORD_SIZE      39  // Order value for 50 Hz sampling rate
-
-#define MBSDA_LFMAG_WDTH_SZ  4  // Width of integrator kernel
-#define MBSDA_LFMAG_ORDR_SZ  4  // Order of integrator kernel
-#define MBSDA_DER_WDTH_SZ    2  // Width size for derivative calculations
-#define MBSDA_DER_ORDR_SZ    1  // Order size for derivative calculations
-#define MBSDA_INT_WDTH_SZ   24  // Smoothing width (peaks)
-#define MBSDA_INT_ORDR_SZ    2  // Smoothing order
-
-#define MBSDA_PKPOS_IDX      0  // Index for negative peak parameters
-#define MBSDA_PKNEG_IDX      1  // Index for positive peak parameters
-#define MBSDA_SIGN_IDX_SZ    2
-
-#define XL_NUM_AXIS 3
-#define XL_X_AXIS   0
-#define XL_Y_AXIS   1
-#define XL_Z_AXIS   2
-
-// ===================================================================
-/// struct @b XlQueue - queue structure for ring buffer functions
-// ===================================================================
-typedef struct XlQueueTag
-{
-  int16_t *in;  // Specific buffer storage pointer
-  int16_t *rIn; // read pointer
-  int16_t *wIn; // write pointer
-
-} XlQueue;
-
-// ===================================================================
-/// struct @b XlFilter - common structure for filter calculations
-// ===================================================================
-typedef struct XlFilterTag
-{
-   int32_t           output;    // filtered output value
-   int32_t           aggregate; // Cumulative Sum value
-   struct XlQueueTag queue;     // Queue for this specific filter calculations
-
-} XlFilter;
-
-//==============================================================================
-/// struct @b Mbsda - State machine class/structure for the MBSDA module.
-//==============================================================================
-typedef struct MbsdaTag
-{
-   QFsm super; // QP required "inherited" structure for component-based state
-               //   machine
-               // THIS MUST BE THE FIRST ITEM IN THIS STRUCTURE
-
-//   MbsdaPgmParms pgm;         // Programmable parameters structure
-   uint8_t       pgmSsValue;  // Current sensitivity setting used
-
-   // ======================================================
-   // Queue buffer storage allocation
-   // X,Y,Z buffer storage
-   int16_t xBufSto[MBSDA_ORD_SIZE];
-   int16_t yBufSto[MBSDA_ORD_SIZE];
-   int16_t zBufSto[MBSDA_ORD_SIZE];
-
-   // Frequency module related filter buffer storage
-   int16_t lfBufSto    [MBSDA_LFMAG_WDTH_SZ*MBSDA_LFMAG_ORDR_SZ];
-   int16_t sclDerBufSto[MBSDA_DER_WDTH_SZ];
-   int16_t mTpkBufSto  [MBSDA_INT_WDTH_SZ*MBSDA_INT_ORDR_SZ];
-   int16_t mdTpkBufSto [MBSDA_INT_WDTH_SZ*MBSDA_INT_ORDR_SZ];
-
-   // ======================================================
-   // Activity based filter queues for x, y, & z axis
-   XlQueue xQ;
-   XlQueue yQ;
-   XlQueue zQ;
-
-   uint16_t stdaXyz;       // Short Term Dynamic Activity (stda) measure
-   uint32_t xlSampleCnt;   // Accumulated count of XL samples
-
-   uint32_t lastXyzFilt[XL_NUM_AXIS]; // last filtered value storage
-
-   uint32_t lastTimestamp; // Capture the last timestamp from last sample
-   uint32_t startTick;     // Capture specific timestamp for delta calculations
-
-   //
-   // FREQUENCY module based parameters
-   //
-   int32_t  lfFiltOutput; // low frequency filtered output value
-   XlFilter lowFreqMag[MBSDA_LFMAG_ORDR_SZ]; // Boxcar filter LF struct calcs
-   int32_t  sclDerCurr;   // Current scaled-derivative value
-   int32_t  sclDerPrev;   // Previous scaled-derivative value
-   XlFilter sclDer;       // Scaled-derivative filter struct for calculations
-   int32_t  mTpkFiltOutput; // peak-peak period value filtered output
-   XlFilter mTpk[MBSDA_INT_ORDR_SZ]; // peak-peak period filter struct
-   int32_t  mdTpkFiltOutput;// peak-peak deviation filtered output
-   XlFilter mdTpk[MBSDA_INT_ORDR_SZ];// peak-peak deviation filter struct
-
-   int16_t mTpkR;   // Ratio of filtered mdTpk and mTpk
-   int16_t zAct;    // Captured Z value when activity starts
-   int16_t zStdFreq;// Captured Z filtered value in freqPending
-
-   // Parameters for calculations in getPkPrStat function
-   //
-   int32_t freqNumPk[MBSDA_SIGN_IDX_SZ];
-   int32_t freqPkV[MBSDA_SIGN_IDX_SZ];
-   int32_t freqPkIdxCurr[MBSDA_SIGN_IDX_SZ];
-   int32_t freqPkIdxPrev[MBSDA_SIGN_IDX_SZ];
-
-   // pkStat specific parameters
-   int32_t freqTpkCurr;
-   int32_t freqTpkPrev;
-   int16_t freqDpk;
-
-   uint8_t szFlags;    // Status flag value to provide state information
-
-   uint8_t freqPkCntr; // Number of peaks counter
-
-} Mbsda;
-
-#endif // ALGMBSDA_PRIVATE_H
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  AlgMbsdaPrivate.h
+
+@brief  @b Description: @n
+   This file includes the structure that defines the MBSDA component. Most
+    cases will have this structure defined in the source file, but for testing
+    purposes this structure needs to be exposed to test related source files.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#ifndef ALGMBSDA_PRIVATE_H
+#define ALGMBSDA_PRIVATE_H
+
+#include "qep_port.h"
+#include "FftFix.h"
+#include "GoertzelFix.h"
+#include "DecimFix.h"
+#include "AlgMbsdaRate.h"
+
+//==============================================================================
+// Mbsda state machine structure definition dependencies
+//==============================================================================
+// Sample rate dependent dimensions come from the profile in AlgMbsdaRate.h
+#define MBSDA_DER_ORDR_SZ    1  // Order size for derivative calculations
+#define MBSDA_INT_WDTH_SZ   24  // Smoothing width (peaks, not samples)
+#define MBSDA_INT_ORDR_SZ    2  // Smoothing order
+
+// Spectral stage of the frequency module, next to the peak-pair statistics
+// that always run. Both spectral stages publish the same FftFeatures, only
+// domFreq and bandRatio compare between them.
+#define MBSDA_FREQ_PKPR      0  // Peak pairs only
+#define MBSDA_FREQ_FFT       1  // FFT of overlapping windows
+#define MBSDA_FREQ_GOERTZEL  2  // Goertzel bank across the band, per sample
+#ifndef MBSDA_FREQ_MODULE
+   #define MBSDA_FREQ_MODULE MBSDA_FREQ_FFT
+#endif
+
+// The frequency module is suspended while stdaXyz is under the low activity
+// threshold and rebuilt from the activity queues when it is needed again.
+// 0 runs it on every sample.
+#ifndef MBSDA_FREQ_GATE
+   #define MBSDA_FREQ_GATE   1
+#endif
+
+// Input samples Mbsda_startUp lasts when the filters are primed from the
+// first sample, see Mbsda_setPrime. 0 starts them from zero, 0 g on every
+// axis, and waits MBSDA_STARTUP_DELAY for them to settle.
+#ifndef MBSDA_PRIME_SAMPLES
+   #define MBSDA_PRIME_SAMPLES (4*MBSDA_DECIM)
+#endif
+#if (MBSDA_PRIME_SAMPLES > 255)
+   #error "MBSDA_PRIME_SAMPLES must fit in a byte"
+#endif
+
+#define MBSDA_FFT_SIZE      (1 << MBSDA_FFT_LOG2)
+#define MBSDA_FFT_HOP       (MBSDA_FFT_SIZE/2) // Half window, 50% overlap
+#define MBSDA_FFT_BAND_LO    2  // Clonic band of interest, Hz
+#define MBSDA_GTZ_BINS       8  // Detectors across the band
+
+#define MBSDA_PKPOS_IDX      0  // Index for negative peak parameters
+#define MBSDA_PKNEG_IDX      1  // Index for positive peak parameters
+#define MBSDA_SIGN_IDX_SZ    2
+
+#define XL_NUM_AXIS 3
+#define XL_X_AXIS   0
+#define XL_Y_AXIS   1
+#define XL_Z_AXIS   2
+
+// ===================================================================
+/// struct @b XlQueue - queue structure for ring buffer functions
+// ===================================================================
+typedef struct XlQueueTag
+{
+  int16_t *in;   // Specific buffer storage pointer
+  uint8_t  rIdx; // read index
+  uint8_t  wIdx; // write index
+
+} XlQueue;
+
+// Queue indices are bytes
+#if (MBSDA_ORD_SIZE > 256) || (MBSDA_FFT_SIZE > 256)
+   #error "XlQueue buffers must hold at most 256 samples"
+#endif
+
+// ===================================================================
+/// struct @b XlFilter - common structure for filter calculations
+// ===================================================================
+typedef struct XlFilterTag
+{
+   int32_t           output;    // filtered output value
+   int32_t           aggregate; // Cumulative Sum value
+   struct XlQueueTag queue;     // Queue for this specific filter calculations
+
+} XlFilter;
+
+//==============================================================================
+/// struct @b Mbsda - State machine class/structure for the MBSDA module.
+//
+// Members are grouped by how often they are used, see MBSDA_LAYOUT, so the
+// per sample work stays within the first cache lines of an instance.
+//==============================================================================
+typedef struct MbsdaTag
+{
+   QFsm super; // QP required "inherited" structure for component-based state
+               //   machine
+               // THIS MUST BE THE FIRST ITEM IN THIS STRUCTURE
+
+   // ======================================================
+   // Every sample
+   // Activity based filter queues for x, y, & z axis
+   XlQueue xQ;
+   XlQueue yQ;
+   XlQueue zQ;
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   XlQueue fftMagQ;        // Last MBSDA_FFT_SIZE magnitude samples
+#endif
+
+   int32_t  xyzAggregate[XL_NUM_AXIS]; // Sum of the samples in xQ/yQ/zQ
+   uint32_t xlSampleCnt;   // Accumulated count of XL samples
+   uint32_t lastTimestamp; // Capture the last timestamp from last sample
+   int16_t  lastXyzFilt[XL_NUM_AXIS]; // last filtered value storage
+   uint16_t stdaXyz;       // Short Term Dynamic Activity (stda) measure
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   uint16_t fftHopCntr;    // Samples since the last spectrum
+#endif
+   uint8_t  freqGated;     // Frequency module suspended, see Mbsda_freqGate
+
+   // ======================================================
+   // Every sample the FREQUENCY module runs on
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   GoertzelBank gtzBank;   // Detectors over the current block
+#endif
+   XlFilter lowFreqMag[MBSDA_LFMAG_ORDR_SZ]; // Boxcar filter LF struct calcs
+   XlFilter sclDer;        // Scaled-derivative filter struct for calculations
+   int32_t  lfFiltOutput;  // low frequency filtered output value
+   int32_t  sclDerCurr;    // Current scaled-derivative value
+   int32_t  sclDerPrev;    // Previous scaled-derivative value
+   uint32_t freqSampleCnt; // Last sample the frequency module ran on
+
+   // ======================================================
+   // Every peak, spectrum or Goertzel block
+   XlFilter mTpk[MBSDA_INT_ORDR_SZ]; // peak-peak period filter struct
+   XlFilter mdTpk[MBSDA_INT_ORDR_SZ];// peak-peak deviation filter struct
+   int32_t  mTpkFiltOutput; // peak-peak period value filtered output
+   int32_t  mdTpkFiltOutput;// peak-peak deviation filtered output
+
+   // Parameters for calculations in getPkPrStat function
+   //
+   int32_t freqNumPk[MBSDA_SIGN_IDX_SZ];
+   int32_t freqPkV[MBSDA_SIGN_IDX_SZ];
+   int32_t freqPkIdxCurr[MBSDA_SIGN_IDX_SZ];
+   int32_t freqPkIdxPrev[MBSDA_SIGN_IDX_SZ];
+
+   // pkStat specific parameters
+   int32_t freqTpkCurr;
+   int32_t freqTpkPrev;
+
+   FftFeatures freqSpec;   // Features of the last spectrum or block
+
+   int16_t freqDpk;
+   int16_t mTpkR;          // Ratio of filtered mdTpk and mTpk
+   uint8_t freqPkCntr;     // Number of peaks counter
+
+   // ======================================================
+   // State changes, settings and read outs
+   uint32_t startTick;     // Capture specific timestamp for delta calculations
+   uint16_t xlLowHz;       // Rate asked for in Mbsda_lowActivity, 0 if none
+   uint16_t xlRateHz;      // Accelerometer rate asked for, see Mbsda_setLowRate
+   int16_t  zAct;          // Captured Z value when activity starts
+   int16_t  zStdFreq;      // Captured Z filtered value in freqPending
+
+//   MbsdaPgmParms pgm;         // Programmable parameters structure
+   uint8_t  pgmSsValue;    // Current sensitivity setting used
+   uint8_t  primeCnt;      // Start-up length when priming, 0 primes with zeros
+   uint8_t  startCnt;      // Input samples seen in Mbsda_startUp
+   uint8_t  szFlags;       // Status flag value to provide state information
+
+   // ======================================================
+   // Queue buffer storage allocation, one entry of each is touched per
+   // sample
+#if (MBSDA_DECIM > 1)
+   DecimFix decim[XL_NUM_AXIS]; // Anti-alias decimators, x, y & z
+#endif
+
+   // X,Y,Z buffer storage
+   int16_t xBufSto[MBSDA_ORD_SIZE];
+   int16_t yBufSto[MBSDA_ORD_SIZE];
+   int16_t zBufSto[MBSDA_ORD_SIZE];
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   int16_t fftMagBufSto[MBSDA_FFT_SIZE];
+#endif
+
+   // Frequency module related filter buffer storage
+   int16_t lfBufSto    [MBSDA_LFMAG_WDTH_SZ*MBSDA_LFMAG_ORDR_SZ];
+   int16_t sclDerBufSto[MBSDA_DER_WDTH_SZ];
+   int16_t mTpkBufSto  [MBSDA_INT_WDTH_SZ*MBSDA_INT_ORDR_SZ];
+   int16_t mdTpkBufSto [MBSDA_INT_WDTH_SZ*MBSDA_INT_ORDR_SZ];
+
+} Mbsda;
+
+//==============================================================================
+// Layout of Mbsda, every member in declaration order with its group:
+//   HOT   every sample
+//   FREQ  every sample the frequency module runs on
+//   PEAK  every peak, spectrum or Goertzel block
+//   COLD  state changes, settings and read outs
+//   STORE queue storage and decimator lines
+// AlgMbsda.c checks at build time that the HOT members end within
+// MBSDA_HOT_MAX bytes, two cache lines of 64 bytes, and that no more than
+// MBSDA_LAYOUT_PAD_MAX bytes go to padding, the holes at group boundaries
+// and at the end. The "layout" suite of host/mbsda_bench.c prints the
+// offsets, sizes and padding.
+//==============================================================================
+#define MBSDA_HOT_MAX        128
+#define MBSDA_LAYOUT_PAD_MAX  12
+
+#define MBSDA_GRP_HOT   0
+#define MBSDA_GRP_FREQ  1
+#define MBSDA_GRP_PEAK  2
+#define MBSDA_GRP_COLD  3
+#define MBSDA_GRP_STORE 4
+
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_FFT)
+   #define MBSDA_LAYOUT_FFTQ(M_)   M_(HOT, fftMagQ)
+   #define MBSDA_LAYOUT_FFTHOP(M_) M_(HOT, fftHopCntr)
+   #define MBSDA_LAYOUT_FFTBUF(M_) M_(STORE, fftMagBufSto)
+#else
+   #define MBSDA_LAYOUT_FFTQ(M_)
+   #define MBSDA_LAYOUT_FFTHOP(M_)
+   #define MBSDA_LAYOUT_FFTBUF(M_)
+#endif
+#if (MBSDA_FREQ_MODULE == MBSDA_FREQ_GOERTZEL)
+   #define MBSDA_LAYOUT_GTZ(M_)    M_(FREQ, gtzBank)
+#else
+   #define MBSDA_LAYOUT_GTZ(M_)
+#endif
+#if (MBSDA_DECIM > 1)
+   #define MBSDA_LAYOUT_DECIM(M_)  M_(STORE, decim)
+#else
+   #define MBSDA_LAYOUT_DECIM(M_)
+#endif
+
+#define MBSDA_LAYOUT(M_) \
+   M_(HOT,   super)           \
+   M_(HOT,   xQ)              \
+   M_(HOT,   yQ)              \
+   M_(HOT,   zQ)              \
+   MBSDA_LAYOUT_FFTQ(M_)      \
+   M_(HOT,   xyzAggregate)    \
+   M_(HOT,   xlSampleCnt)     \
+   M_(HOT,   lastTimestamp)   \
+   M_(HOT,   lastXyzFilt)     \
+   M_(HOT,   stdaXyz)         \
+   MBSDA_LAYOUT_FFTHOP(M_)    \
+   M_(HOT,   freqGated)       \
+   MBSDA_LAYOUT_GTZ(M_)       \
+   M_(FREQ,  lowFreqMag)      \
+   M_(FREQ,  sclDer)          \
+   M_(FREQ,  lfFiltOutput)    \
+   M_(FREQ,  sclDerCurr)      \
+   M_(FREQ,  sclDerPrev)      \
+   M_(FREQ,  freqSampleCnt)   \
+   M_(PEAK,  mTpk)            \
+   M_(PEAK,  mdTpk)           \
+   M_(PEAK,  mTpkFiltOutput)  \
+   M_(PEAK,  mdTpkFiltOutput) \
+   M_(PEAK,  freqNumPk)       \
+   M_(PEAK,  freqPkV)         \
+   M_(PEAK,  freqPkIdxCurr)   \
+   M_(PEAK,  freqPkIdxPrev)   \
+   M_(PEAK,  freqTpkCurr)     \
+   M_(PEAK,  freqTpkPrev)     \
+   M_(PEAK,  freqSpec)        \
+   M_(PEAK,  freqDpk)         \
+   M_(PEAK,  mTpkR)           \
+   M_(PEAK,  freqPkCntr)      \
+   M_(COLD,  startTick)       \
+   M_(COLD,  xlLowHz)         \
+   M_(COLD,  xlRateHz)        \
+   M_(COLD,  zAct)            \
+   M_(COLD,  zStdFreq)        \
+   M_(COLD,  pgmSsValue)      \
+   M_(COLD,  primeCnt)        \
+   M_(COLD,  startCnt)        \
+   M_(COLD,  szFlags)         \
+   MBSDA_LAYOUT_DECIM(M_)     \
+   M_(STORE, xBufSto)         \
+   M_(STORE, yBufSto)         \
+   M_(STORE, zBufSto)         \
+   MBSDA_LAYOUT_FFTBUF(M_)    \
+   M_(STORE, lfBufSto)        \
+   M_(STORE, sclDerBufSto)    \
+   M_(STORE, mTpkBufSto)      \
+   M_(STORE, mdTpkBufSto)
+
+#endif // ALGMBSDA_PRIVATE_H
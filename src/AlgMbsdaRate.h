@@ -0,0 +1,119 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  AlgMbsdaRate.h
+
+@brief  @b Description: @n
+   Sample rate profiles of the MBSDA. Every filter dimension that depends
+   on the sampling rate comes from the profile picked at build time with
+   MBSDA_SAMPLE_HZ (10, 25, 50 or 100, default 50), so buffers are sized
+   for that rate only.
+
+   The 50 Hz profile is the original design. The others keep each filter's
+   time span and were chosen so their magnitude responses stay within
+   1.5 dB of it up to 8 Hz or a quarter of the rate (see the "profiles"
+   suite of host/mbsda_bench.c). At 10 Hz the band of interest is capped at
+   4 Hz, below Nyquist.
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+#ifndef ALGMBSDA_RATE_H
+#define ALGMBSDA_RATE_H
+
+//==============================================================================
+// Profiles, one row per rate:
+//   hz      sampling rate the filters run at
+//   ord     moving average of the activity stage (MBSDA_ORD_SIZE), ~0.8 s
+//   lfw,lfo width and order of the low frequency magnitude boxcar cascade
+//   derw    span of the scaled derivative, 40 ms
+//   alpha   stdaXyz smoothing, 1/2^alpha per sample, ~0.3 s
+//   fftLog2 spectrum window, ~1.3 s
+//   bandHi  top of the band of interest, Hz
+//   gtzBlk  Goertzel block, ~1.3 s
+//==============================================================================
+//                             hz  ord  lfw lfo derw alpha fftLog2 bandHi gtzBlk
+#define MBSDA_RATE_10(P_)  P_( 10,   8,  2,  1,  1,   2,    4,      4,     13)
+#define MBSDA_RATE_25(P_)  P_( 25,  20,  2,  5,  1,   3,    5,      8,     32)
+#define MBSDA_RATE_50(P_)  P_( 50,  39,  4,  4,  2,   4,    6,      8,     64)
+#define MBSDA_RATE_100(P_) P_(100,  78,  8,  4,  4,   5,    7,      8,    128)
+
+#define MBSDA_RATE_PROFILES(P_) \
+   MBSDA_RATE_10(P_) MBSDA_RATE_25(P_) MBSDA_RATE_50(P_) MBSDA_RATE_100(P_)
+
+#ifndef MBSDA_SAMPLE_HZ
+   #define MBSDA_SAMPLE_HZ 50
+#endif
+
+#if   (MBSDA_SAMPLE_HZ == 10)
+   #define MBSDA_RATE MBSDA_RATE_10
+#elif (MBSDA_SAMPLE_HZ == 25)
+   #define MBSDA_RATE MBSDA_RATE_25
+#elif (MBSDA_SAMPLE_HZ == 50)
+   #define MBSDA_RATE MBSDA_RATE_50
+#elif (MBSDA_SAMPLE_HZ == 100)
+   #define MBSDA_RATE MBSDA_RATE_100
+#else
+   #error "MBSDA_SAMPLE_HZ must be 10, 25, 50 or 100"
+#endif
+
+// Column selectors
+#define MBSDA_RATE_ORD(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)     ord
+#define MBSDA_RATE_LFW(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)     lfw
+#define MBSDA_RATE_LFO(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)     lfo
+#define MBSDA_RATE_DERW(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)    derw
+#define MBSDA_RATE_ALPHA(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)   alpha
+#define MBSDA_RATE_FFTLOG2(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk) fftLog2
+#define MBSDA_RATE_BANDHI(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)  bandHi
+#define MBSDA_RATE_GTZBLK(hz, ord, lfw, lfo, derw, alpha, fftLog2, bandHi, gtzBlk)  gtzBlk
+
+//==============================================================================
+// Dimensions of the selected profile
+//==============================================================================
+#define MBSDA_ORD_SIZE      MBSDA_RATE(MBSDA_RATE_ORD)     // Activity average
+#define MBSDA_LFMAG_WDTH_SZ MBSDA_RATE(MBSDA_RATE_LFW)     // Width of integrator kernel
+#define MBSDA_LFMAG_ORDR_SZ MBSDA_RATE(MBSDA_RATE_LFO)     // Order of integrator kernel
+#define MBSDA_DER_WDTH_SZ   MBSDA_RATE(MBSDA_RATE_DERW)    // Width size for derivative calculations
+#define MBSDA_DEF_ALPHA     MBSDA_RATE(MBSDA_RATE_ALPHA)   // stdaXyz smoothing shift
+#define MBSDA_FFT_LOG2      MBSDA_RATE(MBSDA_RATE_FFTLOG2) // Spectrum window
+#define MBSDA_FFT_BAND_HI   MBSDA_RATE(MBSDA_RATE_BANDHI)  // Top of the band, Hz
+#define MBSDA_GTZ_BLOCK     MBSDA_RATE(MBSDA_RATE_GTZBLK)  // Goertzel read out
+
+// Rate of the XL_DATA_SIG events. Faster data goes through an anti-alias
+// polyphase decimator to MBSDA_SAMPLE_HZ in front of the xQ/yQ/zQ queues.
+#ifndef MBSDA_INPUT_HZ
+   #define MBSDA_INPUT_HZ   MBSDA_SAMPLE_HZ
+#endif
+#define MBSDA_DECIM         (MBSDA_INPUT_HZ/MBSDA_SAMPLE_HZ)
+#if (MBSDA_DECIM*MBSDA_SAMPLE_HZ != MBSDA_INPUT_HZ) || \
+    ((MBSDA_DECIM != 1) && (MBSDA_DECIM != 2) && (MBSDA_DECIM != 4))
+   #error "MBSDA_INPUT_HZ must be 1, 2 or 4 times MBSDA_SAMPLE_HZ"
+#endif
+
+// Accelerometer rate asked for while there is little activity (see
+// Mbsda_lowActivity), 0 keeps MBSDA_INPUT_HZ all the time. It has to be a
+// rate the accelerometer supports and below MBSDA_SAMPLE_HZ. At 10 Hz a
+// 5 Hz rhythm can be sampled at its zero crossings and never wake the
+// algorithm up, 25 Hz keeps the whole band of interest below Nyquist.
+#ifndef MBSDA_LOW_HZ
+   #if (MBSDA_SAMPLE_HZ > 25)
+      #define MBSDA_LOW_HZ  25
+   #else
+      #define MBSDA_LOW_HZ   0
+   #endif
+#endif
+#if (MBSDA_LOW_HZ >= MBSDA_SAMPLE_HZ)
+   #error "MBSDA_LOW_HZ must be below MBSDA_SAMPLE_HZ"
+#endif
+
+#endif // ALGMBSDA_RATE_H
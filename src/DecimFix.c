@@ -0,0 +1,163 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  DecimFix.c
+
+@brief  @b Description: @n
+   This file includes an integer polyphase FIR decimator by 2 or 4.
+
+   The anti-alias low-pass h[k] is split into factor branches,
+   e_q[j] = h[j*factor + q], each run only on the inputs of its phase. The
+   branch sums of one block of factor inputs add up to the kept output, so
+   the outputs that are thrown away are never computed and the work is an
+   even DECIM_TAPS_PER_PHASE multiply-accumulates per input sample.
+
+   The Kaiser (beta 6) windowed-sinc designs cut off at a quarter of the
+   output rate. They are flat to 0.01 dB up to 10 Hz at 50 Hz output. They
+   reject by at least 67 dB everything that would fold into 0-10 Hz. DC
+   gain is exactly one, the Q15 taps add up to 32768.
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#include "qep_port.h"
+#include "DecimFix.h"
+
+#define DECIM_Q15_RND 0x4000
+
+// 24 taps, decimation by 2, one row per branch
+static int16_t const Q_ROM l_decim2Coef[2*DECIM_TAPS_PER_PHASE] =
+{
+   -10,     77,   -267,    692,  -1626,   4692,  14676,  -2589,   1061,   -439,    151,    -33,
+   -33,    151,   -439,   1061,  -2589,  14674,   4692,  -1626,    692,   -267,     77,    -10,
+};
+
+// 48 taps, decimation by 4, one row per branch
+static int16_t const Q_ROM l_decim4Coef[4*DECIM_TAPS_PER_PHASE] =
+{
+    -3,     20,    -68,    173,   -400,   1073,   7972,   -802,    325,   -139,     52,    -13,
+   -12,     68,   -210,    517,  -1198,   3737,   6354,  -1505,    637,   -267,     93,    -21,
+   -21,     93,   -267,    637,  -1505,   6354,   3737,  -1198,    517,   -210,     68,    -12,
+   -13,     52,   -139,    325,   -802,   7974,   1073,   -400,    173,    -68,     20,     -3,
+};
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: DecimFix_init
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *filt - decimator to clear  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Clears the input history, the next input starts a block.
+
+*******************************************************************************/
+void DecimFix_init(DecimFix *filt)
+{
+   DecimFix_seed(filt, 0);
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: DecimFix_seed
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *filt - decimator to restart         @n
+@b            data  - value of the assumed history  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Fills the input history with a constant, as if data had been the input
+    forever, so the output starts at data without a transient. The next
+    input starts a block.
+
+*******************************************************************************/
+void DecimFix_seed(DecimFix *filt, int16_t data)
+{
+   uint16_t idx;
+
+   for(idx = 0; idx < DECIM_MAX_TAPS; idx++)
+   {
+      filt->line[idx] = data;
+   }
+   filt->acc   = 0;
+   filt->phase = 0;
+   filt->pos   = 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: DecimFix_push
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *filt  - decimator state                          @n
+@b            factor - decimation factor, 2 or 4                 @n
+@b            data   - new input sample                          @n
+@b   Output:  *out   - decimated sample, when one is ready       @n
+@b   Returns: true every factor inputs, when *out was written    @n
+
+@b Description: @n
+    The input of phase p in its block is the newest sample of branch
+    q = factor-1-p. It enters that branch's ring and the branch adds its
+    part to the output, which is ready once the last phase of the block is
+    in.
+
+*******************************************************************************/
+bool DecimFix_push(DecimFix *filt, uint16_t factor, int16_t data,
+                   int16_t *out)
+{
+   int16_t const *coef;
+   int16_t       *line;
+   int32_t        acc = filt->acc;
+   int16_t        idx = filt->pos;
+   uint16_t       tap;
+
+   coef = (factor == 4) ? l_decim4Coef : l_decim2Coef;
+   coef += (factor - 1 - filt->phase)*DECIM_TAPS_PER_PHASE;
+   line  = filt->line + filt->phase*DECIM_TAPS_PER_PHASE;
+
+   line[idx] = data;
+   for(tap = 0; tap < DECIM_TAPS_PER_PHASE; tap++)
+   {
+      acc += (int32_t)coef[tap]*line[idx];
+      if(--idx < 0)
+      {
+         idx = DECIM_TAPS_PER_PHASE - 1;
+      }
+   }
+
+   if(++filt->phase < factor)
+   {
+      filt->acc = acc;
+      return false;
+   }
+
+   filt->acc   = 0;
+   filt->phase = 0;
+   if(++filt->pos >= DECIM_TAPS_PER_PHASE)
+   {
+      filt->pos = 0;
+   }
+
+   acc = (acc + DECIM_Q15_RND) >> 15;
+   *out = (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+
+   return true;
+}
@@ -0,0 +1,51 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  DecimFix.h
+
+@brief  @b Description: @n
+   This file includes the prototypes for the fix point polyphase decimator
+   used to bring 100 Hz and 200 Hz accelerometer data down to the 50 Hz the
+   MBSDA filters are designed for
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#ifndef _DECIMFIX_H_
+#define _DECIMFIX_H_
+
+#include "qep_port.h"
+
+#define DECIM_TAPS_PER_PHASE 12 // Taps of each polyphase branch
+#define DECIM_MAX_FACTOR      4
+#define DECIM_MAX_TAPS       (DECIM_TAPS_PER_PHASE*DECIM_MAX_FACTOR)
+
+// ===================================================================
+/// struct @b DecimFix - state of one decimated channel
+// ===================================================================
+typedef struct DecimFixTag
+{
+   int16_t line[DECIM_MAX_TAPS]; // Input history, one ring per phase
+   int32_t acc;                  // Output being accumulated
+   uint8_t phase;                // Phase of the next input
+   uint8_t pos;                  // Ring position of the current block
+
+} DecimFix;
+
+void DecimFix_init(DecimFix *filt);
+void DecimFix_seed(DecimFix *filt, int16_t data);
+bool DecimFix_push(DecimFix *filt, uint16_t factor, int16_t data,
+                   int16_t *out);
+
+#endif /* _DECIMFIX_H_ */
@@ -0,0 +1,225 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  FftFix.c
+
+@brief  @b Description: @n
+   This file includes a fix point, in-place radix-2 FFT for 16-bit data and
+   the spectral features used by the MBSDA frequency module.
+
+   Every butterfly stage scales its output by 1/2 so nothing can overflow,
+   the transform of N points therefore returns DFT/N. Twiddle factors are
+   Q15 and all rounding is done in integer arithmetic, so the results are
+   bit identical on the watch and on the host.
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#include "qep_port.h"
+#include "FftFix.h"
+
+#define FFT_Q15_RND   0x4000             // Rounding for a Q15 product
+#define FFT_PWR_SHIFT (FFT_MAX_LOG2 - 1) // Keeps the sum of N/2 bins in 32 bits
+
+// One period of sin(2*pi*k/FFT_MAX_SIZE) in Q15, cosine is read a quarter
+// period ahead
+static int16_t const Q_ROM l_sinQ15[FFT_MAX_SIZE] =
+{
+        0,   1608,   3212,   4808,   6393,   7962,   9512,  11039,
+    12539,  14010,  15446,  16846,  18204,  19519,  20787,  22005,
+    23170,  24279,  25329,  26319,  27245,  28105,  28898,  29621,
+    30273,  30852,  31356,  31785,  32137,  32412,  32609,  32728,
+    32767,  32728,  32609,  32412,  32137,  31785,  31356,  30852,
+    30273,  29621,  28898,  28105,  27245,  26319,  25329,  24279,
+    23170,  22005,  20787,  19519,  18204,  16846,  15446,  14010,
+    12539,  11039,   9512,   7962,   6393,   4808,   3212,   1608,
+        0,  -1608,  -3212,  -4808,  -6393,  -7962,  -9512, -11039,
+   -12539, -14010, -15446, -16846, -18204, -19519, -20787, -22005,
+   -23170, -24279, -25329, -26319, -27245, -28105, -28898, -29621,
+   -30273, -30852, -31356, -31785, -32137, -32412, -32609, -32728,
+   -32767, -32728, -32609, -32412, -32137, -31785, -31356, -30852,
+   -30273, -29621, -28898, -28105, -27245, -26319, -25329, -24279,
+   -23170, -22005, -20787, -19519, -18204, -16846, -15446, -14010,
+   -12539, -11039,  -9512,  -7962,  -6393,  -4808,  -3212,  -1608,
+};
+
+#define FFT_SIN(k_)  l_sinQ15[(k_) & (FFT_MAX_SIZE - 1)]
+#define FFT_COS(k_)  l_sinQ15[((k_) + FFT_MAX_SIZE/4) & (FFT_MAX_SIZE - 1)]
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: FftFix_window
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *re - samples to window, in place   @n
+@b            log2Size - log2 of the number of samples, up to FFT_MAX_LOG2  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Applies a Hann window, so the energy of a rhythm that does not fit the
+    window exactly stays in the bins next to it instead of leaking over the
+    whole spectrum.
+
+*******************************************************************************/
+void FftFix_window(int16_t *re, uint16_t log2Size)
+{
+   uint16_t n;
+   uint16_t size   = 1 << log2Size;
+   uint16_t stride = FFT_MAX_SIZE >> log2Size;
+   int32_t  w;
+
+   for(n = 0; n < size; n++)
+   {
+      // w = (1 - cos(2*pi*n/N)) / 2 in Q15
+      w = (32767 - FFT_COS(n*stride)) >> 1;
+      re[n] = (int16_t)(((int32_t)re[n]*w + FFT_Q15_RND) >> 15);
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: FftFix_transform
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *re - real part, in place            @n
+@b            *im - imaginary part, in place       @n
+@b            log2Size - log2 of the number of points, up to FFT_MAX_LOG2  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Decimation in time radix-2 FFT. The input is reordered by bit reversal,
+    then each stage combines pairs of half-size transforms. The output is
+    the DFT scaled by 1/N. Inputs of magnitude up to 32767 cannot overflow,
+    which any real 16-bit input other than -32768 satisfies.
+
+*******************************************************************************/
+void FftFix_transform(int16_t *re, int16_t *im, uint16_t log2Size)
+{
+   uint16_t size = 1 << log2Size;
+   uint16_t i, j, k, bit;
+   uint16_t half, stride;
+   int16_t  tmp;
+   int32_t  wr, wi, tr, ti, ur, ui;
+
+   // Bit reversal permutation
+   //
+   for(i = 1, j = 0; i < size; i++)
+   {
+      for(bit = size >> 1; j & bit; bit >>= 1)
+      {
+         j ^= bit;
+      }
+      j |= bit;
+
+      if(i < j)
+      {
+         tmp = re[i]; re[i] = re[j]; re[j] = tmp;
+         tmp = im[i]; im[i] = im[j]; im[j] = tmp;
+      }
+   }
+
+   // Butterflies, halving every stage
+   //
+   for(half = 1, stride = FFT_MAX_SIZE >> 1; half < size; half <<= 1, stride >>= 1)
+   {
+      for(k = 0; k < half; k++)
+      {
+         wr =  FFT_COS(k*stride);
+         wi = -FFT_SIN(k*stride);
+
+         for(i = k; i < size; i += half << 1)
+         {
+            j = i + half;
+
+            tr = (wr*re[j] - wi*im[j] + FFT_Q15_RND) >> 15;
+            ti = (wr*im[j] + wi*re[j] + FFT_Q15_RND) >> 15;
+            ur = re[i];
+            ui = im[i];
+
+            re[i] = (int16_t)((ur + tr) >> 1);
+            im[i] = (int16_t)((ui + ti) >> 1);
+            re[j] = (int16_t)((ur - tr) >> 1);
+            im[j] = (int16_t)((ui - ti) >> 1);
+         }
+      }
+   }
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: FftFix_features
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *re, *im - output of FftFix_transform                 @n
+@b            log2Size - log2 of the number of points                @n
+@b            sampleHz - sampling rate of the transformed data       @n
+@b            bandLoHz, bandHiHz - band of interest, inclusive, Hz   @n
+@b   Output:  *feat - spectral features                              @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Computes the power of the bins from 1 to N/2 and from them the dominant
+    frequency, the power inside the band and its share of the total. DC is
+    left out, the caller is expected to remove the mean anyway.
+
+*******************************************************************************/
+void FftFix_features(int16_t const *re, int16_t const *im, uint16_t log2Size,
+                     uint16_t sampleHz, uint16_t bandLoHz, uint16_t bandHiHz,
+                     FftFeatures *feat)
+{
+   uint16_t k;
+   uint16_t kMax = 0;
+   uint16_t kLo  = ((bandLoHz << log2Size) + sampleHz - 1) / sampleHz;
+   uint16_t kHi  = (bandHiHz << log2Size) / sampleHz;
+   uint32_t pwr;
+   uint32_t pwrMax = 0;
+
+   feat->bandPwr  = 0;
+   feat->totalPwr = 0;
+
+   for(k = 1; k <= (1 << (log2Size - 1)); k++)
+   {
+      pwr = (uint32_t)((int32_t)re[k]*re[k]) + (uint32_t)((int32_t)im[k]*im[k]);
+
+      if(pwr > pwrMax)
+      {
+         pwrMax = pwr;
+         kMax   = k;
+      }
+
+      pwr >>= FFT_PWR_SHIFT;
+      feat->totalPwr += pwr;
+      if((k >= kLo) && (k <= kHi))
+      {
+         feat->bandPwr += pwr;
+      }
+   }
+
+   feat->domFreq = (uint16_t)(((uint32_t)kMax*sampleHz << 8) >> log2Size);
+
+   if(feat->totalPwr != 0)
+   {
+      feat->bandRatio = (uint16_t)(((uint64_t)feat->bandPwr << 14) /
+                                   feat->totalPwr);
+   }
+   else
+   {
+      feat->bandRatio = 0;
+   }
+}
@@ -0,0 +1,50 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  FftFix.h
+
+@brief  @b Description: @n
+   This file includes the prototypes for the fix point radix-2 FFT and the
+   spectral features computed from its output
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#ifndef _FFTFIX_H_
+#define _FFTFIX_H_
+
+#include "qep_port.h"
+
+#define FFT_MAX_LOG2  7                  // Largest transform, 128 points
+#define FFT_MAX_SIZE  (1 << FFT_MAX_LOG2)
+
+// ===================================================================
+/// struct @b FftFeatures - spectral features of one transformed window
+// ===================================================================
+typedef struct FftFeaturesTag
+{
+   uint16_t domFreq;   // Frequency of the strongest bin, Hz in Q8
+   uint16_t bandRatio; // Band power over total power, Q14
+   uint32_t bandPwr;   // Power of the bins inside the band
+   uint32_t totalPwr;  // Power of all bins but DC
+
+} FftFeatures;
+
+void FftFix_window(int16_t *re, uint16_t log2Size);
+void FftFix_transform(int16_t *re, int16_t *im, uint16_t log2Size);
+void FftFix_features(int16_t const *re, int16_t const *im, uint16_t log2Size,
+                     uint16_t sampleHz, uint16_t bandLoHz, uint16_t bandHiHz,
+                     FftFeatures *feat);
+
+#endif /* _FFTFIX_H_ */
@@ -0,0 +1,163 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  GoertzelFix.c
+
+@brief  @b Description: @n
+   This file includes a bank of fix point Goertzel detectors. Each detector
+   is a second order resonator tuned to one frequency, updated with one
+   multiply-accumulate per input sample, whose power is read out once per
+   block. For a handful of frequencies this is cheaper than an FFT of the
+   block and needs no sample buffer.
+
+   The coefficient of a detector is 2*cos(2*pi*f/fs) in Q14. Detector state
+   is 32-bit, enough for blocks of a few hundred 16-bit samples.
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#include "qep_port.h"
+#include "GoertzelFix.h"
+
+#define GOERTZEL_COEF_SHIFT 14
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Goertzel_init
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *bank - detector bank to clear  @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Clears the detectors and starts a new block.
+
+*******************************************************************************/
+void Goertzel_init(GoertzelBank *bank)
+{
+   uint16_t bin;
+
+   for(bin = 0; bin < GOERTZEL_MAX_BINS; bin++)
+   {
+      bank->s1[bin] = 0;
+      bank->s2[bin] = 0;
+   }
+   bank->energy = 0;
+   bank->count  = 0;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Goertzel_update
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *bank   - detector bank                          @n
+@b            *coef   - detector coefficients, Q14             @n
+@b            numBins - detectors in use, up to GOERTZEL_MAX_BINS  @n
+@b            data    - new input sample, mean removed         @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Feeds one sample to every detector, s = x + coef*s1 - s2, and to the
+    block energy used to normalise the band power.
+
+*******************************************************************************/
+void Goertzel_update(GoertzelBank *bank, int16_t const *coef, uint16_t numBins,
+                     int16_t data)
+{
+   uint16_t bin;
+   int32_t  s0;
+
+   for(bin = 0; bin < numBins; bin++)
+   {
+      s0 = data + (int32_t)(((int64_t)coef[bin]*bank->s1[bin]) >>
+                            GOERTZEL_COEF_SHIFT) - bank->s2[bin];
+      bank->s2[bin] = bank->s1[bin];
+      bank->s1[bin] = s0;
+   }
+   bank->energy += (uint32_t)((int32_t)data*data);
+   bank->count++;
+}
+
+/**
+********************************************************************************
+@internal
+   Fuction Name: Goertzel_read
+@endinternal
+
+@b Parameter: @n
+@b   Input:   *bank    - detector bank, cleared for the next block      @n
+@b            *coef    - detector coefficients, Q14                     @n
+@b            *binFreq - detector frequencies, Hz in Q8                 @n
+@b            numBins  - detectors in use                               @n
+@b   Output:  *feat    - band features of the block                     @n
+@b   Returns: none  @n
+
+@b Description: @n
+    Reads out the power of every detector, |X(f)|^2 = s1^2 + s2^2 -
+    coef*s1*s2, the frequency of the strongest and the band power relative
+    to the block energy. By Parseval a real block of N samples holds N/2
+    times its energy over the bins 1 to N/2, so with one detector per bin
+    width the ratio matches the share the FFT would report. Powers are
+    divided by N^2 as the FFT scales its output by 1/N.
+
+*******************************************************************************/
+void Goertzel_read(GoertzelBank *bank, int16_t const *coef,
+                   uint16_t const *binFreq, uint16_t numBins,
+                   FftFeatures *feat)
+{
+   uint16_t bin;
+   int64_t  s1, s2;
+   uint64_t pwr;
+   uint64_t pwrMax = 0;
+   uint64_t pwrSum = 0;
+   uint64_t total;
+   uint64_t ratio;
+   uint32_t nSq = (uint32_t)bank->count*bank->count;
+
+   feat->domFreq = 0;
+   for(bin = 0; bin < numBins; bin++)
+   {
+      s1  = bank->s1[bin];
+      s2  = bank->s2[bin];
+      pwr = (uint64_t)(s1*s1 + s2*s2 -
+                       ((coef[bin]*s1*s2) >> GOERTZEL_COEF_SHIFT));
+      if(pwr > pwrMax)
+      {
+         pwrMax        = pwr;
+         feat->domFreq = binFreq[bin];
+      }
+      pwrSum += pwr;
+   }
+
+   total = bank->energy*bank->count/2;
+   if((total != 0) && (nSq != 0))
+   {
+      ratio = (pwrSum << 14) / total;
+      feat->bandRatio = (uint16_t)(ratio > (1 << 14) ? (1 << 14) : ratio);
+      feat->bandPwr   = (uint32_t)(pwrSum / nSq);
+      feat->totalPwr  = (uint32_t)(total / nSq);
+   }
+   else
+   {
+      feat->bandRatio = 0;
+      feat->bandPwr   = 0;
+      feat->totalPwr  = 0;
+   }
+
+   Goertzel_init(bank);
+}
@@ -0,0 +1,52 @@
+/**
+********************************************************************************
+@internal
+Copyright(c) 2014 Cyberonics Inc.  All Rights Reserved.
+
+This software is proprietary and confidential.  By using this software
+You agree with the terms of the associated Cyberonics Inc. License Agreement
+This file is documented using Doxygen annotations for extraction of detail
+design description items.
+@endinternal
+
+@file  GoertzelFix.h
+
+@brief  @b Description: @n
+   This file includes the prototypes for the fix point Goertzel detector
+   bank, a per sample alternative to the FFT when only a few frequencies
+   are of interest
+
+@internal
+* Change Log: Major releases will be captured here, minor releases will use
+*             SVN check-in/history log for details.
+@endinternal
+*******************************************************************************/
+
+#ifndef _GOERTZELFIX_H_
+#define _GOERTZELFIX_H_
+
+#include "qep_port.h"
+#include "FftFix.h"
+
+#define GOERTZEL_MAX_BINS 8
+
+// ===================================================================
+/// struct @b GoertzelBank - running state of a bank of detectors
+// ===================================================================
+typedef struct GoertzelBankTag
+{
+   int32_t  s1[GOERTZEL_MAX_BINS]; // Last detector output of each bin
+   int32_t  s2[GOERTZEL_MAX_BINS]; // Detector output before that
+   uint64_t energy;                // Sum of the squared inputs of the block
+   uint16_t count;                 // Inputs in the current block
+
+} GoertzelBank;
+
+void Goertzel_init(GoertzelBank *bank);
+void Goertzel_update(GoertzelBank *bank, int16_t const *coef, uint16_t numBins,
+                     int16_t data);
+void Goertzel_read(GoertzelBank *bank, int16_t const *coef,
+                   uint16_t const *binFreq, uint16_t numBins,
+                   FftFeatures *feat);
+
+#endif /* _GOERTZELFIX_H_ */
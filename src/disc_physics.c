@@ -0,0 +1,298 @@
+#include "disc_physics.h"
+
+static int32_t disc_calc_inv_mass(fixed_t radius) {
+  // mass = pi * r^2 * density, computed once per disc at init
+  fixed_t mass = FX_MUL(FX_MUL(FX_MUL(FX_PI, radius), radius), FX_DISC_DENSITY);
+  return (int32_t)(((int64_t)1 << (FX_INV_SHIFT + FX_SHIFT)) / mass);
+}
+
+void disc_init(DiscSet *set, int i, fixed_t radius, int16_t x, int16_t y) {
+  set->pos_x[i] = FX_FROM_INT(x);
+  set->pos_y[i] = FX_FROM_INT(y);
+  set->vel_x[i] = 0;
+  set->vel_y[i] = 0;
+  set->radius[i] = radius;
+  set->inv_mass[i] = disc_calc_inv_mass(radius);
+  if (i == 0 || radius > set->max_radius) {
+    set->max_radius = radius;
+  }
+}
+
+// Rounds the force of a step to at most FORCE_BITS bits of magnitude and
+// returns by how much it was shifted. The magnitude is rounded, so a tilt
+// and its opposite give opposite forces.
+#define FORCE_BITS 14
+
+static int force_reduce(int32_t *force) {
+  const int32_t mag = *force < 0 ? -*force : *force;
+  int shift = 0;
+  while ((mag >> shift) >= (1 << FORCE_BITS)) {
+    shift++;
+  }
+  if (shift) {
+    const int32_t reduced = (mag + (1 << (shift - 1))) >> shift;
+    *force = *force < 0 ? -reduced : reduced;
+  }
+  return shift;
+}
+
+static void discs_apply_axis(fixed_t *restrict vel, const int32_t *restrict inv_mass,
+    int32_t force) {
+  // The impulse is the same for every disc, only 1/mass differs. Reduced to
+  // FORCE_BITS, its product with a 1/mass below 2^16 fits 32 bits, so the
+  // loop is plain 32 bit multiplies and shifts. The velocity change is
+  // rounded to nearest: truncating always loses towards -inf, and summed
+  // over a few thousand steps that pushes resting discs into a wall.
+  const int shift = FX_INV_SHIFT - force_reduce(&force);
+  const int32_t round = (int32_t)1 << (shift - 1);
+  for (int i = 0; i < NUM_DISCS; i++) {
+    vel[i] += (force * inv_mass[i] + round) >> shift;
+  }
+}
+
+void discs_apply_accel(DiscSet *set, int16_t accel_x, int16_t accel_y, fixed_t dt) {
+  // The force fits 24 bits over the +-4g range, FX_INV_SHIFT leaves room for
+  // a shift of up to 10 before the product loses its rounding bit
+  discs_apply_axis(set->vel_x, set->inv_mass, FX_MUL(accel_x * FX_ACCEL_RATIO, dt));
+  discs_apply_axis(set->vel_y, set->inv_mass, FX_MUL(-accel_y * FX_ACCEL_RATIO, dt));
+}
+
+static void discs_update_axis(fixed_t *restrict pos, fixed_t *restrict vel,
+    const fixed_t *restrict radius, fixed_t limit, fixed_t dt) {
+  // Bounce as a select rather than a branch, restitution e = 0.5 halves the
+  // reflected velocity. Discs pushed past a wall by a collision are put
+  // back against it.
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const fixed_t lo = radius[i];
+    const fixed_t hi = limit - radius[i];
+    const fixed_t p = pos[i];
+    const fixed_t v = vel[i];
+    const int hit = ((p < lo) & (v < 0)) | ((p > hi) & (v > 0));
+    const fixed_t nv = hit ? -v / 2 : v;
+    const fixed_t np = p < lo ? lo : (p > hi ? hi : p);
+    vel[i] = nv;
+    pos[i] = np + FX_MUL(nv, dt);
+  }
+}
+
+void discs_update(DiscSet *set, int16_t w, int16_t h, fixed_t dt) {
+  discs_update_axis(set->pos_x, set->vel_x, set->radius, FX_FROM_INT(w), dt);
+  discs_update_axis(set->pos_y, set->vel_y, set->radius, FX_FROM_INT(h), dt);
+}
+
+fixed_t discs_max_speed(const DiscSet *set) {
+  // Largest velocity component, enough to tell moving from resting
+  fixed_t max = 0;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const fixed_t vx = set->vel_x[i] < 0 ? -set->vel_x[i] : set->vel_x[i];
+    const fixed_t vy = set->vel_y[i] < 0 ? -set->vel_y[i] : set->vel_y[i];
+    max = vx > max ? vx : max;
+    max = vy > max ? vy : max;
+  }
+  return max;
+}
+
+void discs_damp(DiscSet *set, int shift) {
+  for (int i = 0; i < NUM_DISCS; i++) {
+    set->vel_x[i] = shift ? set->vel_x[i] - set->vel_x[i] / (1 << shift) : 0;
+    set->vel_y[i] = shift ? set->vel_y[i] - set->vel_y[i] / (1 << shift) : 0;
+  }
+}
+
+// Uniform grid over the window, rebuilt every step by a counting sort of
+// the discs into their cells
+static disc_index_t s_cell_start[DISC_GRID_MAX_CELLS + 1];
+static disc_index_t s_cell_discs[NUM_DISCS];
+static uint16_t s_disc_cell[NUM_DISCS];
+
+static int s_cell_size;
+static int s_cols;
+static int s_rows;
+
+static uint32_t isqrt(uint32_t n) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > n) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+static int clamp(int v, int lo, int hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void grid_build(DiscSet *set, int16_t w, int16_t h) {
+  // A cell at least one diameter wide means touching discs are at most one
+  // cell apart
+  s_cell_size = FX_TO_INT(2 * set->max_radius) + 1;
+  for (;;) {
+    s_cols = w / s_cell_size + 1;
+    s_rows = h / s_cell_size + 1;
+    if (s_cols * s_rows <= DISC_GRID_MAX_CELLS) {
+      break;
+    }
+    s_cell_size *= 2;
+  }
+  const int num_cells = s_cols * s_rows;
+
+  for (int c = 0; c < num_cells; c++) {
+    s_cell_start[c] = 0;
+  }
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const int cx = clamp(FX_TO_INT(set->pos_x[i]) / s_cell_size, 0, s_cols - 1);
+    const int cy = clamp(FX_TO_INT(set->pos_y[i]) / s_cell_size, 0, s_rows - 1);
+    s_disc_cell[i] = cy * s_cols + cx;
+    s_cell_start[s_disc_cell[i]]++;
+  }
+  for (int c = 1; c < num_cells; c++) {
+    s_cell_start[c] += s_cell_start[c - 1];
+  }
+  s_cell_start[num_cells] = NUM_DISCS;
+  // Filling back to front leaves cell_start at the first disc of each cell
+  for (int i = NUM_DISCS - 1; i >= 0; i--) {
+    s_cell_discs[--s_cell_start[s_disc_cell[i]]] = i;
+  }
+}
+
+static void disc_pair_collide(DiscSet *set, int i, int j) {
+  const fixed_t dx = set->pos_x[j] - set->pos_x[i];
+  const fixed_t dy = set->pos_y[j] - set->pos_y[i];
+  const fixed_t rsum = set->radius[i] + set->radius[j];
+
+  // Distance in 1/256 pixel so the squares fit 32 bits
+  const int32_t dx8 = dx >> 8;
+  const int32_t dy8 = dy >> 8;
+  const int32_t rsum8 = rsum >> 8;
+  const uint32_t dist2 = (uint32_t)(dx8 * dx8) + (uint32_t)(dy8 * dy8);
+  if (dist2 >= (uint32_t)(rsum8 * rsum8)) {
+    return;
+  }
+  int32_t dist8 = isqrt(dist2);
+
+  // Unit normal from i to j, any direction will do for coincident centres
+  fixed_t nx = FX_ONE;
+  fixed_t ny = 0;
+  if (dist8 != 0) {
+    nx = (dx8 << 16) / dist8;
+    ny = (dy8 << 16) / dist8;
+  }
+
+  // Share of the response taken by each disc, by 1/mass
+  const int32_t inv_i = set->inv_mass[i] >> (FX_INV_SHIFT - FX_SHIFT);
+  const int32_t inv_j = set->inv_mass[j] >> (FX_INV_SHIFT - FX_SHIFT);
+  const fixed_t share_i = (inv_i << FX_SHIFT) / (inv_i + inv_j);
+  const fixed_t share_j = FX_ONE - share_i;
+
+  // Push the discs apart so they do not sink into each other
+  const fixed_t overlap = rsum - (dist8 << 8);
+  set->pos_x[i] -= FX_MUL(FX_MUL(overlap, share_i), nx);
+  set->pos_y[i] -= FX_MUL(FX_MUL(overlap, share_i), ny);
+  set->pos_x[j] += FX_MUL(FX_MUL(overlap, share_j), nx);
+  set->pos_y[j] += FX_MUL(FX_MUL(overlap, share_j), ny);
+
+  // Impulse along the normal when approaching, restitution e = 0.5
+  const fixed_t vn = FX_MUL(set->vel_x[j] - set->vel_x[i], nx)
+      + FX_MUL(set->vel_y[j] - set->vel_y[i], ny);
+  if (vn >= 0) {
+    return;
+  }
+  const fixed_t impulse = vn + vn / 2;
+  set->vel_x[i] += FX_MUL(FX_MUL(impulse, share_i), nx);
+  set->vel_y[i] += FX_MUL(FX_MUL(impulse, share_i), ny);
+  set->vel_x[j] -= FX_MUL(FX_MUL(impulse, share_j), nx);
+  set->vel_y[j] -= FX_MUL(FX_MUL(impulse, share_j), ny);
+}
+
+uint32_t discs_collide(DiscSet *set, int16_t w, int16_t h) {
+  // Each cell is tested against itself and the four neighbours after it, so
+  // every pair is seen once. Returns the number of pairs tested.
+  static const int8_t s_next_cells[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+  uint32_t pair_tests = 0;
+
+  grid_build(set, w, h);
+
+  for (int cy = 0; cy < s_rows; cy++) {
+    for (int cx = 0; cx < s_cols; cx++) {
+      const int cell = cy * s_cols + cx;
+      const int end = s_cell_start[cell + 1];
+      for (int a = s_cell_start[cell]; a < end; a++) {
+        const int i = s_cell_discs[a];
+        for (int b = a + 1; b < end; b++) {
+          disc_pair_collide(set, i, s_cell_discs[b]);
+          pair_tests++;
+        }
+        for (int n = 0; n < 4; n++) {
+          const int nx = cx + s_next_cells[n][0];
+          const int ny = cy + s_next_cells[n][1];
+          if (nx < 0 || nx >= s_cols || ny >= s_rows) {
+            continue;
+          }
+          const int other = ny * s_cols + nx;
+          for (int b = s_cell_start[other]; b < s_cell_start[other + 1]; b++) {
+            disc_pair_collide(set, i, s_cell_discs[b]);
+            pair_tests++;
+          }
+        }
+      }
+    }
+  }
+  return pair_tests;
+}
+
+#ifdef DISC_PHYSICS_REFERENCE
+
+#define MATH_PI 3.141592653589793238462
+#define DISC_DENSITY 0.25
+#define ACCEL_RATIO 0.05
+
+static double ref_disc_calc_mass(RefDisc *disc) {
+  return MATH_PI * disc->radius * disc->radius * DISC_DENSITY;
+}
+
+void ref_disc_init(RefDisc *disc, double radius, int16_t w, int16_t h) {
+  disc->pos.x = w/2;
+  disc->pos.y = h/2;
+  disc->vel.x = 0;
+  disc->vel.y = 0;
+  disc->radius = radius;
+  disc->mass = ref_disc_calc_mass(disc);
+}
+
+void ref_disc_apply_accel(RefDisc *disc, int16_t accel_x, int16_t accel_y) {
+  disc->vel.x += accel_x * ACCEL_RATIO / disc->mass;
+  disc->vel.y += -accel_y * ACCEL_RATIO / disc->mass;
+}
+
+static double ref_clamp(double p, double lo, double hi) {
+  return p < lo ? lo : (p > hi ? hi : p);
+}
+
+void ref_disc_update(RefDisc *disc, int16_t w, int16_t h) {
+  double e = 0.5;
+  if ((disc->pos.x - disc->radius < 0 && disc->vel.x < 0)
+    || (disc->pos.x + disc->radius > w && disc->vel.x > 0)) {
+    disc->vel.x = -disc->vel.x * e;
+  }
+  if ((disc->pos.y - disc->radius < 0 && disc->vel.y < 0)
+    || (disc->pos.y + disc->radius > h && disc->vel.y > 0)) {
+    disc->vel.y = -disc->vel.y * e;
+  }
+  // Put back against the wall before moving, as discs_update does, so the
+  // two models can be compared through wall contacts
+  disc->pos.x = ref_clamp(disc->pos.x, disc->radius, w - disc->radius);
+  disc->pos.y = ref_clamp(disc->pos.y, disc->radius, h - disc->radius);
+  disc->pos.x += disc->vel.x;
+  disc->pos.y += disc->vel.y;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+// Q16.16 fixed point, the watch has no FPU
+typedef int32_t fixed_t;
+
+#define FX_SHIFT 16
+#define FX_ONE ((fixed_t)1 << FX_SHIFT)
+#define FX_HALF (FX_ONE / 2)
+#define FX_FROM_INT(i) ((fixed_t)(i) * FX_ONE)
+#define FX_TO_INT(f) ((int32_t)((f) >> FX_SHIFT))
+#define FX_MUL(a, b) ((fixed_t)(((int64_t)(a) * (b)) >> FX_SHIFT))
+
+// 1/mass is kept in Q13.18, below 1/7 for the smallest disc of 3 pixels. Its
+// product with the force of a step must fit 32 bits, which holds for 1/mass
+// below 1/4, radii from 2.3 pixels up
+#define FX_INV_SHIFT 18
+
+// Constants in Q16.16
+#define FX_PI 205887          // 3.14159
+#define FX_DISC_DENSITY 16384 // 0.25
+#define FX_ACCEL_RATIO 3277   // 0.05
+
+#ifndef NUM_DISCS
+#define NUM_DISCS 20
+#endif
+
+// Cells of the collision grid, the cell size is raised when the window
+// would need more
+#ifndef DISC_GRID_MAX_CELLS
+#define DISC_GRID_MAX_CELLS 256
+#endif
+
+// Disc index in the collision grid, 16 bits unless there are more discs
+#if NUM_DISCS > 0xFFFF
+typedef uint32_t disc_index_t;
+#else
+typedef uint16_t disc_index_t;
+#endif
+
+// Disc state as separate arrays so each step is a plain loop per field
+typedef struct DiscSet {
+  fixed_t pos_x[NUM_DISCS];
+  fixed_t pos_y[NUM_DISCS];
+  fixed_t vel_x[NUM_DISCS];
+  fixed_t vel_y[NUM_DISCS];
+  int32_t inv_mass[NUM_DISCS]; // Q13.18
+  fixed_t radius[NUM_DISCS];
+  fixed_t max_radius;
+} DiscSet;
+
+// The collision test works in 1/256 pixel, two touching radii must stay
+// below 128 pixels
+void disc_init(DiscSet *set, int i, fixed_t radius, int16_t x, int16_t y);
+// dt is the length of the step in Q16.16, FX_ONE being the step the disc
+// velocities are expressed in
+void discs_apply_accel(DiscSet *set, int16_t accel_x, int16_t accel_y, fixed_t dt);
+void discs_update(DiscSet *set, int16_t w, int16_t h, fixed_t dt);
+uint32_t discs_collide(DiscSet *set, int16_t w, int16_t h);
+fixed_t discs_max_speed(const DiscSet *set);
+// Takes 1/2^shift off every velocity, 0 stops the discs dead
+void discs_damp(DiscSet *set, int shift);
+
+#ifdef DISC_PHYSICS_REFERENCE
+// Original floating point model, kept to check the fixed point one against
+
+typedef struct Vec2d {
+  double x;
+  double y;
+} Vec2d;
+
+typedef struct RefDisc {
+  Vec2d pos;
+  Vec2d vel;
+  double mass;
+  double radius;
+} RefDisc;
+
+void ref_disc_init(RefDisc *disc, double radius, int16_t w, int16_t h);
+void ref_disc_apply_accel(RefDisc *disc, int16_t accel_x, int16_t accel_y);
+void ref_disc_update(RefDisc *disc, int16_t w, int16_t h);
+#endif
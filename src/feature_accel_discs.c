@@ -1,143 +1,572 @@
-#include "pebble.h"
-
-#define MATH_PI 3.141592653589793238462
-#define NUM_DISCS 20
-#define DISC_DENSITY 0.25
-#define ACCEL_RATIO 0.05
-#define ACCEL_STEP_MS 50
-
-typedef struct Vec2d {
-  double x;
-  double y;
-} Vec2d;
-
-typedef struct Disc {
-  Vec2d pos;
-  Vec2d vel;
-  double mass;
-  double radius;
-} Disc;
-
-static Disc discs[NUM_DISCS];
-
-static double next_radius = 3;
-
-static Window *window;
-
-static GRect window_frame;
-
-static Layer *disc_layer;
-
-static AppTimer *timer;
-
-static double disc_calc_mass(Disc *disc) {
-  return MATH_PI * disc->radius * disc->radius * DISC_DENSITY;
-}
-
-static void disc_init(Disc *disc) {
-  GRect frame = window_frame;
-  disc->pos.x = frame.size.w/2;
-  disc->pos.y = frame.size.h/2;
-  disc->vel.x = 0;
-  disc->vel.y = 0;
-  disc->radius = next_radius;
-  disc->mass = disc_calc_mass(disc);
-  next_radius += 0.5;
-}
-
-static void disc_apply_force(Disc *disc, Vec2d force) {
-  disc->vel.x += force.x / disc->mass;
-  disc->vel.y += force.y / disc->mass;
-}
-
-static void disc_apply_accel(Disc *disc, AccelData accel) {
-  Vec2d force;
-  force.x = accel.x * ACCEL_RATIO;
-  force.y = -accel.y * ACCEL_RATIO;
-  disc_apply_force(disc, force);
-}
-
-static void disc_update(Disc *disc) {
-  const GRect frame = window_frame;
-  double e = 0.5;
-  if ((disc->pos.x - disc->radius < 0 && disc->vel.x < 0)
-    || (disc->pos.x + disc->radius > frame.size.w && disc->vel.x > 0)) {
-    disc->vel.x = -disc->vel.x * e;
-  }
-  if ((disc->pos.y - disc->radius < 0 && disc->vel.y < 0)
-    || (disc->pos.y + disc->radius > frame.size.h && disc->vel.y > 0)) {
-    disc->vel.y = -disc->vel.y * e;
-  }
-  disc->pos.x += disc->vel.x;
-  disc->pos.y += disc->vel.y;
-}
-
-static void disc_draw(GContext *ctx, Disc *disc) {
-  graphics_context_set_fill_color(ctx, GColorWhite);
-  graphics_fill_circle(ctx, GPoint(disc->pos.x, disc->pos.y), disc->radius);
-}
-
-static void disc_layer_update_callback(Layer *me, GContext *ctx) {
-  for (int i = 0; i < NUM_DISCS; i++) {
-    disc_draw(ctx, &discs[i]);
-  }
-}
-
-static void timer_callback(void *data) {
-  AccelData accel = (AccelData) { .x = 0, .y = 0, .z = 0 };
-
-  accel_service_peek(&accel);
-
-  for (int i = 0; i < NUM_DISCS; i++) {
-    Disc *disc = &discs[i];
-    disc_apply_accel(disc, accel);
-    disc_update(disc);
-  }
-
-  layer_mark_dirty(disc_layer);
-
-  timer = app_timer_register(ACCEL_STEP_MS, timer_callback, NULL);
-}
-
-static void window_load(Window *window) {
-  Layer *window_layer = window_get_root_layer(window);
-  GRect frame = window_frame = layer_get_frame(window_layer);
-
-  disc_layer = layer_create(frame);
-  layer_set_update_proc(disc_layer, disc_layer_update_callback);
-  layer_add_child(window_layer, disc_layer);
-
-  for (int i = 0; i < NUM_DISCS; i++) {
-    disc_init(&discs[i]);
-  }
-}
-
-static void window_unload(Window *window) {
-  layer_destroy(disc_layer);
-}
-
-static void init(void) {
-  window = window_create();
-  window_set_window_handlers(window, (WindowHandlers) {
-    .load = window_load,
-    .unload = window_unload
-  });
-  window_stack_push(window, true /* Animated */);
-  window_set_background_color(window, GColorBlack);
-
-  accel_data_service_subscribe(0, NULL);
-
-  timer = app_timer_register(ACCEL_STEP_MS, timer_callback, NULL);
-}
-
-static void deinit(void) {
-  accel_data_service_unsubscribe();
-
-  window_destroy(window);
-}
-
-int main(void) {
-  init();
-  app_event_loop();
-  deinit();
-}
+#include "pebble.h"
+#include "disc_physics.h"
+#include "mbsda_msg.h"
+
+// Disc velocities are in pixels per ACCEL_STEP_MS. Physics runs at a fixed
+// step of one accelerometer sample period, consumed from the buffered
+// batches by an accumulator on the sample timestamps. Frames are drawn
+// from a separate timer at a lower rate, with positions interpolated
+// between the last two physics steps. Up and Down cycle the render and
+// physics rates at runtime.
+#define ACCEL_STEP_MS 50
+#define ACCEL_SAMPLES_PER_UPDATE 2
+#define MAX_STEPS_PER_BATCH 8
+
+// The simulation sleeps once all discs are slower than REST_SPEED and the
+// tilt has not changed by more than REST_ACCEL_DELTA mg for REST_BATCHES
+// batches. Each such batch takes 1/2^REST_DAMP_SHIFT off the velocities so
+// slow drifters come to a stop, and the rest left is zeroed on going to
+// sleep. Asleep, the accelerometer is only read once a second to look for a
+// change of tilt, and a tap wakes it too.
+#define REST_SPEED (FX_ONE / 2)
+#define REST_ACCEL_DELTA 60
+#define REST_BATCHES 12
+#define REST_DAMP_SHIFT 2
+#define REST_SAMPLING_RATE ACCEL_SAMPLING_10HZ
+#define REST_SAMPLES_PER_UPDATE 10
+
+// Only the areas of moved discs are redrawn, over the framebuffer kept from
+// the last frame. Past this many separate areas they get merged.
+#define MAX_DIRTY_RECTS 4
+
+// Discs are drawn from 1-bit sprites, one per integer radius, rasterised
+// at window load. Set to 0 to use graphics_fill_circle on platforms where
+// that is faster. DISC_DRAW_PROFILE alternates the two paths every frame
+// and logs the average draw time of each.
+#ifndef DISC_DRAW_SPRITES
+#define DISC_DRAW_SPRITES 1
+#endif
+#define MAX_SPRITE_RADIUS 31
+#define PROFILE_FRAMES 64
+
+static DiscSet discs;
+
+static Window *window;
+
+static GRect window_frame;
+
+static Layer *disc_layer;
+
+static const AccelSamplingRate physics_rates[] = {
+  ACCEL_SAMPLING_10HZ, ACCEL_SAMPLING_25HZ, ACCEL_SAMPLING_50HZ, ACCEL_SAMPLING_100HZ
+};
+
+static const uint32_t render_intervals_ms[] = { 50, 100, 200, 500 };
+
+static int physics_rate_idx = 1;
+
+static int render_interval_idx = 1;
+
+static uint32_t step_ms;
+
+static fixed_t step_dt;
+
+static uint32_t step_accum_ms;
+
+static uint64_t last_sample_ms;
+
+// Time the last physics step ended at, on the now_ms() clock
+static uint32_t last_step_ms;
+
+static int16_t step_accel_x;
+
+static int16_t step_accel_y;
+
+static AppTimer *render_timer;
+
+// Positions before the last physics step and the interpolated ones drawn
+static fixed_t prev_pos_x[NUM_DISCS];
+
+static fixed_t prev_pos_y[NUM_DISCS];
+
+static fixed_t draw_pos_x[NUM_DISCS];
+
+static fixed_t draw_pos_y[NUM_DISCS];
+
+static GRect drawn_box[NUM_DISCS];
+
+static GRect dirty_rects[MAX_DIRTY_RECTS];
+
+static int num_dirty_rects;
+
+static bool full_redraw = true;
+
+static bool resting;
+
+static int quiet_batches;
+
+static int16_t rest_accel_x;
+
+static int16_t rest_accel_y;
+
+// Time spent asleep and active, in ms
+static uint32_t asleep_ms;
+
+static uint32_t active_ms;
+
+static uint32_t mode_start_ms;
+
+static GBitmap *disc_sprites[MAX_SPRITE_RADIUS + 1];
+
+static bool draw_sprites = DISC_DRAW_SPRITES;
+
+// Latest activity summary from the MBSDA background worker
+static uint16_t mbsda_state;
+
+static uint16_t mbsda_flags;
+
+static uint16_t mbsda_stda_mean;
+
+#ifdef DISC_DRAW_PROFILE
+static uint32_t profile_ms[2];
+
+static uint32_t profile_frames[2];
+#endif
+
+static GRect disc_box(int i) {
+  const int r = FX_TO_INT(discs.radius[i]);
+  return GRect(FX_TO_INT(draw_pos_x[i]) - r, FX_TO_INT(draw_pos_y[i]) - r, 2 * r + 1, 2 * r + 1);
+}
+
+static GRect rect_union(GRect a, GRect b) {
+  const int x0 = a.origin.x < b.origin.x ? a.origin.x : b.origin.x;
+  const int y0 = a.origin.y < b.origin.y ? a.origin.y : b.origin.y;
+  const int ax1 = a.origin.x + a.size.w, bx1 = b.origin.x + b.size.w;
+  const int ay1 = a.origin.y + a.size.h, by1 = b.origin.y + b.size.h;
+  return GRect(x0, y0, (ax1 > bx1 ? ax1 : bx1) - x0, (ay1 > by1 ? ay1 : by1) - y0);
+}
+
+static bool rect_touch(GRect a, GRect b) {
+  return a.origin.x <= b.origin.x + b.size.w && b.origin.x <= a.origin.x + a.size.w
+    && a.origin.y <= b.origin.y + b.size.h && b.origin.y <= a.origin.y + a.size.h;
+}
+
+static int32_t rect_area(GRect r) {
+  return (int32_t)r.size.w * r.size.h;
+}
+
+static void dirty_add(GRect rect) {
+  // Absorb every touching rect, then append or merge into the rect that
+  // grows the least
+  for (int i = 0; i < num_dirty_rects; ) {
+    if (rect_touch(rect, dirty_rects[i])) {
+      rect = rect_union(rect, dirty_rects[i]);
+      dirty_rects[i] = dirty_rects[--num_dirty_rects];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+  if (num_dirty_rects < MAX_DIRTY_RECTS) {
+    dirty_rects[num_dirty_rects++] = rect;
+    return;
+  }
+  int best = 0;
+  int32_t best_growth = INT32_MAX;
+  for (int i = 0; i < num_dirty_rects; i++) {
+    const int32_t growth = rect_area(rect_union(rect, dirty_rects[i])) - rect_area(dirty_rects[i]);
+    if (growth < best_growth) {
+      best_growth = growth;
+      best = i;
+    }
+  }
+  dirty_rects[best] = rect_union(rect, dirty_rects[best]);
+}
+
+static bool discs_invalidate(void) {
+  // Recomputed from what is on screen, so steps between two frames add up
+  if (!full_redraw) {
+    num_dirty_rects = 0;
+    for (int i = 0; i < NUM_DISCS; i++) {
+      const GRect box = disc_box(i);
+      if (!grect_equal(&box, &drawn_box[i])) {
+        dirty_add(rect_union(drawn_box[i], box));
+      }
+    }
+    // Nothing moved by a whole pixel, keep the frame on screen
+    if (num_dirty_rects == 0) {
+      return false;
+    }
+  }
+  layer_mark_dirty(disc_layer);
+  return true;
+}
+
+static bool disc_is_dirty(GRect box) {
+  for (int i = 0; i < num_dirty_rects; i++) {
+    if (rect_touch(box, dirty_rects[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static GBitmap *disc_sprite_create(int r) {
+  // Same coverage rule as a filled circle, centre pixel plus r on each side
+  const int size = 2 * r + 1;
+  GBitmap *sprite = gbitmap_create_blank(GSize(size, size));
+  if (!sprite) {
+    return NULL;
+  }
+  uint8_t *bits = sprite->addr;
+  memset(bits, 0, sprite->row_size_bytes * size);
+  for (int y = 0; y < size; y++) {
+    uint8_t *row = bits + y * sprite->row_size_bytes;
+    const int dy = y - r;
+    for (int x = 0; x < size; x++) {
+      const int dx = x - r;
+      if (dx * dx + dy * dy <= r * r + r) {
+        row[x >> 3] |= 1 << (x & 7);
+      }
+    }
+  }
+  return sprite;
+}
+
+static void disc_sprites_create(void) {
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const int r = FX_TO_INT(discs.radius[i]);
+    if (r <= MAX_SPRITE_RADIUS && !disc_sprites[r]) {
+      disc_sprites[r] = disc_sprite_create(r);
+    }
+  }
+}
+
+static void disc_sprites_destroy(void) {
+  for (int r = 0; r <= MAX_SPRITE_RADIUS; r++) {
+    if (disc_sprites[r]) {
+      gbitmap_destroy(disc_sprites[r]);
+      disc_sprites[r] = NULL;
+    }
+  }
+}
+
+static void disc_draw(GContext *ctx, int i, GRect box) {
+  const int r = FX_TO_INT(discs.radius[i]);
+  if (draw_sprites && r <= MAX_SPRITE_RADIUS && disc_sprites[r]) {
+    graphics_draw_bitmap_in_rect(ctx, disc_sprites[r], box);
+  } else {
+    graphics_fill_circle(ctx, GPoint(box.origin.x + r, box.origin.y + r), r);
+  }
+}
+
+static void disc_layer_update_callback(Layer *me, GContext *ctx) {
+#ifdef DISC_DRAW_PROFILE
+  time_t start_s;
+  uint16_t start_ms = time_ms(&start_s, NULL);
+#endif
+
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  if (full_redraw) {
+    graphics_fill_rect(ctx, layer_get_bounds(me), 0, GCornerNone);
+  } else {
+    for (int i = 0; i < num_dirty_rects; i++) {
+      graphics_fill_rect(ctx, dirty_rects[i], 0, GCornerNone);
+    }
+  }
+
+  // Discs are all white, so redrawing a whole disc that pokes out of a
+  // dirty rect only repaints pixels that were already white. Set bits of
+  // the sprites are white, OR leaves the background around each disc alone.
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  graphics_context_set_compositing_mode(ctx, GCompOpOr);
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const GRect box = disc_box(i);
+    if (full_redraw || disc_is_dirty(box)) {
+      disc_draw(ctx, i, box);
+    }
+    drawn_box[i] = box;
+  }
+
+  full_redraw = false;
+  num_dirty_rects = 0;
+
+#ifdef DISC_DRAW_PROFILE
+  time_t end_s;
+  uint16_t end_ms = time_ms(&end_s, NULL);
+  profile_ms[draw_sprites] += (end_s - start_s) * 1000 + end_ms - start_ms;
+  if (++profile_frames[draw_sprites] == PROFILE_FRAMES) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "draw fill_circle %lu ms sprites %lu ms per %d frames",
+        (unsigned long)profile_ms[0], (unsigned long)profile_ms[1], PROFILE_FRAMES);
+    profile_ms[0] = profile_ms[1] = 0;
+    profile_frames[0] = profile_frames[1] = 0;
+  }
+  draw_sprites = !draw_sprites;
+#endif
+}
+
+static uint32_t now_ms(void) {
+  time_t s;
+  uint16_t ms = time_ms(&s, NULL);
+  return (uint32_t)s * 1000 + ms;
+}
+
+static void accel_data_handler(AccelData *data, uint32_t num_samples);
+
+static void accel_subscribe(bool rest) {
+  accel_data_service_unsubscribe();
+  if (rest) {
+    accel_data_service_subscribe(REST_SAMPLES_PER_UPDATE, accel_data_handler);
+    accel_service_set_sampling_rate(REST_SAMPLING_RATE);
+  } else {
+    const AccelSamplingRate rate = physics_rates[physics_rate_idx];
+    step_ms = 1000 / rate;
+    step_dt = FX_FROM_INT(step_ms) / ACCEL_STEP_MS;
+    step_accum_ms = 0;
+    last_sample_ms = 0;
+    accel_data_service_subscribe(ACCEL_SAMPLES_PER_UPDATE, accel_data_handler);
+    accel_service_set_sampling_rate(rate);
+  }
+}
+
+static void render_timer_callback(void *data) {
+  // Blend the last two physics states by the time since the last step, so
+  // the drawn discs run one step behind and keep moving between batches.
+  // Past a whole step the newest state is drawn as it is.
+  const int32_t since = (int32_t)(now_ms() - last_step_ms);
+  fixed_t alpha = FX_ONE;
+  if (since <= 0) {
+    alpha = 0;
+  } else if ((uint32_t)since < step_ms) {
+    alpha = FX_FROM_INT(since) / step_ms;
+  }
+  for (int i = 0; i < NUM_DISCS; i++) {
+    draw_pos_x[i] = prev_pos_x[i] + FX_MUL(discs.pos_x[i] - prev_pos_x[i], alpha);
+    draw_pos_y[i] = prev_pos_y[i] + FX_MUL(discs.pos_y[i] - prev_pos_y[i], alpha);
+  }
+  discs_invalidate();
+  render_timer = app_timer_register(render_intervals_ms[render_interval_idx],
+      render_timer_callback, NULL);
+}
+
+static void render_start(void) {
+  if (!render_timer) {
+    render_timer = app_timer_register(render_intervals_ms[render_interval_idx],
+        render_timer_callback, NULL);
+  }
+}
+
+static void render_stop(void) {
+  if (render_timer) {
+    app_timer_cancel(render_timer);
+    render_timer = NULL;
+  }
+}
+
+static void rest_set(bool rest) {
+  const uint32_t now = now_ms();
+  if (resting) {
+    asleep_ms += now - mode_start_ms;
+  } else {
+    active_ms += now - mode_start_ms;
+  }
+  mode_start_ms = now;
+  resting = rest;
+  quiet_batches = 0;
+  accel_subscribe(rest);
+  if (rest) {
+    // Whatever speed is left would be picked up again on waking, and the
+    // last frame shows where the discs really are
+    discs_damp(&discs, 0);
+    memcpy(prev_pos_x, discs.pos_x, sizeof(prev_pos_x));
+    memcpy(prev_pos_y, discs.pos_y, sizeof(prev_pos_y));
+    memcpy(draw_pos_x, discs.pos_x, sizeof(draw_pos_x));
+    memcpy(draw_pos_y, discs.pos_y, sizeof(draw_pos_y));
+    discs_invalidate();
+    render_stop();
+  } else {
+    render_start();
+  }
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "%s, asleep %lu ms active %lu ms", rest ? "rest" : "wake",
+      (unsigned long)asleep_ms, (unsigned long)active_ms);
+}
+
+static bool accel_changed(const AccelData *sample) {
+  return abs(sample->x - rest_accel_x) > REST_ACCEL_DELTA
+    || abs(sample->y - rest_accel_y) > REST_ACCEL_DELTA;
+}
+
+static void accel_tap_handler(AccelAxisType axis, int32_t direction) {
+  if (resting) {
+    rest_set(false);
+  }
+}
+
+static void accel_data_handler(AccelData *data, uint32_t num_samples) {
+  if (resting) {
+    // The discs stay put until the tilt changes
+    for (uint32_t i = 0; i < num_samples; i++) {
+      if (!data[i].did_vibrate && accel_changed(&data[i])) {
+        rest_set(false);
+        break;
+      }
+    }
+    return;
+  }
+
+  bool quiet = true;
+  for (uint32_t i = 0; i < num_samples; i++) {
+    // Samples taken while the vibe motor runs are noise, the last good
+    // reading is held
+    if (!data[i].did_vibrate) {
+      step_accel_x = data[i].x;
+      step_accel_y = data[i].y;
+      if (accel_changed(&data[i])) {
+        quiet = false;
+        rest_accel_x = data[i].x;
+        rest_accel_y = data[i].y;
+      }
+    }
+
+    // Timestamps rather than sample counts keep the step fixed across
+    // dropped samples. A long gap is not caught up on.
+    if (last_sample_ms != 0) {
+      step_accum_ms += (uint32_t)(data[i].timestamp - last_sample_ms);
+    }
+    last_sample_ms = data[i].timestamp;
+    if (step_accum_ms > MAX_STEPS_PER_BATCH * step_ms) {
+      step_accum_ms = MAX_STEPS_PER_BATCH * step_ms;
+    }
+    while (step_accum_ms >= step_ms) {
+      memcpy(prev_pos_x, discs.pos_x, sizeof(prev_pos_x));
+      memcpy(prev_pos_y, discs.pos_y, sizeof(prev_pos_y));
+      discs_apply_accel(&discs, step_accel_x, step_accel_y, step_dt);
+      discs_update(&discs, window_frame.size.w, window_frame.size.h, step_dt);
+      discs_collide(&discs, window_frame.size.w, window_frame.size.h);
+      step_accum_ms -= step_ms;
+      last_step_ms = (uint32_t)data[i].timestamp - step_accum_ms;
+    }
+  }
+
+  // Slow discs drift across pixels for minutes on bounces alone, so only
+  // the speed and the tilt count and the damping settles the drift
+  if (discs_max_speed(&discs) >= REST_SPEED) {
+    quiet = false;
+  }
+  if (!quiet) {
+    quiet_batches = 0;
+  } else if (++quiet_batches == REST_BATCHES) {
+    rest_set(true);
+  } else {
+    discs_damp(&discs, REST_DAMP_SHIFT);
+  }
+}
+
+static void window_load(Window *window) {
+  Layer *window_layer = window_get_root_layer(window);
+  GRect frame = window_frame = layer_get_frame(window_layer);
+
+  disc_layer = layer_create(frame);
+  layer_set_update_proc(disc_layer, disc_layer_update_callback);
+  layer_add_child(window_layer, disc_layer);
+
+  // Radii from 3 to 12.5 pixels, laid out in rows so they start apart
+  const int spacing = 26;
+  const int cols = frame.size.w / spacing;
+  const int rows = frame.size.h / spacing;
+  for (int i = 0; i < NUM_DISCS; i++) {
+    const int x = spacing / 2 + (i % cols) * spacing;
+    const int y = spacing / 2 + ((i / cols) % rows) * spacing;
+    disc_init(&discs, i, FX_FROM_INT(3) + (i % 20) * FX_HALF, x, y);
+  }
+  memcpy(prev_pos_x, discs.pos_x, sizeof(prev_pos_x));
+  memcpy(prev_pos_y, discs.pos_y, sizeof(prev_pos_y));
+  memcpy(draw_pos_x, discs.pos_x, sizeof(draw_pos_x));
+  memcpy(draw_pos_y, discs.pos_y, sizeof(draw_pos_y));
+
+  disc_sprites_create();
+}
+
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+  render_interval_idx = (render_interval_idx + 1) % ARRAY_LENGTH(render_intervals_ms);
+  if (!resting) {
+    render_stop();
+    render_start();
+  }
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "render every %lu ms",
+      (unsigned long)render_intervals_ms[render_interval_idx]);
+}
+
+static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+  physics_rate_idx = (physics_rate_idx + 1) % ARRAY_LENGTH(physics_rates);
+  if (!resting) {
+    accel_subscribe(false);
+  }
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "physics at %d Hz", (int)physics_rates[physics_rate_idx]);
+}
+
+static void worker_message_handler(uint16_t type, AppWorkerMessage *data) {
+  switch (type) {
+    case MBSDA_MSG_STATE:
+      mbsda_state = data->data0;
+      mbsda_flags = data->data1;
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "mbsda state %u flags 0x%02x at %u min",
+          mbsda_state, mbsda_flags, data->data2);
+      break;
+    case MBSDA_MSG_FEATURES:
+      mbsda_stda_mean = data->data0;
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "mbsda stda mean %u max %u mTpkR %d",
+          data->data0, data->data1, (int16_t)data->data2);
+      break;
+    case MBSDA_MSG_SPECTRUM:
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "mbsda %u.%02u Hz band %u%% max %u%%",
+          data->data0 >> 8, ((data->data0 & 0xff) * 100) >> 8,
+          (data->data1 * 100) >> 14, (data->data2 * 100) >> 14);
+      break;
+  }
+}
+
+static void click_config_provider(void *context) {
+  window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+  window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+}
+
+static void window_appear(Window *window) {
+  // Whatever covered the window may have drawn over the kept frame
+  full_redraw = true;
+  layer_mark_dirty(disc_layer);
+}
+
+static void window_unload(Window *window) {
+  disc_sprites_destroy();
+  layer_destroy(disc_layer);
+}
+
+static void init(void) {
+  window = window_create();
+  window_set_window_handlers(window, (WindowHandlers) {
+    .load = window_load,
+    .appear = window_appear,
+    .unload = window_unload
+  });
+  window_stack_push(window, true /* Animated */);
+  // The disc layer clears what it redraws, a window fill would wipe the
+  // kept frame
+  window_set_background_color(window, GColorClear);
+
+  window_set_click_config_provider(window, click_config_provider);
+
+  mode_start_ms = now_ms();
+  accel_subscribe(false);
+  render_start();
+  accel_tap_service_subscribe(accel_tap_handler);
+
+  // The worker keeps running the MBSDA after the app closes
+  app_worker_launch();
+  app_worker_message_subscribe(worker_message_handler);
+}
+
+static void deinit(void) {
+  app_worker_message_unsubscribe();
+  render_stop();
+  accel_tap_service_unsubscribe();
+  accel_data_service_unsubscribe();
+
+  window_destroy(window);
+}
+
+int main(void) {
+  init();
+  app_event_loop();
+  deinit();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Messages from the MBSDA background worker to the foreground app. Each is
+// one AppWorkerMessage of three 16-bit words, raw samples never cross.
+
+// Sent once per batch at most, when the state or the status flags change.
+//   data0 enum MbsdaStateId, data1 szFlags, data2 minutes since worker start
+#define MBSDA_MSG_STATE 1
+
+// Sent every MBSDA_MSG_FEATURE_PERIOD_S, features over that period.
+//   data0 mean stdaXyz, data1 max stdaXyz, data2 last mTpkR
+#define MBSDA_MSG_FEATURES 2
+
+// Sent with MBSDA_MSG_FEATURES, spectrum of the magnitude over that period.
+//   data0 mean dominant frequency (Hz in Q8), data1 mean and data2 max share
+//   of the power in the band of interest, 2-8 Hz at 25 Hz and up (Q14)
+#define MBSDA_MSG_SPECTRUM 3
+
+#define MBSDA_MSG_FEATURE_PERIOD_S 60
@@ -479,6 +479,10 @@ void QFsm_init_(QFsm * const me, QEvt const * const e);
 /*! Implementation of dispatching events to QFsm. */
 void QFsm_dispatch_(QFsm * const me, QEvt const * const e);
 
+/*! Dispatches a run of \a n events to QFsm in one call. */
+void QFsm_dispatchN(QFsm * const me, QEvt const * const events,
+                    uint_fast16_t n, uint_fast16_t stride);
+
 
 /****************************************************************************/
 /*! obtain the current QEP version number string */
@@ -641,6 +645,82 @@ enum {
 */
 #define Q_IGNORED()      ((QState)Q_RET_IGNORED)
 
+/*! Macro to call in a non-hierarchical state-handler coded as a
+* signal-indexed action table. Applicable only to FSMs.
+*/
+/**
+* \description
+* Indexes the action table \a table_ directly with the signal of the event
+* \a e_ instead of searching a `switch (e->sig)`. Each table entry is an
+* action with the state-handler signature, so entry/exit actions triggered
+* by QEP_ENTER_()/QEP_EXIT_() through the reserved events take the same
+* path. Signals beyond the end of the table, or with no action in the
+* table, return exactly what the `default` path of the switch form returns,
+* that is Q_IGNORED().
+*
+* \arguments
+* \arg[in]     \c table_ array of ::QStateHandler actions indexed by signal
+* \arg[in,out] \c me_    pointer (see \ref derivation)
+* \arg[in]     \c e_     pointer to the event being dispatched
+*/
+#define Q_SIG_TABLE_DISPATCH(table_, me_, e_) \
+    ((((e_)->sig < (QSignal)Q_DIM(table_)) \
+      && ((table_)[(e_)->sig] != Q_STATE_CAST(0))) \
+        ? (*(table_)[(e_)->sig])((me_), (e_)) \
+        : (QState)Q_RET_IGNORED)
+
+/*! Macro to define a non-hierarchical state-handler from a list of
+* (signal, action) pairs as a `switch (e->sig)`.
+*/
+/**
+* \description
+* \a actions_ is an X-macro that expands the macro it is given once per
+* (signal, action) pair of the state. Each action has the state-handler
+* signature. Signals that are not listed return Q_IGNORED().
+* Q_SIG_TABLE_HANDLER() defines the same state-handler from the same list
+* as a signal-indexed action table, so a state machine can be built either
+* way.
+*
+* \arguments
+* \arg[in] \c state_   name of the state-handler to define
+* \arg[in] \c type_    state machine class (see \ref derivation)
+* \arg[in] \c actions_ X-macro listing the (signal, action) pairs
+*/
+#define Q_SIG_SWITCH_HANDLER(state_, type_, actions_) \
+    QState state_(type_ * const me, QEvt const * const e) { \
+        switch (e->sig) { \
+            actions_(Q_SIG_CASE_) \
+        } \
+        return Q_IGNORED(); \
+    }
+
+/*! Macro to define a non-hierarchical state-handler from a list of
+* (signal, action) pairs as a signal-indexed action table.
+*/
+/**
+* \description
+* Defines the const table `state_##Tbl` of \a maxSig_ entries, one past the
+* largest signal listed, and the state-handler dispatching through it with
+* Q_SIG_TABLE_DISPATCH(). See Q_SIG_SWITCH_HANDLER().
+*
+* \arguments
+* \arg[in] \c state_   name of the state-handler to define
+* \arg[in] \c type_    state machine class (see \ref derivation)
+* \arg[in] \c maxSig_  size of the action table
+* \arg[in] \c actions_ X-macro listing the (signal, action) pairs
+*/
+#define Q_SIG_TABLE_HANDLER(state_, type_, maxSig_, actions_) \
+    static QStateHandler const Q_ROM state_##Tbl[maxSig_] = { \
+        actions_(Q_SIG_ENTRY_) \
+    }; \
+    QState state_(type_ * const me, QEvt const * const e) { \
+        return Q_SIG_TABLE_DISPATCH(state_##Tbl, me, e); \
+    }
+
+/* Expansions of one (signal, action) pair, internal */
+#define Q_SIG_CASE_(sig_, act_)  case sig_: return act_(me, e);
+#define Q_SIG_ENTRY_(sig_, act_) [sig_] = Q_STATE_CAST(&act_),
+
 
 /*! QEP reserved signals */
 enum {
@@ -0,0 +1,196 @@
+/**
+* \file
+* \brief Public QF/C interface (active objects, event queues, scheduler).
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qf_h
+#define qf_h
+
+/****************************************************************************/
+/*! Counter type of the event queues. */
+/**
+* \description
+* The head and tail counters run freely and wrap around modulo 2^32, so the
+* queue capacity must be a power of two.
+*/
+typedef uint32_t QEQueueCtr;
+
+/*! Native QF event queue of an active object. */
+/**
+* \description
+* Fixed-capacity ring buffer of event pointers. Any number of producers may
+* post to the queue, but only the QF scheduler takes events out of it. On
+* the host the queue is lock-free; on the target it is protected by the
+* QF critical section.
+*/
+typedef struct {
+    QEQueueSlot *ring;          /*!< ring buffer storage */
+    QEQueueCtr   mask;          /*!< ring capacity - 1 */
+    QEQueueCtr volatile head;   /*!< next slot to insert into (producers) */
+    QEQueueCtr volatile tail;   /*!< next slot to remove from (consumer) */
+} QEQueue;
+
+/****************************************************************************/
+/*! Active Object (based on QFsm-style state machine) */
+/**
+* \description
+* An active object is a state machine with its own event queue and a unique
+* priority. Events posted or published to it are processed one at a time,
+* in run-to-completion fashion, by the QF scheduler.
+*
+* \note QActive is not intended to be instantiated directly, but rather
+* serves as the base structure for derivation of active objects in the
+* application code (see \ref derivation).
+*/
+typedef struct {
+    QMsm super;           /*!< inherits ::QMsm */
+    QEQueue eQueue;       /*!< event queue of the active object */
+    uint_fast8_t prio;    /*!< QF priority (1..#QF_MAX_ACTIVE) */
+} QActive;
+
+/*! Protected "constructor" of an active object. */
+void QActive_ctor(QActive * const me, QStateHandler initial);
+
+/*! Starts execution of an active object and registers it with QF. */
+void QActive_start(QActive * const me, uint_fast8_t prio,
+                   QEQueueSlot * const qSto, uint_fast16_t const qLen,
+                   QEvt const * const ie);
+
+/*! Implementation of posting an event directly to an active object. */
+bool QActive_post_(QActive * const me, QEvt const * const e,
+                   uint_fast16_t const margin);
+
+/*! Invoke the direct event posting facility QActive_post_(). */
+/**
+* \description
+* Asserts that the event could be delivered, i.e. the queue of the
+* recipient is not full.
+*/
+#define QACTIVE_POST(me_, e_) \
+    ((void)QActive_post_((me_), (e_), (uint_fast16_t)0))
+
+/*! Invoke the direct event posting facility QActive_post_() without
+* delivery guarantee. */
+/**
+* \description
+* Returns 'false' (and does not post) when posting would leave fewer than
+* \a margin_ free slots in the queue of the recipient.
+*/
+#define QACTIVE_POST_X(me_, e_, margin_) \
+    (QActive_post_((me_), (e_), (margin_)))
+
+/*! Subscribes an active object for delivery of signal \a sig */
+void QActive_subscribe(QActive const * const me, enum_t const sig);
+
+/*! Un-subscribes an active object from the delivery of signal \a sig */
+void QActive_unsubscribe(QActive const * const me, enum_t const sig);
+
+/****************************************************************************/
+/*! Subscriber list: one bit per priority of the subscribed active objects */
+typedef uint32_t QSubscrList;
+
+/*! QF initialization. */
+void QF_init(void);
+
+/*! Publish-subscribe initialization. */
+void QF_psInit(QSubscrList * const subscrSto, enum_t const maxSignal);
+
+/*! Publish an event to all active objects subscribed to its signal. */
+void QF_publish_(QEvt const * const e);
+
+/*! Invoke the event publishing facility QF_publish_(). */
+#define QF_PUBLISH(e_, dummy_) (QF_publish_(e_))
+
+/*! Event pool initialization for dynamic allocation of events. */
+void QF_poolInit(void * const poolSto, uint_fast32_t const poolSize,
+                 uint_fast16_t const evtSize);
+
+/*! Obtain the block size of any registered event pools */
+uint_fast16_t QF_poolGetMaxBlockSize(void);
+
+/*! Obtain the low watermark of free blocks of the given event pool. */
+uint_fast16_t QF_getPoolMin(uint_fast8_t const poolId);
+
+/*! Obtain the number of failed allocations from the given event pool. */
+uint_fast32_t QF_getPoolFail(uint_fast8_t const poolId);
+
+/*! Internal QF implementation of the dynamic event allocator. */
+QEvt *QF_newX_(uint_fast16_t const evtSize,
+               uint_fast16_t const margin, enum_t const sig);
+
+/*! Allocate a dynamic event. */
+/**
+* \description
+* Allocates an event of type \a evtT_ from the smallest event pool that
+* fits it and sets its signal to \a sig_. Asserts if the pool is depleted.
+*
+* \usage
+* \code
+* XlDataEvt *xe = Q_NEW(XlDataEvt, XL_DATA_SIG);
+* xe->x = ...;
+* QACTIVE_POST(AO_Mbsda, &xe->super);
+* \endcode
+*/
+#define Q_NEW(evtT_, sig_) \
+    ((evtT_ *)QF_newX_((uint_fast16_t)sizeof(evtT_), \
+                       (uint_fast16_t)0, (enum_t)(sig_)))
+
+/*! Allocate a dynamic event (without delivery guarantee). */
+/**
+* \description
+* Like Q_NEW(), but sets \a e_ to NULL instead of asserting when the
+* allocation would leave no more than \a margin_ free blocks in the pool.
+*/
+#define Q_NEW_X(e_, evtT_, margin_, sig_) ((e_) = \
+    (evtT_ *)QF_newX_((uint_fast16_t)sizeof(evtT_), \
+                      (uint_fast16_t)(margin_), (enum_t)(sig_)))
+
+/*! Recycle a dynamic event once the last reference to it is gone. */
+void QF_gc(QEvt const * const e);
+
+/*! Runs one run-to-completion step of the highest-priority ready active
+* object. */
+bool QF_runOne(void);
+
+/*! Runs the QF scheduler. */
+int_t QF_run(void);
+
+/*! Makes QF_run() return (host only). */
+void QF_stop(void);
+
+#endif /* qf_h */
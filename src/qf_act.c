@@ -0,0 +1,108 @@
+/**
+* \file
+* \brief QActive_ctor() and QActive_start() definitions
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_act")
+
+/****************************************************************************/
+QActive *QF_active_[QF_MAX_ACTIVE + 1]; /* to be used by QF ports only */
+uint32_t volatile QF_readySet_;         /* to be used by QF ports only */
+
+/****************************************************************************/
+/**
+* \description
+* Performs the first step of active object initialization by assigning
+* the initial pseudostate to the currently active state of the state
+* machine.
+*
+* \arguments
+* \arg[in,out] \c me      pointer (see \ref derivation)
+* \arg[in]     \c initial pointer to the top-most initial state-handler
+*                         function in the derived state machine
+*
+* \note Must be called only by the constructors of the derived active
+* objects, before QActive_start().
+*
+* \note The active objects use the flat state machine (::QFsm) as their
+* event processor.
+*/
+void QActive_ctor(QActive * const me, QStateHandler initial) {
+    QFsm_ctor(&me->super, initial);
+    me->prio = (uint_fast8_t)0;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Assigns the priority and the event queue to the active object, registers
+* it with QF and executes the top-most initial transition of its state
+* machine.
+*
+* \arguments
+* \arg[in,out] \c me   pointer (see \ref derivation)
+* \arg[in]     \c prio priority of the active object (1..#QF_MAX_ACTIVE),
+*                      unique in the application
+* \arg[in]     \c qSto pointer to the storage for the ring buffer of the
+*                      event queue
+* \arg[in]     \c qLen length of the event queue, a power of two
+* \arg[in]     \c ie   pointer to the initial event (might be NULL)
+*/
+void QActive_start(QActive * const me, uint_fast8_t prio,
+                   QEQueueSlot * const qSto, uint_fast16_t const qLen,
+                   QEvt const * const ie)
+{
+    /** \pre the priority must be in range and not used yet, and the
+    * queue length must be a power of two
+    */
+    Q_REQUIRE_ID(100, ((uint_fast8_t)0 < prio)
+                      && (prio <= (uint_fast8_t)QF_MAX_ACTIVE)
+                      && (QF_active_[prio] == (QActive *)0)
+                      && (qLen > (uint_fast16_t)1)
+                      && ((qLen & (qLen - (uint_fast16_t)1))
+                          == (uint_fast16_t)0));
+
+    me->prio = prio;
+    QEQueue_init_(&me->eQueue, qSto, qLen);
+    QF_active_[prio] = me;         /* register the active object with QF */
+    QMSM_INIT(&me->super, ie);     /* take the top-most initial transition */
+}
@@ -0,0 +1,260 @@
+/**
+* \file
+* \brief QActive_post_() and the native QF event queue definitions
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_actq")
+
+#ifdef QF_HOST
+/*
+* On the host the event queue is a bounded multiple-producer/single-consumer
+* ring in which every slot carries a sequence number. A producer claims the
+* slot at 'head' with a compare-and-swap and publishes the event by storing
+* 'pos + 1' into the slot sequence. The consumer takes the slot at 'tail'
+* once its sequence is 'tail + 1' and frees it for the next lap by storing
+* 'tail + capacity'. Neither side ever blocks or takes a lock.
+*/
+
+/****************************************************************************/
+static bool QEQueue_put_(QEQueue * const me, QEvt const * const e,
+                         uint_fast16_t const margin)
+{
+    QEQueueCtr pos = QF_ATOMIC_LOAD_(&me->head);
+    QEQueueSlot *slot;
+    int32_t dif;
+
+    for (;;) {
+        /* would the post leave no more than 'margin' free slots? */
+        if ((margin != (uint_fast16_t)0)
+            && ((me->mask + 1U - (pos - QF_ATOMIC_LOAD_(&me->tail)))
+                <= (QEQueueCtr)margin))
+        {
+            return false;
+        }
+        slot = &me->ring[pos & me->mask];
+        dif = (int32_t)(QF_ATOMIC_LOAD_(&slot->seq) - pos);
+        if (dif == 0) { /* slot free in this lap? try to claim it */
+            if (QF_ATOMIC_CAS_(&me->head, &pos, pos + 1U)) {
+                break;
+            }
+        }
+        else if (dif < 0) { /* the queue is full */
+            return false;
+        }
+        else { /* another producer claimed the slot, reload the head */
+            pos = QF_ATOMIC_LOAD_(&me->head);
+        }
+    }
+    slot->evt = e;
+    QF_ATOMIC_STORE_(&slot->seq, pos + 1U); /* publish the event */
+    return true;
+}
+
+/****************************************************************************/
+static bool QEQueue_isEmpty_(QEQueue const * const me) {
+    QEQueueCtr pos = me->tail;
+    return (int32_t)(QF_ATOMIC_LOAD_(&me->ring[pos & me->mask].seq)
+                     - (pos + 1U)) < 0;
+}
+
+/****************************************************************************/
+static QEvt const *QEQueue_get_(QEQueue * const me) {
+    QEQueueCtr pos = me->tail;
+    QEQueueSlot *slot = &me->ring[pos & me->mask];
+    QEvt const *e;
+
+    if ((int32_t)(QF_ATOMIC_LOAD_(&slot->seq) - (pos + 1U)) < 0) {
+        return (QEvt const *)0; /* the queue is empty */
+    }
+    e = slot->evt;
+    QF_ATOMIC_STORE_(&slot->seq, pos + me->mask + 1U); /* free the slot */
+    QF_ATOMIC_STORE_(&me->tail, pos + 1U);
+    return e;
+}
+
+#else /* target, called inside the QF critical section */
+
+/****************************************************************************/
+static bool QEQueue_put_(QEQueue * const me, QEvt const * const e,
+                         uint_fast16_t const margin)
+{
+    if ((me->mask + 1U - (me->head - me->tail)) <= (QEQueueCtr)margin) {
+        return false;
+    }
+    if ((me->head - me->tail) > me->mask) { /* the queue is full */
+        return false;
+    }
+    me->ring[me->head & me->mask] = e;
+    ++me->head;
+    return true;
+}
+
+/****************************************************************************/
+static bool QEQueue_isEmpty_(QEQueue const * const me) {
+    return me->head == me->tail;
+}
+
+/****************************************************************************/
+static QEvt const *QEQueue_get_(QEQueue * const me) {
+    QEvt const *e = (QEvt const *)0;
+    if (me->head != me->tail) {
+        e = me->ring[me->tail & me->mask];
+        ++me->tail;
+    }
+    return e;
+}
+
+#endif /* QF_HOST */
+
+/****************************************************************************/
+/**
+* \description
+* Initializes the event queue with the ring buffer storage \a qSto of
+* \a qLen slots, where \a qLen is a power of two.
+*/
+void QEQueue_init_(QEQueue * const me, QEQueueSlot * const qSto,
+                   uint_fast16_t const qLen)
+{
+#ifdef QF_HOST
+    uint_fast16_t i;
+    for (i = (uint_fast16_t)0; i < qLen; ++i) {
+        qSto[i].seq = (uint32_t)i;
+    }
+#endif
+    me->ring = qSto;
+    me->mask = (QEQueueCtr)qLen - 1U;
+    me->head = 0U;
+    me->tail = 0U;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Direct event posting is the simplest asynchronous communication method
+* available in QF. The event is appended to the queue of the recipient,
+* which becomes ready to run, and the QF scheduler is woken up if nothing
+* else was ready.
+*
+* \arguments
+* \arg[in,out] \c me     pointer (see \ref derivation)
+* \arg[in]     \c e      pointer to the event to be posted
+* \arg[in]     \c margin number of required free slots in the queue
+*                        after posting the event. The special value 0
+*                        means that this function will assert if posting
+*                        fails.
+*
+* \returns 'true' if the posting succeeded and 'false' if it failed due to
+* insufficient margin of free slots in the queue.
+*
+* \note The reference counter of a dynamic event is incremented before the
+* event is inserted, so it cannot be recycled while still queued.
+*
+* \note On the host this function is lock-free and may be called from any
+* thread.
+*/
+bool QActive_post_(QActive * const me, QEvt const * const e,
+                   uint_fast16_t const margin)
+{
+    bool status;
+    QF_CRIT_STAT_
+
+    if (e->poolId_ != (uint8_t)0) {   /* is it a dynamic event? */
+        (void)QF_EVT_REF_CTR_INC_(e); /* increment the reference counter */
+    }
+
+    QF_CRIT_ENTRY_();
+    status = QEQueue_put_(&me->eQueue, e, margin);
+    if (status) {
+#ifdef QF_HOST
+        /* make the recipient ready, wake up the scheduler if it was idle */
+        if (QF_BITS_SET_(&QF_readySet_, QF_PRIO_BIT_(me->prio))
+            == (uint32_t)0)
+        {
+            QF_wake_();
+        }
+#else
+        (void)QF_BITS_SET_(&QF_readySet_, QF_PRIO_BIT_(me->prio));
+#endif
+    }
+    QF_CRIT_EXIT_();
+
+    if (!status) {
+        /** \note assert if the event could not be delivered with no
+        * margin requested
+        */
+        Q_ASSERT_ID(110, margin != (uint_fast16_t)0);
+
+        if (e->poolId_ != (uint8_t)0) {   /* undo the increment */
+            (void)QF_EVT_REF_CTR_DEC_(e);
+        }
+    }
+    return status;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Takes the next event out of the queue of the active object and removes
+* the active object from the ready set when its queue becomes empty.
+*
+* \note Called only by the QF scheduler (the single consumer of all queues)
+*/
+QEvt const *QActive_get_(QActive * const me) {
+    QEvt const *e;
+    QF_CRIT_STAT_
+
+    QF_CRIT_ENTRY_();
+    e = QEQueue_get_(&me->eQueue);
+    if (QEQueue_isEmpty_(&me->eQueue)) {
+        (void)QF_BITS_CLR_(&QF_readySet_, QF_PRIO_BIT_(me->prio));
+#ifdef QF_HOST
+        /* a producer might have published an event after the emptiness
+        * test and before its ready bit was cleared, so re-check
+        */
+        if (!QEQueue_isEmpty_(&me->eQueue)) {
+            (void)QF_BITS_SET_(&QF_readySet_, QF_PRIO_BIT_(me->prio));
+        }
+#endif
+    }
+    QF_CRIT_EXIT_();
+    return e;
+}
@@ -0,0 +1,186 @@
+/**
+* \file
+* \brief Dynamic event management: QF_poolInit(), QF_newX_() and the pool statistics.
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_dyn")
+
+/****************************************************************************/
+QMPool QF_pool_[QF_MAX_EPOOL]; /* allocate the event pools */
+uint_fast8_t QF_maxPool_;      /* number of initialized event pools */
+
+/****************************************************************************/
+/**
+* \description
+* Registers one more event pool with QF. Up to #QF_MAX_EPOOL pools can be
+* registered, typically small, medium and large.
+*
+* \arguments
+* \arg[in] \c poolSto  pointer to the storage for the event pool
+* \arg[in] \c poolSize size of the storage for the pool in bytes
+* \arg[in] \c evtSize  the block-size of the pool in bytes, which
+*                      determines the maximum size of events that can be
+*                      allocated from the pool
+*
+* \attention
+* The pools must be initialized in the ascending order of the event size,
+* so that QF_newX_() can pick the smallest fitting pool with a linear scan.
+*
+* \usage
+* \code
+* static QF_MPOOL_EL(QEvt)      l_smlPoolSto[16];
+* static QF_MPOOL_EL(XlDataEvt) l_medPoolSto[64];
+* QF_poolInit(l_smlPoolSto, sizeof(l_smlPoolSto), sizeof(l_smlPoolSto[0]));
+* QF_poolInit(l_medPoolSto, sizeof(l_medPoolSto), sizeof(l_medPoolSto[0]));
+* \endcode
+*/
+void QF_poolInit(void * const poolSto, uint_fast32_t const poolSize,
+                 uint_fast16_t const evtSize)
+{
+    /** \pre cannot exceed the number of available memory pools */
+    Q_REQUIRE_ID(200, QF_maxPool_ < (uint_fast8_t)Q_DIM(QF_pool_));
+
+    /** \pre please initialize event pools in ascending order of evtSize */
+    Q_REQUIRE_ID(201, (QF_maxPool_ == (uint_fast8_t)0)
+        || (QF_pool_[QF_maxPool_ - (uint_fast8_t)1].blockSize < evtSize));
+
+    /** \pre the event must be at least the size of the base class */
+    Q_REQUIRE_ID(202, evtSize >= (uint_fast16_t)sizeof(QEvt));
+
+    QMPool_init(&QF_pool_[QF_maxPool_], poolSto, poolSize, evtSize);
+    ++QF_maxPool_; /* one more pool */
+}
+
+/****************************************************************************/
+/**
+* \description
+* \returns the block size of the largest registered event pool, that is
+* the largest event that can be allocated dynamically.
+*/
+uint_fast16_t QF_poolGetMaxBlockSize(void) {
+    return (QF_maxPool_ == (uint_fast8_t)0)
+           ? (uint_fast16_t)0
+           : (uint_fast16_t)QF_pool_[QF_maxPool_ - (uint_fast8_t)1].blockSize;
+}
+
+/****************************************************************************/
+/**
+* \description
+* \returns the minimum number of free blocks ever seen in the event pool
+* \a poolId (1-based, as stored in QEvt.poolId_). The high watermark of
+* the pool usage is the total number of blocks minus this value.
+*/
+uint_fast16_t QF_getPoolMin(uint_fast8_t const poolId) {
+    /** \pre the pool ID must be in range */
+    Q_REQUIRE_ID(400, ((uint_fast8_t)1 <= poolId)
+                      && (poolId <= QF_maxPool_));
+
+    return (uint_fast16_t)QF_pool_[poolId - (uint_fast8_t)1].nMin;
+}
+
+/****************************************************************************/
+/**
+* \description
+* \returns the number of allocations that failed in the event pool
+* \a poolId (1-based) because it was depleted or the requested margin of
+* free blocks could not be kept.
+*/
+uint_fast32_t QF_getPoolFail(uint_fast8_t const poolId) {
+    /** \pre the pool ID must be in range */
+    Q_REQUIRE_ID(500, ((uint_fast8_t)1 <= poolId)
+                      && (poolId <= QF_maxPool_));
+
+    return (uint_fast32_t)QF_pool_[poolId - (uint_fast8_t)1].nFail;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Allocates an event dynamically from the smallest event pool whose blocks
+* fit \a evtSize. Only that pool is tried, larger pools are left for the
+* larger events.
+*
+* \arguments
+* \arg[in] \c evtSize the size (in bytes) of the event to allocate
+* \arg[in] \c margin  the number of un-allocated events still available
+*                     in a given event pool after the allocation completes.
+*                     The special value 0 means that the function will
+*                     assert if the allocation fails.
+* \arg[in] \c sig     the signal to be assigned to the allocated event
+*
+* \returns pointer to the newly allocated event, with the reference counter
+* at zero. This pointer is NULL only if margin != 0 and the event cannot be
+* allocated with the specified margin still available in the given pool.
+*
+* \note The application code should not call this function directly.
+* The only allowed use is through the macros Q_NEW() or Q_NEW_X().
+*/
+QEvt *QF_newX_(uint_fast16_t const evtSize,
+               uint_fast16_t const margin, enum_t const sig)
+{
+    QEvt *e;
+    uint_fast8_t idx;
+
+    /* find the pool index that fits the requested event size ... */
+    for (idx = (uint_fast8_t)0; idx < QF_maxPool_; ++idx) {
+        if (evtSize <= (uint_fast16_t)QF_pool_[idx].blockSize) {
+            break;
+        }
+    }
+    /* cannot run out of registered pools */
+    Q_ASSERT_ID(310, idx < QF_maxPool_);
+
+    /* get e -- platform-dependent */
+    e = (QEvt *)QMPool_get(&QF_pool_[idx], margin);
+
+    /* was e allocated correctly? */
+    if (e != (QEvt *)0) {
+        e->sig     = (QSignal)sig;        /* set signal for this event */
+        e->poolId_ = (uint8_t)(idx + (uint_fast8_t)1); /* store pool ID */
+        e->refCtr_ = (uint8_t)0;          /* set the reference counter */
+    }
+    else {
+        /* must tolerate bad alloc.? */
+        Q_ASSERT_ID(320, margin != (uint_fast16_t)0);
+    }
+    return e;
+}
@@ -0,0 +1,80 @@
+/**
+* \file
+* \brief QF_gc() definition
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_gc")
+
+/****************************************************************************/
+/**
+* \description
+* Decrements the reference counter of a dynamic event and recycles the
+* event to the pool it came from when the last reference is gone. Static
+* events (pool ID 0) are never recycled and are left untouched.
+*
+* \arguments
+* \arg[in] \c e pointer to the event to recycle
+*
+* \note QF invokes the garbage collector after every run-to-completion
+* step and at the end of every publish, so the application calls QF_gc()
+* only for dynamic events that it allocated but never posted.
+*/
+void QF_gc(QEvt const * const e) {
+    if (e->poolId_ != (uint8_t)0) { /* is it a dynamic event? */
+        QF_CRIT_STAT_
+        uint8_t refCtr;
+
+        QF_CRIT_ENTRY_();
+        refCtr = QF_EVT_REF_CTR_DEC_(e);
+        QF_CRIT_EXIT_();
+
+        /* was it the last reference (or an event never posted at all)? */
+        if (refCtr <= (uint8_t)1) {
+            uint_fast8_t idx = (uint_fast8_t)e->poolId_ - (uint_fast8_t)1;
+
+            /* the pool ID must be in range */
+            Q_ASSERT_ID(110, idx < QF_maxPool_);
+
+            QMPool_put(&QF_pool_[idx], QF_EVT_CONST_CAST_(e));
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/**
+* \file
+* \brief ::QMPool implementation (Memory Pool)
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_mem")
+
+/*! Free block, the link of the free list is stored in the block itself */
+typedef union {
+    void *next;          /* next free block (target) */
+    uint32_t nextIdx;    /* index of the next free block + 1 (host) */
+} QFreeBlock;
+
+/****************************************************************************/
+/**
+* \description
+* Initialize a fixed block-size memory pool by providing it with the pool
+* memory to manage, size of this memory, and the block size.
+*
+* \arguments
+* \arg[in,out] \c me        pointer (see \ref derivation)
+* \arg[in]     \c poolSto   pointer to the memory buffer for pool storage
+* \arg[in]     \c poolSize  size of the storage buffer in bytes
+* \arg[in]     \c blockSize fixed-size of the memory blocks in bytes
+*
+* \note The actual block size is rounded up to a multiple of the size of
+* ::QFreeBlock, which also aligns every block for any event structure.
+* The pool storage must be aligned the same way.
+*/
+void QMPool_init(QMPool * const me, void * const poolSto,
+                 uint_fast32_t poolSize, uint_fast16_t blockSize)
+{
+    uint_fast16_t size;
+    QMPoolCtr n;
+    uint8_t *blk;
+
+    /** \pre the pool storage must be aligned for ::QFreeBlock and large
+    * enough to hold at least one block
+    */
+    Q_REQUIRE_ID(100, (poolSto != (void *)0)
+                      && (((uintptr_t)poolSto
+                           % (uintptr_t)sizeof(QFreeBlock)) == 0U)
+                      && (blockSize > (uint_fast16_t)0));
+
+    /* round up the block size to a whole number of free-block links */
+    size = (uint_fast16_t)(((blockSize + sizeof(QFreeBlock) - 1U)
+                            / sizeof(QFreeBlock)) * sizeof(QFreeBlock));
+    n = (QMPoolCtr)(poolSize / size);
+
+    /* the pool must hold at least one block and the count must fit */
+    Q_ASSERT_ID(110, (n > (QMPoolCtr)0)
+                     && ((poolSize / size) <= (uint_fast32_t)0xFFFFU));
+
+    me->start     = poolSto;
+    me->blockSize = (QMPoolSize)size;
+    me->nTot      = n;
+    me->nFree     = n;
+    me->nMin      = n;
+    me->nFail     = (uint32_t)0;
+
+    /* chain all blocks together into the free list, first block on top */
+    blk = (uint8_t *)poolSto;
+    for (; n > (QMPoolCtr)1; --n, blk += size) {
+#ifdef QF_HOST
+        /* the block after blk has index (blk - start)/size + 1 */
+        ((QFreeBlock *)blk)->nextIdx =
+            (uint32_t)((blk - (uint8_t *)poolSto) / size) + 2U;
+#else
+        ((QFreeBlock *)blk)->next = (void *)(blk + size);
+#endif
+    }
+#ifdef QF_HOST
+    ((QFreeBlock *)blk)->nextIdx = 0U;  /* the last block ends the list */
+    me->top = (uint64_t)1U;             /* first block on top, tag 0 */
+#else
+    ((QFreeBlock *)blk)->next = (void *)0;
+    me->free_head = poolSto;
+#endif
+}
+
+/****************************************************************************/
+/**
+* \description
+* The function allocates a memory block from the pool and returns a pointer
+* to the block back to the caller.
+*
+* \arguments
+* \arg[in,out] \c me     pointer (see \ref derivation)
+* \arg[in]     \c margin the minimum number of unused blocks still available
+*                        in the pool after the allocation.
+*
+* \returns a pointer to a memory block or a NULL pointer if there are no
+* more free blocks in the pool or the margin would be violated. Every
+* failed allocation is counted in ::QMPool.nFail.
+*
+* \note On the host this function is lock-free and may be called from any
+* thread.
+*/
+void *QMPool_get(QMPool * const me, uint_fast16_t const margin) {
+    QFreeBlock *fb;
+    QMPoolCtr nFree;
+    QF_CRIT_STAT_
+
+#ifdef QF_HOST
+    uint64_t top;
+    uint64_t newTop;
+    uint32_t idx;
+
+    /* reserve a block by decrementing nFree, unless that would leave
+    * no more than 'margin' free blocks. A reservation always finds a block
+    * on the free list, because QMPool_put() links a block in before it
+    * counts it as free.
+    */
+    nFree = QF_ATOMIC_LOAD_(&me->nFree);
+    do {
+        if (nFree <= (QMPoolCtr)margin) {
+            (void)QF_ATOMIC_ADD_(&me->nFail, (uint32_t)1);
+            return (void *)0;
+        }
+    } while (!QF_ATOMIC_CAS_(&me->nFree, &nFree,
+                             (QMPoolCtr)(nFree - 1U)));
+    --nFree;
+
+    /* update the low watermark */
+    {
+        QMPoolCtr nMin = QF_ATOMIC_LOAD_(&me->nMin);
+        while ((nFree < nMin)
+               && (!QF_ATOMIC_CAS_(&me->nMin, &nMin, nFree)))
+        {
+        }
+    }
+
+    top = QF_ATOMIC_LOAD_(&me->top);
+    do {
+        idx = (uint32_t)top;
+
+        /* the free list must be consistent with the reservation */
+        Q_ASSERT_ID(320, idx != 0U);
+
+        fb = (QFreeBlock *)((uint8_t *)me->start
+                            + ((uint_fast32_t)(idx - 1U) * me->blockSize));
+
+        /* the link might be overwritten by a concurrent owner of the block,
+        * but then the tag has changed and the CAS below fails
+        */
+        newTop = (((top >> 32) + 1U) << 32)
+                 | (uint64_t)__atomic_load_n(&fb->nextIdx, __ATOMIC_RELAXED);
+    } while (!QF_ATOMIC_CAS_(&me->top, &top, newTop));
+#else
+    QF_CRIT_ENTRY_();
+    if (me->nFree > (QMPoolCtr)margin) {
+        fb = (QFreeBlock *)me->free_head;
+
+        /* the free list must be consistent with the free block count */
+        Q_ASSERT_ID(310, fb != (QFreeBlock *)0);
+
+        me->free_head = fb->next;
+        nFree = --me->nFree;
+        if (me->nMin > nFree) {
+            me->nMin = nFree; /* remember the minimum so far */
+        }
+    }
+    else {
+        fb = (QFreeBlock *)0;
+        ++me->nFail;
+    }
+    QF_CRIT_EXIT_();
+#endif
+    (void)nFree;
+    return (void *)fb;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Recycle a memory block to the fixed block-size memory pool.
+*
+* \arguments
+* \arg[in,out] \c me pointer (see \ref derivation)
+* \arg[in]     \c b  pointer to the memory block that is being recycled
+*
+* \attention
+* The recycled block must be allocated from the __same__ memory pool
+* to which it is returned.
+*/
+void QMPool_put(QMPool * const me, void *b) {
+#ifdef QF_HOST
+    QMPoolCtr const nFree = QF_ATOMIC_LOAD_(&me->nFree);
+#else
+    QMPoolCtr const nFree = me->nFree;
+#endif
+    QF_CRIT_STAT_
+
+    /** \pre # free blocks cannot exceed the total # blocks and
+    * the block pointer must be from this pool.
+    */
+    Q_REQUIRE_ID(200, (nFree < me->nTot)
+                      && ((uint8_t *)me->start <= (uint8_t *)b)
+                      && ((uint8_t *)b < ((uint8_t *)me->start
+                          + ((uint_fast32_t)me->nTot * me->blockSize))));
+
+#ifdef QF_HOST
+    {
+        uint64_t top = QF_ATOMIC_LOAD_(&me->top);
+        uint64_t newTop;
+        uint32_t idx = (uint32_t)(((uint8_t *)b - (uint8_t *)me->start)
+                                  / me->blockSize) + 1U;
+        do {
+            __atomic_store_n(&((QFreeBlock *)b)->nextIdx, (uint32_t)top,
+                             __ATOMIC_RELAXED);
+            newTop = (((top >> 32) + 1U) << 32) | (uint64_t)idx;
+        } while (!QF_ATOMIC_CAS_(&me->top, &top, newTop));
+
+        /* count the block as free only once it is linked in, so that a
+        * reservation in QMPool_get() never finds the free list empty
+        */
+        (void)QF_ATOMIC_ADD_(&me->nFree, (QMPoolCtr)1);
+    }
+#else
+    QF_CRIT_ENTRY_();
+    ((QFreeBlock *)b)->next = me->free_head; /* link into the free list */
+    me->free_head = b;                        /* set as new head */
+    ++me->nFree;                              /* one more free block */
+    QF_CRIT_EXIT_();
+#endif
+}
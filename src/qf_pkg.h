@@ -0,0 +1,120 @@
+/**
+* \file
+* \brief Internal (package scope) QF/C interface.
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qf_pkg_h
+#define qf_pkg_h
+
+/****************************************************************************/
+/* internal QF objects */
+
+/*! active objects registered with QF, indexed by priority */
+extern QActive *QF_active_[QF_MAX_ACTIVE + 1];
+
+/*! set of active objects with non-empty queues, bit (p-1) for priority p */
+extern uint32_t volatile QF_readySet_;
+
+/*! subscriber lists indexed by signal */
+extern QSubscrList *QF_subscrList_;
+
+/*! the maximum published signal (the size of ::QF_subscrList_) */
+extern enum_t QF_maxSignal_;
+
+/*! allocate event pools */
+extern QMPool QF_pool_[QF_MAX_EPOOL];
+
+/*! # of initialized event pools */
+extern uint_fast8_t QF_maxPool_;
+
+/****************************************************************************/
+/* internal QF functions */
+
+/*! initializes the event queue \a me with the ring storage \a qSto */
+void QEQueue_init_(QEQueue * const me, QEQueueSlot * const qSto,
+                   uint_fast16_t const qLen);
+
+/*! removes the next event from the queue of the active object \a me */
+QEvt const *QActive_get_(QActive * const me);
+
+#ifdef QF_HOST
+/*! wakes up the QF scheduler after the ready set became non-empty */
+void QF_wake_(void);
+#endif
+
+/****************************************************************************/
+/*! helper macro to cast const away from an event pointer \a e_ */
+#define QF_EVT_CONST_CAST_(e_) ((QEvt *)(e_))
+
+/*! log-base-2 of a non-zero 32-bit bitmask, that is the 1-based position
+* of its highest set bit
+*/
+#define QF_LOG2_(x_) ((uint_fast8_t)(32U - (uint_fast8_t)__builtin_clz(x_)))
+
+/*! bitmask of the priority \a p_ in the ready set and subscriber lists */
+#define QF_PRIO_BIT_(p_) ((uint32_t)1U << ((uint_fast8_t)(p_) - 1U))
+
+#ifdef QF_HOST
+
+    /* shared QF state is updated with atomic read-modify-write operations,
+    * which return the previous value
+    */
+    #define QF_BITS_GET_(p_)        QF_ATOMIC_LOAD_(p_)
+    #define QF_BITS_SET_(p_, b_)    QF_ATOMIC_OR_((p_), (b_))
+    #define QF_BITS_CLR_(p_, b_)    QF_ATOMIC_AND_((p_), ~(b_))
+
+    /* increment/decrement the reference counter, return the old value */
+    #define QF_EVT_REF_CTR_INC_(e_) \
+        QF_ATOMIC_ADD_(&QF_EVT_CONST_CAST_(e_)->refCtr_, (uint8_t)1)
+    #define QF_EVT_REF_CTR_DEC_(e_) \
+        QF_ATOMIC_SUB_(&QF_EVT_CONST_CAST_(e_)->refCtr_, (uint8_t)1)
+
+#else
+
+    /* shared QF state is updated inside the QF critical section */
+    #define QF_BITS_GET_(p_)        (*(p_))
+    #define QF_BITS_SET_(p_, b_)    (*(p_) |= (b_))
+    #define QF_BITS_CLR_(p_, b_)    (*(p_) &= ~(b_))
+
+    /* increment/decrement the reference counter, return the old value */
+    #define QF_EVT_REF_CTR_INC_(e_) (QF_EVT_CONST_CAST_(e_)->refCtr_++)
+    #define QF_EVT_REF_CTR_DEC_(e_) (QF_EVT_CONST_CAST_(e_)->refCtr_--)
+
+#endif /* QF_HOST */
+
+#endif /* qf_pkg_h */
@@ -0,0 +1,123 @@
+/**
+* \file
+* \brief QF/C port to the Pebble target and to the POSIX host
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qf_port_h
+#define qf_port_h
+
+#include "qep_port.h" /* QEP port */
+
+/*! The maximum number of active objects in the application. */
+/**
+* \description
+* Priorities of active objects range from 1 to QF_MAX_ACTIVE and the set of
+* ready active objects is kept in a single 32-bit word, so the value must
+* not exceed 32.
+*/
+#ifndef QF_MAX_ACTIVE
+    #define QF_MAX_ACTIVE 8
+#endif
+
+/*! The maximum number of event pools in the application. */
+/**
+* \description
+* Typically one small, one medium and one large pool, for example for bare
+* signals, single accelerometer samples and batches of samples.
+*/
+#ifndef QF_MAX_EPOOL
+    #define QF_MAX_EPOOL 3
+#endif
+
+#ifdef QF_HOST /* POSIX host (pthreads), lock-free event posting */
+
+    /*! Event queue slot carrying the sequence number of the lock-free
+    * bounded queue.
+    */
+    typedef struct {
+        QEvt const *evt;          /*!< the event stored in this slot */
+        uint32_t volatile seq;    /*!< slot sequence number */
+    } QEQueueSlot;
+
+    /* atomic operations on the shared QF state, GCC/Clang builtins */
+    #define QF_ATOMIC_LOAD_(p_)       __atomic_load_n((p_), __ATOMIC_ACQUIRE)
+    #define QF_ATOMIC_STORE_(p_, v_)  \
+        __atomic_store_n((p_), (v_), __ATOMIC_RELEASE)
+    #define QF_ATOMIC_OR_(p_, v_)     \
+        __atomic_fetch_or((p_), (v_), __ATOMIC_ACQ_REL)
+    #define QF_ATOMIC_AND_(p_, v_)    \
+        __atomic_fetch_and((p_), (v_), __ATOMIC_ACQ_REL)
+    #define QF_ATOMIC_ADD_(p_, v_)    \
+        __atomic_fetch_add((p_), (v_), __ATOMIC_ACQ_REL)
+    #define QF_ATOMIC_SUB_(p_, v_)    \
+        __atomic_fetch_sub((p_), (v_), __ATOMIC_ACQ_REL)
+    #define QF_ATOMIC_CAS_(p_, pOld_, new_) \
+        __atomic_compare_exchange_n((p_), (pOld_), (new_), true, \
+            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+
+    /* no critical sections are needed on the host */
+    #define QF_CRIT_STAT_
+    #define QF_CRIT_ENTRY_()          ((void)0)
+    #define QF_CRIT_EXIT_()           ((void)0)
+
+#else /* Pebble target, critical-section based */
+
+    /*! Event queue slot (just the event pointer on the target) */
+    typedef QEvt const *QEQueueSlot;
+
+    /*! QF critical section status, entry and exit. */
+    /**
+    * \description
+    * On the Pebble all app and worker callbacks (timers, accelerometer
+    * handlers, worker messages) run to completion on a single task, so
+    * there is nothing to mask and the critical section compiles away.
+    * A port to a bare-metal target defines these three macros to save,
+    * disable and restore the interrupt status before including this file.
+    */
+    #ifndef QF_CRIT_ENTRY_
+        #define QF_CRIT_STAT_
+        #define QF_CRIT_ENTRY_()      ((void)0)
+        #define QF_CRIT_EXIT_()       ((void)0)
+    #endif
+
+#endif /* QF_HOST */
+
+#include "qmpool.h"   /* QF memory pool */
+#include "qf.h"       /* QF platform-independent public interface */
+
+#endif /* qf_port_h */
@@ -0,0 +1,167 @@
+/**
+* \file
+* \brief Publish-subscribe services definitions.
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qf_ps")
+
+/****************************************************************************/
+QSubscrList *QF_subscrList_; /* to be used by QF ports only */
+enum_t QF_maxSignal_;        /* to be used by QF ports only */
+
+/****************************************************************************/
+/**
+* \description
+* Initializes the publish-subscribe facilities of QF with the storage for
+* the subscriber lists, one list for each signal below \a maxSignal.
+*
+* \arguments
+* \arg[in] \c subscrSto pointer to the array of subscriber lists
+* \arg[in] \c maxSignal the dimension of the subscriber array and at the
+*                       same time the maximum signal that can be published
+*                       or subscribed
+*/
+void QF_psInit(QSubscrList * const subscrSto, enum_t const maxSignal) {
+    enum_t sig;
+
+    QF_subscrList_ = subscrSto;
+    QF_maxSignal_  = maxSignal;
+    for (sig = (enum_t)0; sig < maxSignal; ++sig) {
+        subscrSto[sig] = (QSubscrList)0;
+    }
+}
+
+/****************************************************************************/
+/**
+* \description
+* Posts the event \a e to every active object subscribed to its signal,
+* starting with the highest priority. A dynamic event is shared by all the
+* recipients (zero-copy) and recycled after the last one processed it.
+*
+* \arguments
+* \arg[in] \c e pointer to the event to be published
+*
+* \note The reference counter of a dynamic event is incremented for the
+* duration of the multicast, so that an active object running on another
+* thread cannot recycle the event before it has been posted to all the
+* subscribers.
+*/
+void QF_publish_(QEvt const * const e) {
+    QSubscrList subscrList;
+    uint_fast8_t p;
+    QF_CRIT_STAT_
+
+    /** \pre the published signal must be within the configured range */
+    Q_REQUIRE_ID(100, (enum_t)e->sig < QF_maxSignal_);
+
+    if (e->poolId_ != (uint8_t)0) {   /* is it a dynamic event? */
+        (void)QF_EVT_REF_CTR_INC_(e); /* protect the event while posting */
+    }
+
+    QF_CRIT_ENTRY_();
+    subscrList = QF_BITS_GET_(&QF_subscrList_[e->sig]);
+    QF_CRIT_EXIT_();
+
+    while (subscrList != (QSubscrList)0) {
+        p = QF_LOG2_(subscrList);
+        subscrList &= ~QF_PRIO_BIT_(p);
+
+        /* the subscriber must be registered */
+        Q_ASSERT_ID(110, QF_active_[p] != (QActive *)0);
+
+        QACTIVE_POST(QF_active_[p], e); /* asserts on queue overflow */
+    }
+
+    QF_gc(e); /* release the protection of the event */
+}
+
+/****************************************************************************/
+/**
+* \description
+* Adds the active object to the subscriber list of signal \a sig.
+*
+* \arguments
+* \arg[in] \c me  pointer (see \ref derivation)
+* \arg[in] \c sig signal to be subscribed
+*/
+void QActive_subscribe(QActive const * const me, enum_t const sig) {
+    QF_CRIT_STAT_
+
+    /** \pre the signal and the priority must be in range and the active
+    * object must be registered with QF
+    */
+    Q_REQUIRE_ID(200, ((enum_t)Q_USER_SIG <= sig)
+                      && (sig < QF_maxSignal_)
+                      && ((uint_fast8_t)0 < me->prio)
+                      && (me->prio <= (uint_fast8_t)QF_MAX_ACTIVE)
+                      && (QF_active_[me->prio] == me));
+
+    QF_CRIT_ENTRY_();
+    (void)QF_BITS_SET_(&QF_subscrList_[sig], QF_PRIO_BIT_(me->prio));
+    QF_CRIT_EXIT_();
+}
+
+/****************************************************************************/
+/**
+* \description
+* Removes the active object from the subscriber list of signal \a sig.
+*
+* \arguments
+* \arg[in] \c me  pointer (see \ref derivation)
+* \arg[in] \c sig signal to be unsubscribed
+*/
+void QActive_unsubscribe(QActive const * const me, enum_t const sig) {
+    QF_CRIT_STAT_
+
+    /** \pre the signal and the priority must be in range and the active
+    * object must be registered with QF
+    */
+    Q_REQUIRE_ID(300, ((enum_t)Q_USER_SIG <= sig)
+                      && (sig < QF_maxSignal_)
+                      && ((uint_fast8_t)0 < me->prio)
+                      && (me->prio <= (uint_fast8_t)QF_MAX_ACTIVE)
+                      && (QF_active_[me->prio] == me));
+
+    QF_CRIT_ENTRY_();
+    (void)QF_BITS_CLR_(&QF_subscrList_[sig], QF_PRIO_BIT_(me->prio));
+    QF_CRIT_EXIT_();
+}
@@ -0,0 +1,164 @@
+/**
+* \file
+* \brief QF_init(), QF_run() and the run-to-completion scheduler.
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qf_port.h"      /* QF port */
+#include "qf_pkg.h"
+#include "qassert.h"
+#ifdef QF_HOST
+    #include <semaphore.h>
+#endif
+
+Q_DEFINE_THIS_MODULE("qf_run")
+
+#ifdef QF_HOST
+static sem_t l_wakeSem;          /* signaled when the ready set fills up */
+static bool volatile l_running;  /* set by QF_init(), cleared by QF_stop() */
+#endif
+
+/****************************************************************************/
+/**
+* \description
+* Initializes QF and must be called exactly once before any other QF
+* function, typically at the beginning of main() or the app/worker init().
+*/
+void QF_init(void) {
+    uint_fast8_t p;
+
+    for (p = (uint_fast8_t)0; p <= (uint_fast8_t)QF_MAX_ACTIVE; ++p) {
+        QF_active_[p] = (QActive *)0;
+    }
+    QF_readySet_   = (uint32_t)0;
+    QF_subscrList_ = (QSubscrList *)0;
+    QF_maxSignal_  = (enum_t)0;
+    QF_maxPool_    = (uint_fast8_t)0;
+
+#ifdef QF_HOST
+    Q_ALLEGE_ID(100, sem_init(&l_wakeSem, 0, 0U) == 0);
+    __atomic_store_n(&l_running, true, __ATOMIC_RELEASE);
+#endif
+}
+
+#ifdef QF_HOST
+/****************************************************************************/
+void QF_wake_(void) {
+    (void)sem_post(&l_wakeSem);
+}
+#endif
+
+/****************************************************************************/
+/**
+* \description
+* Runs one run-to-completion step of the highest-priority active object
+* with a non-empty event queue: takes one event out of its queue,
+* dispatches it to the state machine and garbage-collects it.
+*
+* \returns 'true' if an event was processed or something might still be
+* ready, 'false' if all event queues were found empty.
+*
+* \note On the Pebble the QF scheduler does not own the main loop. The app
+* or worker calls QF_runOne() (or QF_run(), which drains all the queues)
+* from its callbacks after posting events.
+*/
+bool QF_runOne(void) {
+    uint32_t rs;
+    QActive *a;
+    QEvt const *e;
+    QF_CRIT_STAT_
+
+    QF_CRIT_ENTRY_();
+    rs = QF_BITS_GET_(&QF_readySet_);
+    QF_CRIT_EXIT_();
+
+    if (rs == (uint32_t)0) {
+        return false;
+    }
+
+    a = QF_active_[QF_LOG2_(rs)];   /* the highest-priority ready AO */
+
+    /* the ready active object must be registered with QF */
+    Q_ASSERT_ID(200, a != (QActive *)0);
+
+    e = QActive_get_(a);
+    if (e != (QEvt const *)0) {
+        QMSM_DISPATCH(&a->super, e); /* dispatch to the state machine */
+        QF_gc(e);                    /* recycle the event if not used */
+    }
+    return true;
+}
+
+/****************************************************************************/
+/**
+* \description
+* On the host, QF_run() is the body of the scheduler thread: it processes
+* events in priority order and sleeps while all event queues are empty,
+* until QF_stop() is called. QF_init() arms it, so a QF_stop() issued
+* before QF_run() starts makes it return at once. On the target, QF_run()
+* processes events until all event queues are empty and returns.
+*
+* \returns 0 on normal return
+*/
+int_t QF_run(void) {
+#ifdef QF_HOST
+    while (__atomic_load_n(&l_running, __ATOMIC_ACQUIRE)) {
+        if (!QF_runOne()) {
+            (void)sem_wait(&l_wakeSem);  /* nothing ready, go to sleep */
+        }
+    }
+#else
+    while (QF_runOne()) {
+    }
+#endif
+    return (int_t)0;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Makes QF_run() return after the current run-to-completion step, or
+* right away if it has not started yet. QF_run() keeps returning until the
+* next QF_init(). Applies to the host only, on the target QF_run() returns
+* on its own.
+*/
+void QF_stop(void) {
+#ifdef QF_HOST
+    __atomic_store_n(&l_running, false, __ATOMIC_RELEASE);
+    QF_wake_();
+#endif
+}
@@ -0,0 +1,147 @@
+/**
+* \file
+* \brief QFsm_dispatchN() definition
+* \ingroup qep
+* \cond
+******************************************************************************
+* Product: QEP/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#include "qep_port.h"     /* QEP port */
+#include "qep_pkg.h"
+#ifdef Q_SPY              /* QS software tracing enabled? */
+    #include "qs_port.h"  /* include QS port */
+#else
+    #include "qs_dummy.h" /* disable the QS software tracing */
+#endif /* Q_SPY */
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qfsm_dsn")
+
+/****************************************************************************/
+/**
+* \description
+* Dispatches a run of \a n events to a non-hierarchical ("flat") state
+* machine (FSM), one run-to-completion (RTC) step per event. The events are
+* laid out \a stride bytes apart starting at \a events, so an array of any
+* event structure derived from ::QEvt (such as a block of accelerometer
+* samples) can be dispatched in place.
+*
+* \arguments
+* \arg[in,out] \c me     pointer (see \ref derivation)
+* \arg[in]     \c events pointer to the first event to be dispatched
+* \arg[in]     \c n      number of events to dispatch
+* \arg[in]     \c stride distance in bytes between consecutive events
+*
+* \note
+* The observable behavior, including the QS trace records, is identical to
+* calling QFsm_dispatch_() \a n times. The stable-state precondition is
+* checked only once for the whole run, because every RTC step below leaves
+* the FSM in a stable state again. The common case of an internal
+* transition (::Q_RET_HANDLED) is tested first and only a state change
+* drops into the full transition handling.
+*/
+void QFsm_dispatchN(QFsm * const me, QEvt const * const events,
+                    uint_fast16_t n, uint_fast16_t stride)
+{
+    uint8_t const *evt = (uint8_t const *)events;
+    QState r;
+    QS_CRIT_STAT_
+
+    /** \pre the FSM must be in a stable state configuration and
+    * consecutive events must not overlap
+    */
+    Q_REQUIRE_ID(100, (me->state.fun == me->temp.fun)
+                      && ((n <= (uint_fast16_t)1)
+                          || (stride >= (uint_fast16_t)sizeof(QEvt))));
+
+    for (; n != (uint_fast16_t)0; --n, evt += stride) {
+        QEvt const * const e = (QEvt const *)evt;
+
+        QS_BEGIN_(QS_QEP_DISPATCH, QS_priv_.smObjFilter, me)
+            QS_TIME_();                 /* time stamp */
+            QS_SIG_(e->sig);            /* the signal of the event */
+            QS_OBJ_(me);                /* this state machine object */
+            QS_FUN_(me->state.fun);     /* the current state */
+        QS_END_()
+
+        r = (*me->state.fun)(me, e);    /* call the event handler */
+
+        /* fast path: internal transition, the state does not change */
+        if (r == (QState)Q_RET_HANDLED) {
+
+            QS_BEGIN_(QS_QEP_INTERN_TRAN, QS_priv_.smObjFilter, me)
+                QS_TIME_();             /* time stamp */
+                QS_SIG_(e->sig);        /* the signal of the event */
+                QS_OBJ_(me);            /* this state machine object */
+                QS_FUN_(me->state.fun); /* the current state */
+            QS_END_()
+
+        }
+        else if (r == (QState)Q_RET_TRAN) { /* transition taken? */
+
+            QS_BEGIN_(QS_QEP_TRAN, QS_priv_.smObjFilter, me)
+                QS_TIME_();             /* time stamp */
+                QS_SIG_(e->sig);        /* the signal of the event */
+                QS_OBJ_(me);            /* this state machine object */
+                QS_FUN_(me->state.fun); /* the source of the transition */
+                QS_FUN_(me->temp.fun);  /* the target of the transition */
+            QS_END_()
+
+            QEP_EXIT_(me->state.fun);   /* exit the source */
+            QEP_ENTER_(me->temp.fun);   /* enter the target */
+            me->state.fun = me->temp.fun; /* record the new active state */
+        }
+        else { /* event not handled */
+#ifdef Q_SPY
+
+            if (r == (QState)Q_RET_UNHANDLED) {
+                QS_BEGIN_(QS_QEP_UNHANDLED, QS_priv_.smObjFilter, me)
+                    QS_SIG_(e->sig);    /* the signal of the event */
+                    QS_OBJ_(me);        /* this state machine object */
+                    QS_FUN_(me->state.fun); /* the current state */
+                QS_END_()
+            }
+
+            QS_BEGIN_(QS_QEP_IGNORED, QS_priv_.smObjFilter, me)
+                QS_TIME_();             /* time stamp */
+                QS_SIG_(e->sig);        /* the signal of the event */
+                QS_OBJ_(me);            /* this state machine object */
+                QS_FUN_(me->state.fun); /* the current state */
+            QS_END_()
+
+#endif /* Q_SPY */
+        }
+    }
+}
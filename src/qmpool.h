@@ -0,0 +1,105 @@
+/**
+* \file
+* \brief QP native, platform-independent memory pool ::QMPool interface.
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QF/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qmpool_h
+#define qmpool_h
+
+/****************************************************************************/
+/*! The size of a memory block in bytes */
+typedef uint16_t QMPoolSize;
+
+/*! The number of blocks in a memory pool */
+typedef uint16_t QMPoolCtr;
+
+/*! Native QF Memory Pool */
+/**
+* \description
+* A fixed block-size memory pool is a very fast and efficient data
+* structure for dynamic allocation of fixed block-size chunks of memory.
+* A memory pool offers fast and deterministic allocation and recycling of
+* memory blocks and is not subject to fragmenation.
+*
+* The free blocks are kept in a singly-linked free list (a stack) threaded
+* through the blocks themselves, so both QMPool_get() and QMPool_put() are
+* O(1). On the host (QF_HOST) the free list is a lock-free Treiber stack:
+* the links are block indices and the top of the stack is a 64-bit word
+* holding the index of the top block together with a tag that changes with
+* every push and pop, so a compare-and-swap cannot succeed on a stale top
+* (the ABA problem). On the target the free list is a plain pointer list
+* protected by the QF critical section.
+*
+* \note QMPool is used by QF to manage the event pools, but the application
+* can also use it directly for its own fixed-size blocks.
+*/
+typedef struct {
+#ifdef QF_HOST
+    uint64_t volatile top;   /*!< tag:32 | (index of the free top + 1):32 */
+#else
+    void *free_head;         /*!< head of the linked list of free blocks */
+#endif
+    void *start;             /*!< start of the pool storage */
+    QMPoolSize blockSize;    /*!< block size (in bytes, rounded up) */
+    QMPoolCtr nTot;          /*!< total number of blocks */
+    QMPoolCtr volatile nFree;/*!< number of free blocks remaining */
+    QMPoolCtr nMin;          /*!< low watermark of free blocks */
+    uint32_t volatile nFail; /*!< number of failed allocations */
+} QMPool;
+
+/*! Memory pool element to allocate correctly aligned storage for
+* ::QMPool class.
+*/
+/**
+* \arguments
+* \arg[in] \c evType_ event type (name of the subclass of ::QEvt)
+*/
+#define QF_MPOOL_EL(evType_) \
+    struct { void *sto_[((sizeof(evType_) - 1U)/sizeof(void*)) + 1U]; }
+
+/*! Initializes the native QF memory pool */
+void QMPool_init(QMPool * const me, void * const poolSto,
+                 uint_fast32_t poolSize, uint_fast16_t blockSize);
+
+/*! Obtains a memory block from a memory pool. */
+void *QMPool_get(QMPool * const me, uint_fast16_t const margin);
+
+/*! Recycles a memory block back to a memory pool. */
+void QMPool_put(QMPool * const me, void *b);
+
+#endif /* qmpool_h */
@@ -0,0 +1,232 @@
+/**
+* \file
+* \brief QS/C binary trace buffer and filters
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QS/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifdef Q_SPY /* the whole module is built only with QS tracing enabled */
+
+#include "qs_port.h"      /* QS port */
+#include "qassert.h"
+
+Q_DEFINE_THIS_MODULE("qs")
+
+/*
+* Layout of the trace: the RAM ring buffer holds a sequence of records,
+* each one starting with a two-byte header
+*
+*     [length] [record type] [payload ...]
+*
+* where 'length' is the total number of bytes of the record, header
+* included. The payload is written in little endian and its layout is
+* fixed by the record type (see qs.h), so there is no escaping or framing
+* overhead. When the buffer is full, the oldest whole records are dropped
+* to make room for the new ones.
+*
+* QS_initBuf() opens the trace with a #QS_EMPTY session record whose
+* payload gives the sizes of the variable fields in this build
+*
+*     [signal size] [time stamp size] [object ptr size] [function ptr size]
+*
+* so the decoder reads any dump that still starts with it without being
+* told how the target was built.
+*/
+
+/****************************************************************************/
+QSPriv QS_priv_;  /* QS private data */
+
+/****************************************************************************/
+/**
+* \description
+* Initializes the QS trace buffer, enables all the QEP records and writes
+* the session record. The buffer must be a power of two in size and hold
+* at least a few records.
+*
+* \arguments
+* \arg[in] \c sto     pointer to the storage for the ring buffer
+* \arg[in] \c stoSize the size of the storage in bytes
+*/
+void QS_initBuf(uint8_t * const sto, uint_fast32_t const stoSize) {
+    /** \pre the buffer size must be a power of two and much larger than
+    * the largest record
+    */
+    Q_REQUIRE_ID(100, ((stoSize & (stoSize - 1U)) == 0U)
+                      && (stoSize >= (uint_fast32_t)(4U * QS_REC_MAX)));
+
+    QS_priv_.buf         = sto;
+    QS_priv_.mask        = (QSCtr)stoSize - 1U;
+    QS_priv_.head        = 0U;
+    QS_priv_.tail        = 0U;
+    QS_priv_.recStart    = 0U;
+    QS_priv_.dropped     = 0U;
+    QS_priv_.smObjFilter = (void const *)0;
+    QS_priv_.lock        = false;
+
+    QS_filterOff(QS_ALL_RECORDS);
+    QS_filterOn(QS_QEP_STATE_ENTRY);
+    QS_filterOn(QS_QEP_STATE_EXIT);
+    QS_filterOn(QS_QEP_STATE_INIT);
+    QS_filterOn(QS_QEP_INIT_TRAN);
+    QS_filterOn(QS_QEP_INTERN_TRAN);
+    QS_filterOn(QS_QEP_TRAN);
+    QS_filterOn(QS_QEP_IGNORED);
+    QS_filterOn(QS_QEP_DISPATCH);
+    QS_filterOn(QS_QEP_UNHANDLED);
+
+    QS_beginRec_((uint_fast8_t)QS_EMPTY);
+    QS_PAYLOAD_BEGIN_()
+        QS_U8_(Q_SIGNAL_SIZE);
+        QS_U8_(QS_TIME_SIZE);
+        QS_U8_(QS_OBJ_PTR_SIZE);
+        QS_U8_(QS_FUN_PTR_SIZE);
+    QS_PAYLOAD_END_()
+    QS_endRec_();
+}
+
+/****************************************************************************/
+/**
+* \description
+* Enables the record type \a rec, or all record types for #QS_ALL_RECORDS.
+*/
+void QS_filterOn(uint_fast8_t const rec) {
+    uint_fast8_t i;
+    if (rec == QS_ALL_RECORDS) {
+        for (i = (uint_fast8_t)0; i < (uint_fast8_t)Q_DIM(QS_priv_.glbFilter);
+             ++i)
+        {
+            QS_priv_.glbFilter[i] = (uint8_t)0xFF;
+        }
+    }
+    else {
+        QS_priv_.glbFilter[rec >> 3] |= (uint8_t)(1U << (rec & 7U));
+    }
+}
+
+/****************************************************************************/
+/**
+* \description
+* Disables the record type \a rec, or all record types for #QS_ALL_RECORDS.
+*/
+void QS_filterOff(uint_fast8_t const rec) {
+    uint_fast8_t i;
+    if (rec == QS_ALL_RECORDS) {
+        for (i = (uint_fast8_t)0; i < (uint_fast8_t)Q_DIM(QS_priv_.glbFilter);
+             ++i)
+        {
+            QS_priv_.glbFilter[i] = (uint8_t)0;
+        }
+    }
+    else {
+        QS_priv_.glbFilter[rec >> 3] &= (uint8_t)(~(1U << (rec & 7U)));
+    }
+}
+
+/****************************************************************************/
+/**
+* \description
+* Starts a new record of type \a rec. Reserves #QS_REC_MAX bytes of room by
+* dropping the oldest records, so the payload macros are plain stores.
+*/
+void QS_beginRec_(uint_fast8_t const rec) {
+    QSCtr const head = QS_priv_.head;
+
+    while ((head - QS_priv_.tail) > (QS_priv_.mask + 1U - QS_REC_MAX)) {
+        QS_priv_.tail += (QSCtr)QS_priv_.buf[QS_priv_.tail & QS_priv_.mask];
+        ++QS_priv_.dropped;
+    }
+    QS_priv_.recStart = head;
+    /* leave room for the length, then the record type */
+    QS_priv_.buf[(head + 1U) & QS_priv_.mask] = (uint8_t)rec;
+    QS_priv_.head = head + 2U;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Completes the current record by writing its length into the header.
+*/
+void QS_endRec_(void) {
+    QSCtr len = QS_priv_.head - QS_priv_.recStart;
+
+    /* the record must not exceed the room reserved for it */
+    Q_ASSERT_ID(200, len <= (QSCtr)QS_REC_MAX);
+
+    QS_priv_.buf[QS_priv_.recStart & QS_priv_.mask] = (uint8_t)len;
+}
+
+/****************************************************************************/
+/**
+* \description
+* Copies the oldest complete records into \a dst, as many as fit in
+* \a size bytes, and removes them from the trace buffer. The copied bytes
+* can be sent to the host (or appended to a file) and fed to the decoder
+* tool as they are.
+*
+* \returns the number of bytes copied
+*/
+uint_fast16_t QS_drain(uint8_t * const dst, uint_fast16_t const size) {
+    uint_fast16_t n = (uint_fast16_t)0;
+    QSCtr len;
+    QSCtr tail;
+    QS_CRIT_STAT_
+
+    QS_CRIT_ENTRY_();
+    {
+        /* the stores into dst may alias QS_priv_, see QS_PAYLOAD_BEGIN_() */
+        uint8_t const * const buf = QS_priv_.buf;
+        QSCtr const mask = QS_priv_.mask;
+        QSCtr const head = QS_priv_.head;
+
+        tail = QS_priv_.tail;
+        while (tail != head) {
+            len = (QSCtr)buf[tail & mask];
+            if ((n + len) > size) {
+                break;
+            }
+            for (; len != 0U; --len) {
+                dst[n] = buf[tail & mask];
+                ++n;
+                ++tail;
+            }
+        }
+        QS_priv_.tail = tail;
+    }
+    QS_CRIT_EXIT_();
+    return n;
+}
+
+#endif /* Q_SPY */
@@ -0,0 +1,301 @@
+/**
+* \file
+* \brief QS/C platform-independent public interface (binary software tracing).
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QS/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qs_h
+#define qs_h
+
+#ifndef Q_SPY
+    #error "Q_SPY must be defined to include qs.h"
+#endif
+
+/****************************************************************************/
+/*! Quantum Spy record types. */
+/**
+* \description
+* The numeric values of the QEP records follow the QS protocol of QP 5.3,
+* so the record IDs stay stable for the host decoder. Application-specific
+* records start at #QS_USER.
+*/
+enum QSpyRecords {
+    QS_EMPTY,                 /*!< session record, sizes of the fields */
+
+    /* [1] QEP records */
+    QS_QEP_STATE_ENTRY,       /*!< a state was entered */
+    QS_QEP_STATE_EXIT,        /*!< a state was exited */
+    QS_QEP_STATE_INIT,        /*!< an initial transition was taken in a state */
+    QS_QEP_INIT_TRAN,         /*!< the top-most initial transition was taken */
+    QS_QEP_INTERN_TRAN,       /*!< an internal transition was taken */
+    QS_QEP_TRAN,              /*!< a regular transition was taken */
+    QS_QEP_IGNORED,           /*!< an event was ignored (silently discarded) */
+    QS_QEP_DISPATCH,          /*!< an event was dispatched (begin of RTC step) */
+    QS_QEP_UNHANDLED,         /*!< an event was unhandled due to a guard */
+
+    /* [70] application-specific records */
+    QS_USER = 70              /*!< the first record available to QS users */
+};
+
+/*! Specification of all QS records for the QS_FILTER_ON() and
+* QS_FILTER_OFF()
+*/
+#define QS_ALL_RECORDS          ((uint_fast8_t)0xFF)
+
+/*! Largest number of bytes in a single QS record, header included. */
+/**
+* \description
+* Before a record is started QS makes room for this many bytes by dropping
+* the oldest records, so the payload can be written without any further
+* checks.
+*/
+#ifndef QS_REC_MAX
+    #define QS_REC_MAX          64U
+#endif
+#if (QS_REC_MAX > 255U)
+    #error "QS_REC_MAX must fit the one-byte record length"
+#endif
+
+/*! The type of the QS time stamp. */
+#if (QS_TIME_SIZE == 2)
+    typedef uint16_t QSTimeCtr;
+#elif (QS_TIME_SIZE == 4)
+    typedef uint32_t QSTimeCtr;
+#else
+    #error "QS_TIME_SIZE defined incorrectly, expected 2 or 4"
+#endif
+
+/*! QS ring buffer counter type (free running, wraps modulo 2^32) */
+typedef uint32_t QSCtr;
+
+/*! Private QS attributes to keep track of the filters and the trace
+* buffer.
+*/
+typedef struct {
+    uint8_t glbFilter[32];    /*!< global on/off filter, one bit per record */
+    void const *smObjFilter;  /*!< state machine for QEP records, NULL: all */
+    uint8_t *buf;             /*!< pointer to the start of the ring buffer */
+    QSCtr mask;               /*!< size of the ring buffer - 1 */
+    QSCtr head;               /*!< offset of the next byte to write */
+    QSCtr tail;               /*!< offset of the oldest record */
+    QSCtr recStart;           /*!< offset of the record being written */
+    uint32_t dropped;         /*!< number of records overwritten */
+    bool volatile lock;       /*!< QS critical section (host only) */
+} QSPriv;
+
+extern QSPriv QS_priv_;
+
+/****************************************************************************/
+/* QS API used by the application */
+
+/*! Initialize the QS trace buffer with the storage \a sto of \a stoSize
+* bytes (a power of two).
+*/
+void QS_initBuf(uint8_t * const sto, uint_fast32_t const stoSize);
+
+/*! Turn the global filter on for a given record type \a rec. */
+void QS_filterOn(uint_fast8_t const rec);
+
+/*! Turn the global filter off for a given record type \a rec. */
+void QS_filterOff(uint_fast8_t const rec);
+
+/*! Copy out and consume whole trace records, oldest first. */
+uint_fast16_t QS_drain(uint8_t * const dst, uint_fast16_t const size);
+
+/*! Callback to obtain the 32-bit time stamp of trace records. */
+/**
+* \description
+* Defined in the application, for example as milliseconds from time_ms()
+* on the Pebble, or as a cycle or nanosecond counter on the host. The
+* decoder reports durations in the same unit.
+*/
+QSTimeCtr QS_onGetTime(void);
+
+#define QS_INIT(sto_, size_)    (QS_initBuf((sto_), (size_)), true)
+#define QS_EXIT()               ((void)0)
+#define QS_FILTER_ON(rec_)      QS_filterOn((uint_fast8_t)(rec_))
+#define QS_FILTER_OFF(rec_)     QS_filterOff((uint_fast8_t)(rec_))
+#define QS_FILTER_SM_OBJ(obj_)  (QS_priv_.smObjFilter = (obj_))
+#define QS_FILTER_AO_OBJ(obj_)  ((void)0)
+#define QS_FILTER_MP_OBJ(obj_)  ((void)0)
+#define QS_FILTER_EQ_OBJ(obj_)  ((void)0)
+#define QS_FILTER_TE_OBJ(obj_)  ((void)0)
+#define QS_FILTER_AP_OBJ(obj_)  ((void)0)
+
+/*! Begin an application-specific QS record \a rec_ filtered by \a obj_ */
+#define QS_BEGIN(rec_, obj_) \
+    QS_BEGIN_((rec_), QS_priv_.smObjFilter, (obj_))
+
+/*! End an application-specific QS record */
+#define QS_END()                QS_END_()
+
+/* formatted data items of application-specific records */
+enum {
+    QS_I8_T, QS_U8_T, QS_I16_T, QS_U16_T, QS_I32_T, QS_U32_T
+};
+#define QS_I8(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_I8_T), QS_U8_(data_))
+#define QS_U8(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_U8_T), QS_U8_(data_))
+#define QS_I16(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_I16_T), QS_U16_(data_))
+#define QS_U16(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_U16_T), QS_U16_(data_))
+#define QS_I32(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_I32_T), QS_U32_(data_))
+#define QS_U32(width_, data_) \
+    (QS_U8_(((uint8_t)(width_) << 4) | QS_U32_T), QS_U32_(data_))
+
+/****************************************************************************/
+/* internal QS macros used only in the QP components */
+
+/*! Test of the global filter for the record \a rec_ */
+#define QS_GLB_FILTER_(rec_) \
+    ((QS_priv_.glbFilter[(uint_fast8_t)(rec_) >> 3] \
+      & (uint8_t)(1U << ((uint_fast8_t)(rec_) & 7U))) != (uint8_t)0)
+
+/*! Begin a QS record, which is written only if the record type passes the
+* global filter and \a obj_ passes the object filter \a objFilter_
+*/
+#define QS_BEGIN_(rec_, objFilter_, obj_) \
+    if (QS_GLB_FILTER_(rec_) \
+        && (((objFilter_) == (void const *)0) \
+            || ((objFilter_) == (void const *)(obj_)))) \
+    { \
+        QS_CRIT_ENTRY_(); \
+        QS_beginRec_((uint_fast8_t)(rec_)); \
+        QS_PAYLOAD_BEGIN_()
+
+/*! End a QS record */
+#define QS_END_() \
+        QS_PAYLOAD_END_() \
+        QS_endRec_(); \
+        QS_CRIT_EXIT_(); \
+    }
+
+#define QS_BEGIN_NOCRIT_(rec_, objFilter_, obj_) \
+    if (QS_GLB_FILTER_(rec_) \
+        && (((objFilter_) == (void const *)0) \
+            || ((objFilter_) == (void const *)(obj_)))) \
+    { \
+        QS_beginRec_((uint_fast8_t)(rec_)); \
+        QS_PAYLOAD_BEGIN_()
+
+#define QS_END_NOCRIT_() \
+        QS_PAYLOAD_END_() \
+        QS_endRec_(); \
+    }
+
+/*! Open the payload of a record. The byte stores go through a uint8_t
+* pointer, which may alias QS_priv_, so the compiler would reload head,
+* buf and mask from memory for every byte. They are read into locals once
+* per record instead and head is written back by QS_PAYLOAD_END_().
+*/
+#define QS_PAYLOAD_BEGIN_() { \
+    uint8_t * const qsBuf_ = QS_priv_.buf; \
+    QSCtr const qsMask_ = QS_priv_.mask; \
+    QSCtr qsHead_ = QS_priv_.head;
+
+/*! Close the payload of a record opened by QS_PAYLOAD_BEGIN_() */
+#define QS_PAYLOAD_END_() \
+    QS_priv_.head = qsHead_; \
+}
+
+/*! Output one byte into the ring buffer (room reserved by QS_beginRec_),
+* only between QS_PAYLOAD_BEGIN_() and QS_PAYLOAD_END_()
+*/
+#define QS_U8_(data_) \
+    (qsBuf_[qsHead_++ & qsMask_] = (uint8_t)(data_))
+
+/*! Output two bytes, little endian */
+#define QS_U16_(data_) \
+    (QS_U8_(data_), QS_U8_((uint16_t)(data_) >> 8))
+
+/*! Output four bytes, little endian */
+#define QS_U32_(data_) \
+    (QS_U16_(data_), QS_U16_((uint32_t)(data_) >> 16))
+
+#define QS_2U8_(data1_, data2_) (QS_U8_(data1_), QS_U8_(data2_))
+
+/* the byte macros evaluate their argument once per byte, so the time stamp
+* is read once into a local first
+*/
+#if (QS_TIME_SIZE == 2)
+    #define QS_TIME_() do { \
+        QSTimeCtr const t_ = QS_onGetTime(); \
+        QS_U16_(t_); \
+    } while (0)
+#else
+    #define QS_TIME_() do { \
+        QSTimeCtr const t_ = QS_onGetTime(); \
+        QS_U32_(t_); \
+    } while (0)
+#endif
+
+#if (Q_SIGNAL_SIZE == 1)
+    #define QS_SIG_(sig_)       QS_U8_(sig_)
+#elif (Q_SIGNAL_SIZE == 2)
+    #define QS_SIG_(sig_)       QS_U16_(sig_)
+#else
+    #define QS_SIG_(sig_)       QS_U32_(sig_)
+#endif
+
+#if (QS_OBJ_PTR_SIZE == 4)
+    #define QS_OBJ_(obj_)       QS_U32_((uintptr_t)(obj_))
+#else
+    #define QS_OBJ_(obj_) \
+        (QS_U32_((uintptr_t)(obj_)), \
+         QS_U32_((uint64_t)(uintptr_t)(obj_) >> 32))
+#endif
+
+#if (QS_FUN_PTR_SIZE == 4)
+    #define QS_FUN_(fun_)       QS_U32_((uintptr_t)(fun_))
+#else
+    #define QS_FUN_(fun_) \
+        (QS_U32_((uintptr_t)(fun_)), \
+         QS_U32_((uint64_t)(uintptr_t)(fun_) >> 32))
+#endif
+
+/*! Internal QS function to begin a record, called inside the QS critical
+* section
+*/
+void QS_beginRec_(uint_fast8_t const rec);
+
+/*! Internal QS function to end a record */
+void QS_endRec_(void);
+
+#endif /* qs_h */
@@ -0,0 +1,79 @@
+/**
+* \file
+* \brief QS/C port to the Pebble target and to the POSIX host
+* \ingroup qf
+* \cond
+******************************************************************************
+* Product: QS/C
+* Last updated for version 5.3.1
+* Last updated on  2014-09-18
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, www.state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* Web:   www.state-machine.com
+* Email: info@state-machine.com
+******************************************************************************
+* \endcond
+*/
+#ifndef qs_port_h
+#define qs_port_h
+
+/*! QS time stamp size in bytes */
+#define QS_TIME_SIZE        4
+
+#ifdef QF_HOST
+    /*! object pointer size in bytes */
+    #define QS_OBJ_PTR_SIZE 8
+
+    /*! function pointer size in bytes */
+    #define QS_FUN_PTR_SIZE 8
+
+    /* QS records can be produced by several threads on the host, so the
+    * QS critical section is a spin lock held only while a record is
+    * written into the buffer
+    */
+    #define QS_CRIT_STAT_
+    #define QS_CRIT_ENTRY_() \
+        while (__atomic_test_and_set(&QS_priv_.lock, __ATOMIC_ACQUIRE)) { }
+    #define QS_CRIT_EXIT_() \
+        __atomic_clear(&QS_priv_.lock, __ATOMIC_RELEASE)
+
+#else /* Pebble target, Cortex-M3 */
+    #define QS_OBJ_PTR_SIZE 4
+    #define QS_FUN_PTR_SIZE 4
+
+    /* all QS records are produced on the single app (or worker) task */
+    #ifndef QS_CRIT_ENTRY_
+        #define QS_CRIT_STAT_
+        #define QS_CRIT_ENTRY_()    ((void)0)
+        #define QS_CRIT_EXIT_()     ((void)0)
+    #endif
+#endif /* QF_HOST */
+
+#include "qep_port.h" /* QEP port */
+#include "qs.h"       /* QS platform-independent public interface */
+
+#endif /* qs_port_h */
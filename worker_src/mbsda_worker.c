@@ -0,0 +1,277 @@
+#include <pebble_worker.h>
+#include "../src/qf_port.h"
+#include "../src/AlgMbsda.h"
+#include "../src/AlgMbsdaRate.h"
+#include "../src/mbsda_msg.h"
+
+// The worker owns the accelerometer and the MBSDA state machine, so
+// detection keeps running when the foreground app closes. The accelerometer
+// runs at the rate the state machine asks for: the MBSDA input rate of the
+// build's rate profile, or MBSDA_LOW_HZ while activity is low. Samples come
+// in batches of up to a second, at most the 25 the service buffers. The
+// accel handler posts each batch to the worker active object and runs QF,
+// which dispatches the batch to the state machine in one run; only state
+// changes and periodic feature summaries go to the app.
+#define WORKER_SAMPLES_PER_UPDATE (MBSDA_INPUT_HZ < 25 ? MBSDA_INPUT_HZ : 25)
+#define WORKER_BATCH(hz) ((hz) < WORKER_SAMPLES_PER_UPDATE ? (hz) : WORKER_SAMPLES_PER_UPDATE)
+
+// The state machine is checkpointed to persistent storage every
+// WORKER_CKPT_PERIOD_S and on a clean exit, in values of at most
+// PERSIST_DATA_MAX_LENGTH from WORKER_CKPT_KEY up. A restarted worker
+// resumes from it, skipping the start-up delay, if it was taken less than
+// WORKER_CKPT_MAX_AGE_MS before the first new sample.
+#define WORKER_CKPT_KEY 0x4d420000
+#define WORKER_CKPT_KEYS 5
+#define WORKER_CKPT_PERIOD_S 60
+#define WORKER_CKPT_MAX_AGE_MS (2 * WORKER_CKPT_PERIOD_S * 1000)
+
+enum {
+  XL_BATCH_SIG = MBSDA_MAX_SIG,
+};
+
+// One batch of samples. The handler fills it and QF_run() has dispatched
+// it before the handler returns, so a single static event is enough.
+typedef struct {
+  QEvt super;
+  uint16_t n;
+  uint32_t now_s;
+  XlDataEvt samples[WORKER_SAMPLES_PER_UPDATE];
+} XlBatchEvt;
+
+// The worker active object. It waits for the first batch to decide
+// whether to resume from the checkpoint, then feeds the state machine.
+typedef struct {
+  QActive super;
+} Worker;
+
+static QState worker_initial(Worker * const me, QEvt const * const e);
+static QState worker_waiting(Worker * const me, QEvt const * const e);
+static QState worker_running(Worker * const me, QEvt const * const e);
+
+static Worker s_worker;
+
+static QEQueueSlot s_worker_queue[2];
+
+static XlBatchEvt s_batch;
+
+static MbsdaSummary s_sent;
+
+static uint16_t s_rate_hz;
+
+static uint32_t s_start_s;
+
+static uint32_t s_ckpt_s;
+
+static uint32_t s_period_start_s;
+
+static uint32_t s_stda_sum;
+
+static uint16_t s_stda_max;
+
+static uint32_t s_stda_count;
+
+static uint32_t s_freq_sum;
+
+static uint32_t s_band_sum;
+
+static uint16_t s_band_max;
+
+void Q_onAssert(char_t const Q_ROM * const file, int_t line) {
+  APP_LOG(APP_LOG_LEVEL_ERROR, "assert %s:%d", file, (int)line);
+  // The state machine cannot be trusted past this point, stop the worker
+  __builtin_trap();
+}
+
+static void send_message(uint8_t type, uint16_t data0, uint16_t data1, uint16_t data2) {
+  AppWorkerMessage msg = {
+    .data0 = data0,
+    .data1 = data1,
+    .data2 = data2,
+  };
+  app_worker_send_message(type, &msg);
+}
+
+static void set_rate(uint16_t hz) {
+  accel_service_set_sampling_rate((AccelSamplingRate)hz);
+  accel_service_set_samples_per_update(WORKER_BATCH(hz));
+  s_rate_hz = hz;
+}
+
+static void ckpt_save(void) {
+  struct MbsdaTag const *me = (struct MbsdaTag const *)FSM_Mbsda;
+  uint8_t buf[PERSIST_DATA_MAX_LENGTH];
+  uint32_t key = WORKER_CKPT_KEY;
+  uint16_t offset = 0;
+  uint16_t n;
+  MbsdaSummary sum;
+
+  // Start-up checkpoints are not restored, keep the last good one
+  Mbsda_getSummary(me, &sum);
+  if (sum.state == MBSDA_STATE_STARTUP
+    || Mbsda_save(me, NULL, 0, 0) > WORKER_CKPT_KEYS * PERSIST_DATA_MAX_LENGTH) {
+    return;
+  }
+  while ((n = Mbsda_save(me, buf, offset, sizeof(buf))) != 0) {
+    persist_write_data(key++, buf, n);
+    offset += n;
+  }
+  // A longer checkpoint of another build may have left values behind
+  while (key < WORKER_CKPT_KEY + WORKER_CKPT_KEYS && persist_exists(key)) {
+    persist_delete(key++);
+  }
+}
+
+static void ckpt_restore(uint32_t now) {
+  uint8_t *blob = malloc(WORKER_CKPT_KEYS * PERSIST_DATA_MAX_LENGTH);
+  uint16_t len = 0;
+
+  if (!blob) {
+    return;
+  }
+  for (uint32_t key = WORKER_CKPT_KEY; key < WORKER_CKPT_KEY + WORKER_CKPT_KEYS; key++) {
+    const int n = persist_read_data(key, blob + len, PERSIST_DATA_MAX_LENGTH);
+    if (n <= 0) {
+      break;
+    }
+    len += n;
+    if (n < PERSIST_DATA_MAX_LENGTH) {
+      break;
+    }
+  }
+  if (len && Mbsda_restore((struct MbsdaTag *)FSM_Mbsda, blob, len, now, WORKER_CKPT_MAX_AGE_MS)) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "resumed from a %u byte checkpoint", len);
+  }
+  free(blob);
+}
+
+static void report(uint32_t now_s) {
+  MbsdaSummary sum;
+  Mbsda_getSummary((struct MbsdaTag const *)FSM_Mbsda, &sum);
+
+  // The state machine picks the rate in its entry actions
+  if (sum.xlRateHz != s_rate_hz) {
+    set_rate(sum.xlRateHz);
+  }
+
+  if (sum.state != s_sent.state || sum.szFlags != s_sent.szFlags) {
+    send_message(MBSDA_MSG_STATE, sum.state, sum.szFlags, (now_s - s_start_s) / 60);
+    s_sent = sum;
+  }
+
+  s_stda_sum += sum.stdaXyz;
+  s_stda_count++;
+  if (sum.stdaXyz > s_stda_max) {
+    s_stda_max = sum.stdaXyz;
+  }
+  s_freq_sum += sum.domFreq;
+  s_band_sum += sum.bandRatio;
+  if (sum.bandRatio > s_band_max) {
+    s_band_max = sum.bandRatio;
+  }
+  if (now_s - s_period_start_s >= MBSDA_MSG_FEATURE_PERIOD_S) {
+    send_message(MBSDA_MSG_FEATURES, s_stda_sum / s_stda_count, s_stda_max, (uint16_t)sum.mTpkR);
+    send_message(MBSDA_MSG_SPECTRUM, s_freq_sum / s_stda_count, s_band_sum / s_stda_count, s_band_max);
+    s_period_start_s = now_s;
+    s_stda_sum = 0;
+    s_stda_max = 0;
+    s_stda_count = 0;
+    s_freq_sum = 0;
+    s_band_sum = 0;
+    s_band_max = 0;
+  }
+
+  if (now_s - s_ckpt_s >= WORKER_CKPT_PERIOD_S) {
+    ckpt_save();
+    s_ckpt_s = now_s;
+  }
+}
+
+static QState worker_initial(Worker * const me, QEvt const * const e) {
+  (void)me;
+  (void)e;
+  return Q_TRAN(&worker_waiting);
+}
+
+static QState worker_waiting(Worker * const me, QEvt const * const e) {
+  XlBatchEvt const *be = (XlBatchEvt const *)e;
+
+  switch (e->sig) {
+    case XL_BATCH_SIG:
+      if (be->n == 0) {
+        return Q_HANDLED();
+      }
+      // Resume where the last run left off, if that was recent enough
+      ckpt_restore(be->samples[0].timeStamp);
+      QMSM_INIT(FSM_Mbsda, (QEvt *)0);
+      // The first batch goes to the state machine as well
+      worker_running(me, e);
+      return Q_TRAN(&worker_running);
+  }
+  return Q_IGNORED();
+}
+
+static QState worker_running(Worker * const me, QEvt const * const e) {
+  XlBatchEvt const *be = (XlBatchEvt const *)e;
+
+  (void)me;
+  switch (e->sig) {
+    case XL_BATCH_SIG:
+      QFsm_dispatchN(FSM_Mbsda, &be->samples[0].super, be->n, sizeof(XlDataEvt));
+      report(be->now_s);
+      return Q_HANDLED();
+  }
+  return Q_IGNORED();
+}
+
+static void accel_data_handler(AccelData *data, uint32_t num_samples) {
+  uint16_t n = 0;
+  for (uint32_t i = 0; i < num_samples && n < WORKER_SAMPLES_PER_UPDATE; i++) {
+    if (data[i].did_vibrate) {
+      continue;
+    }
+    s_batch.samples[n].timeStamp = (uint32_t)data[i].timestamp;
+    s_batch.samples[n].x = data[i].x;
+    s_batch.samples[n].y = data[i].y;
+    s_batch.samples[n].z = data[i].z;
+    n++;
+  }
+  s_batch.n = n;
+  s_batch.now_s = (uint32_t)(data[num_samples - 1].timestamp / 1000);
+
+  QACTIVE_POST(&s_worker.super, &s_batch.super);
+  QF_run();
+}
+
+static void worker_init(void) {
+  s_batch.super.sig = XL_BATCH_SIG;
+  for (int i = 0; i < WORKER_SAMPLES_PER_UPDATE; i++) {
+    s_batch.samples[i].super.sig = XL_DATA_SIG;
+  }
+
+  // Initialised on the first batch, once it is known whether to resume
+  Mbsda_ctor();
+
+  QF_init();
+  QActive_ctor(&s_worker.super, (QStateHandler)&worker_initial);
+  QActive_start(&s_worker.super, 1, s_worker_queue,
+                sizeof(s_worker_queue) / sizeof(s_worker_queue[0]), (QEvt *)0);
+
+  s_start_s = s_period_start_s = s_ckpt_s = (uint32_t)time(NULL);
+  s_sent.state = MBSDA_STATE_NONE;
+
+  accel_data_service_subscribe(WORKER_SAMPLES_PER_UPDATE, accel_data_handler);
+  set_rate(MBSDA_INPUT_HZ);
+}
+
+static void worker_deinit(void) {
+  accel_data_service_unsubscribe();
+  if (QHsm_state(&s_worker.super) == Q_STATE_CAST(&worker_running)) {
+    ckpt_save();
+  }
+}
+
+int main(void) {
+  worker_init();
+  worker_event_loop();
+  worker_deinit();
+}